@@ -10,17 +10,28 @@
 #   custom          - Target custom board (same as DK for now)
 #   clean/pristine  - Clean build
 #   flash           - Flash after build (J-Link)
+#   production      - Production logging profile (dictionary logging, no per-sample lines)
+#   lean            - Lean router image (firmware/lean.conf: trimmed libc/heap, more ZBOSS buffers)
+#   footprint       - Print the per-module RAM/ROM breakdown after building
+#   test            - Run the sensing tests (firmware/tests) on native_sim instead of building
 #
 # Examples:
 #   ./build.sh              # Build for nrf54l15dk
 #   ./build.sh flash        # Build and flash
 #   ./build.sh clean flash  # Clean build and flash
+#   ./build.sh production   # Build with the production logging profile
+#   ./build.sh lean footprint  # Build the lean image and show where RAM/ROM goes
+#   ./build.sh test         # Replay the ADC traces and state timelines through twister
 
 set -e
 
 BOARD=""
 PRISTINE=""
 DO_FLASH=""
+LOG_PROFILE=""
+EXTRA_CONF=""
+DO_FOOTPRINT=""
+DO_TEST=""
 
 # Parse all arguments - detect board vs options
 for arg in "$@"; do
@@ -31,6 +42,18 @@ for arg in "$@"; do
         flash)
             DO_FLASH="1"
             ;;
+        production)
+            LOG_PROFILE="-DCONFIG_KETTLE_LOG_PRODUCTION=y"
+            ;;
+        lean)
+            EXTRA_CONF="-DEXTRA_CONF_FILE=lean.conf"
+            ;;
+        footprint)
+            DO_FOOTPRINT="1"
+            ;;
+        test)
+            DO_TEST="1"
+            ;;
         nrf54l15dk|custom)
             BOARD="$arg"
             ;;
@@ -90,6 +113,15 @@ if [ ! -f "deps/zephyr/west.yml" ]; then
     west update
 fi
 
+# === Tests ===
+if [ -n "$DO_TEST" ]; then
+    echo "========================================"
+    echo "Running sensing tests on native_sim"
+    echo "========================================"
+    west twister -T firmware/tests -p native_sim -O build/twister --inline-logs
+    exit $?
+fi
+
 # === Build ===
 echo "========================================"
 echo "Building KitchenAid Zigbee Kettle"
@@ -113,6 +145,12 @@ EXTRA_CMAKE_ARGS="-DZEPHYR_NRF_MODULE_DIR=${SCRIPT_DIR}/deps/nrf"
 if [ -n "$SYSBUILD_CONF" ]; then
     EXTRA_CMAKE_ARGS="${EXTRA_CMAKE_ARGS} -DSB_CONF_FILE=${SCRIPT_DIR}/${SYSBUILD_CONF}"
 fi
+if [ -n "$LOG_PROFILE" ]; then
+    EXTRA_CMAKE_ARGS="${EXTRA_CMAKE_ARGS} ${LOG_PROFILE}"
+fi
+if [ -n "$EXTRA_CONF" ]; then
+    EXTRA_CMAKE_ARGS="${EXTRA_CMAKE_ARGS} ${EXTRA_CONF}"
+fi
 west build -b "${BOARD}" -d build firmware ${PRISTINE} \
     -- ${EXTRA_CMAKE_ARGS}
 
@@ -120,6 +158,12 @@ echo "========================================"
 echo "Build complete!"
 echo "========================================"
 
+# === Footprint ===
+if [ -n "$DO_FOOTPRINT" ]; then
+    echo ""
+    cmake --build build/firmware --target kettle_footprint
+fi
+
 # === Flash ===
 if [ -n "$DO_FLASH" ]; then
     echo ""
@@ -136,6 +180,7 @@ else
     echo "Output files in ${SCRIPT_DIR}/build/:"
     echo "  firmware/zephyr/zephyr.hex - Flash via J-Link"
     echo "  merged.hex                  - Combined image"
+    echo "  firmware/z2m/kitchenaid_kettle.js - Zigbee2MQTT converter for this build"
     echo ""
     echo "To flash: ./build.sh flash"
 fi
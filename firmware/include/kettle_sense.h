@@ -0,0 +1,350 @@
+/*
+ * Copyright (c) 2025
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Kettle Sensing
+ *
+ * The parts of the sampling path that need neither ZBOSS nor a driver:
+ * burst order statistics, pulse phase tracking, the ADC code filters, the
+ * code to temperature lookup, the per-sample water channel step, the
+ * sampling interval policy, the heating state transitions and the button
+ * press sequences.
+ * main.c wires them to the SAADC, the GPIOs and the Zigbee attributes;
+ * tests/sense replays synthetic ADC traces and GPIO timelines through them
+ * on native_sim.
+ */
+
+#ifndef KETTLE_SENSE_H
+#define KETTLE_SENSE_H 1
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Temperature ranges (in 0.01°C units for Zigbee) */
+#define TEMP_MIN_CELSIUS        50
+#define TEMP_MAX_CELSIUS        100
+#define TEMP_MIN_ZB             (TEMP_MIN_CELSIUS * 100)   /* 5000 = 50.00°C */
+#define TEMP_MAX_ZB             (TEMP_MAX_CELSIUS * 100)   /* 10000 = 100.00°C */
+#define TEMP_INVALID_ZB         ((int16_t)0x8000)           /* Invalid temperature */
+
+/* ADC configuration */
+#define ADC_RESOLUTION          12
+#define ADC_MAX_VALUE           ((1 << ADC_RESOLUTION) - 1)
+
+/* Adaptive sampling intervals, picked by adc_sample_interval_ms() */
+#define ADC_SAMPLE_INTERVAL_MS  1000    /* Default: idle on base, temperature moving */
+#define ADC_INTERVAL_HEATING_MS 500     /* Heating: ~0.3°C/s rise */
+#define ADC_INTERVAL_IDLE_MS    2000    /* Off, temperature steady */
+#define ADC_INTERVAL_LIFTED_MS  3000    /* Off base (TEMP_INVALID_ZB) */
+#define ADC_INTERVAL_DIAL_MS    200     /* Following the dial while it turns */
+#define ADC_SLOPE_STEADY        2       /* 0.01°C/s; slower than this counts as steady */
+
+/* Water slope EMA: slope = prev + (new - prev) / WATER_SLOPE_COEFF
+ * Higher value = more smoothing, slower response
+ * 4 = moderate smoothing, 8 = heavy smoothing
+ */
+#define WATER_SLOPE_COEFF       4
+
+/* ADC code filters (see ADC Filters), Q16 state */
+#define ADC_FILTER_EMA_SHIFT    2       /* EMA weight 1/4, same time constant as before */
+#define ADC_FILTER_AB_ALPHA_SHIFT 2     /* Alpha-beta position gain 1/4 */
+#define ADC_FILTER_AB_BETA_SHIFT  5     /* Alpha-beta rate gain 1/32, near critical damping */
+
+/* Burst sampling configuration for pulsed signals
+ * The current temperature signal is pulsed at ~50Hz (20ms period).
+ * We sample rapidly and take the minimum to get the true value.
+ */
+#define BURST_SAMPLE_COUNT      80      /* Number of samples in burst */
+#define BURST_SAMPLE_INTERVAL_US 500    /* 0.5ms between samples = 40ms total window */
+#define BURST_PERCENTILE_INDEX  8       /* 10th percentile (8th lowest of 80) */
+
+/* Counting select over the 12-bit ADC range: a coarse histogram on the top
+ * BURST_HIST_BITS bits locates the bin holding each wanted rank, then a
+ * fine histogram on the low bits resolves the exact value inside that bin.
+ */
+#define BURST_HIST_BITS         6
+#define BURST_HIST_BINS         (1 << BURST_HIST_BITS)
+#define BURST_HIST_MASK         (BURST_HIST_BINS - 1)
+
+/* Low-percentile rank scaled to a capture of n samples */
+#define BURST_LOW_RANK(n)       ((n) * BURST_PERCENTILE_INDEX / BURST_SAMPLE_COUNT)
+
+/* Phase-locked acquisition
+ * A full burst spans two pulse periods. From it we learn where the low
+ * phase of the pulse sits, then take only a short capture centred on the
+ * predicted low window. A small PLL trims phase and period from each locked
+ * capture; a full burst is taken again on loss of lock and periodically.
+ */
+#define PHASE_LOCKED_SAMPLE_COUNT 8     /* ~3.5ms capture inside the low window */
+#define PHASE_MIN_LOW_SAMPLES   (PHASE_LOCKED_SAMPLE_COUNT + 2) /* low window must fit the capture */
+#define PHASE_MIN_AMPLITUDE     40      /* ADC counts; below this the signal is flat */
+#define PHASE_PERIOD_50HZ_US    20000
+#define PHASE_PERIOD_60HZ_US    16667
+#define PHASE_PERIOD_TOL_US     1500    /* Accepted deviation from a mains period */
+#define PHASE_START_GUARD_US    2000    /* Lead time when scheduling a locked capture */
+#define PHASE_MAX_COAST_US      (3 * 1000 * 1000) /* Longest prediction without a capture */
+#define PHASE_RELEARN_CYCLES    60      /* Locked captures between full bursts */
+
+/* Kettle heating state machine */
+typedef enum {
+	KETTLE_STATE_OFF,           /* Not heating, idle */
+	KETTLE_STATE_TURNING_ON,    /* Button pressed, waiting for heating to start */
+	KETTLE_STATE_ON,            /* Heating active */
+	KETTLE_STATE_TURNING_OFF,   /* Button pressed, waiting for heating to stop */
+} kettle_state_t;
+
+#define KETTLE_TRANSITION_TIMEOUT_MS 5000 /* Max time to wait for kettle state change */
+
+/* Simulated button presses */
+#define KETTLE_BUTTON_PULSE_MS  200     /* Duration to hold simulated button press */
+#define KETTLE_BUTTON_GAP_MS    200     /* Release time between presses of a sequence */
+#define KETTLE_BUTTON_SEQ_MAX   7       /* Max press/gap steps in one sequence */
+
+/* Press sequence played on the button line, see button_seq_step() */
+struct button_seq {
+	uint16_t steps[KETTLE_BUTTON_SEQ_MAX];  /* ms, alternating press, gap, press, ... */
+	uint8_t count;
+	uint8_t next;               /* next step to start */
+};
+
+/* Order statistics of a burst, as returned by burst_select() */
+struct burst_stats {
+	int16_t min;
+	int16_t low;        /* low percentile (rank passed to burst_select) */
+	int16_t median;
+	int16_t max;
+};
+
+/* Pulse phase tracking state of one water channel. Times are microseconds
+ * on a free-running 32-bit clock; only differences are used, so it may wrap.
+ */
+struct burst_phase {
+	bool     locked;
+	uint8_t  locked_cycles;     /* locked captures since the last full burst */
+	uint32_t interval_us;       /* measured conversion spacing */
+	uint32_t period_us;         /* 0 = flat signal, any phase reads the level */
+	uint32_t ref_us;            /* centre of a low window */
+	uint32_t expected_us;       /* predicted low window centre of the capture */
+	uint32_t expected_periods;  /* periods between ref_us and expected_us */
+	int16_t  amplitude;         /* pulse height above the low level */
+	int16_t  threshold;         /* low/high classification threshold */
+	int16_t  hysteresis;
+};
+
+/* Per-channel ADC code filter, picked by CONFIG_KETTLE_FILTER_DIAL/_WATER */
+enum adc_filter_kind {
+	ADC_FILTER_EMA,             /* shift EMA with a fractional accumulator */
+	ADC_FILTER_MEDIAN_EMA,      /* median-of-3 pre-filter, then EMA */
+	ADC_FILTER_ALPHA_BETA,      /* steady-state Kalman, constant heating rate model */
+};
+
+struct adc_filter {
+	uint8_t kind;               /* enum adc_filter_kind */
+	uint8_t count;              /* samples since reset, saturates at 3 */
+	int16_t recent[2];          /* last raw codes, for the median */
+	int32_t x_q16;              /* filtered code, Q16 */
+	int32_t v_q16;              /* alpha-beta: rate, codes per second, Q16 */
+	int64_t last_ms;            /* alpha-beta: uptime of the last sample */
+};
+
+/* Code to temperature tables in use: built-in, or per-unit after a field
+ * calibration. Both hold ADC_MAX_VALUE + 1 entries.
+ */
+struct kettle_temp_tables {
+	const int16_t *target;      /* dial code to setpoint */
+	const int16_t *current;     /* water NTC code to temperature */
+};
+
+/* Water NTC channel of one kettle, fed one burst reading per sampling cycle */
+struct water_channel {
+	int16_t off_base_code;      /* lowest code with the kettle on its base */
+	struct adc_filter filter;   /* filtered water NTC code */
+	int64_t last_temp_ms;       /* time of last_temp, 0 = none */
+	int16_t last_temp;          /* last valid water temperature (0.01°C) */
+	int16_t slope;              /* smoothed temperature slope (0.01°C/s) */
+};
+
+/* Outcome of water_channel_update() */
+enum water_status {
+	WATER_OFF_BASE,             /* kettle lifted: filter and slope restarted */
+	WATER_INVALID,              /* on base, but the code reads no temperature */
+	WATER_VALID,
+};
+
+/**
+ * Compute min, low percentile, median and max of a burst without sorting.
+ *
+ * @param samples Raw ADC samples (negative values clamp to 0)
+ * @param count Number of samples (1..BURST_SAMPLE_COUNT)
+ * @param low_rank Zero-based rank of the low percentile
+ * @param stats Output statistics
+ */
+void burst_select(const int16_t *samples, uint8_t count, uint8_t low_rank,
+		  struct burst_stats *stats);
+
+/**
+ * Learn the pulse phase from a full burst.
+ *
+ * The burst covers two periods, so it holds at least one complete low run
+ * between a falling and a rising edge. The period is measured between
+ * same-direction edges and snapped to the mains period the pulse is derived
+ * from, since one-sample quantisation would otherwise put the prediction
+ * off by a whole low window within a second. A flat burst locks without a
+ * period: any phase then reads the true level.
+ *
+ * @param phase Phase state of the channel the burst belongs to
+ * @param samples The channel's BURST_SAMPLE_COUNT conversions
+ * @param stats Statistics of the full burst
+ * @param first_us Time of the first conversion
+ * @param interval_us Measured spacing of the conversions
+ */
+void burst_phase_learn(struct burst_phase *phase, const int16_t *samples,
+		       const struct burst_stats *stats, uint32_t first_us, uint32_t interval_us);
+
+/**
+ * Predict the next low window far enough ahead to schedule a capture in.
+ *
+ * @param phase Locked phase state
+ * @param now_us Current time
+ * @return Delay until the locked capture should start in microseconds,
+ *         or -EAGAIN if the prediction has coasted too long to trust
+ */
+int32_t burst_phase_schedule(struct burst_phase *phase, uint32_t now_us);
+
+/**
+ * Evaluate a locked capture and update the phase estimate.
+ *
+ * If part of the capture hit a pulse, the centroid of the low samples gives
+ * the phase error: the reference is moved onto it and half the error per
+ * elapsed period is folded into the period. Too few low samples, or any high
+ * sample on a signal locked as flat, means the lock is gone.
+ *
+ * @param phase Phase state the capture was scheduled from
+ * @param samples The channel's PHASE_LOCKED_SAMPLE_COUNT conversions
+ * @param first_us Time of the first conversion
+ * @param interval_us Measured spacing of the conversions
+ * @param adc Output low-percentile ADC value
+ * @return 0 on success, -EAGAIN if the lock was lost
+ */
+int burst_phase_track(struct burst_phase *phase, const int16_t *samples,
+		      uint32_t first_us, uint32_t interval_us, int16_t *adc);
+
+/** Forget a filter's history; the next sample starts it afresh */
+void adc_filter_reset(struct adc_filter *f);
+
+/** Filtered code rounded to an integer, or -1 before the first sample */
+int32_t adc_filter_value(const struct adc_filter *f);
+
+/**
+ * Feed one raw code through a channel's filter.
+ *
+ * @param f Channel filter
+ * @param code Raw ADC code (clamped to 0..ADC_MAX_VALUE)
+ * @param now_ms Sample uptime, for the alpha-beta rate
+ * @return Filtered code
+ */
+int16_t adc_filter_update(struct adc_filter *f, int16_t code, int64_t now_ms);
+
+/** Dial code to setpoint, in 0.01°C */
+int16_t adc_to_target_temp(const struct kettle_temp_tables *tables, int16_t adc_val);
+
+/** Water NTC code to temperature in 0.01°C, TEMP_INVALID_ZB off base */
+int16_t adc_to_current_temp(const struct kettle_temp_tables *tables, int16_t adc_val);
+
+/**
+ * Take one burst reading through the water channel.
+ *
+ * Below the off-base code the kettle is lifted: the filter and the slope
+ * start over, so the reading after it is set back down is not dragged by
+ * the old level. Otherwise the code is filtered and converted, and a valid
+ * temperature updates the smoothed slope.
+ *
+ * @param ch Water channel
+ * @param tables Tables in use
+ * @param burst_code Low-percentile code of the burst
+ * @param now_ms Sample uptime
+ * @param code Filtered code, left alone off base
+ * @param temp Temperature in 0.01°C, TEMP_INVALID_ZB unless WATER_VALID
+ * @return Outcome of the reading
+ */
+enum water_status water_channel_update(struct water_channel *ch,
+				       const struct kettle_temp_tables *tables,
+				       int16_t burst_code, int64_t now_ms,
+				       int16_t *code, int16_t *temp);
+
+/**
+ * Pick the delay to the next sampling cycle.
+ *
+ * @param dial_active The dial moved within the last ADC_DIAL_ACTIVE_MS
+ * @param state Heating state
+ * @param water_temp Last reported water temperature, 0.01°C
+ * @param slope Water temperature slope, 0.01°C/s
+ * @return Interval in milliseconds
+ */
+uint32_t adc_sample_interval_ms(bool dial_active, kettle_state_t state,
+				int16_t water_temp, int32_t slope);
+
+/** State name for logging */
+const char *kettle_state_name(kettle_state_t state);
+
+/**
+ * State after sampling the heating GPIO.
+ *
+ * Settled states follow the element; pending states complete when it
+ * reaches the commanded level and otherwise wait for their timeout.
+ *
+ * @param state Current state
+ * @param gpio_heating Heating state input
+ * @return Next state, possibly unchanged
+ */
+kettle_state_t kettle_state_next(kettle_state_t state, bool gpio_heating);
+
+/**
+ * State after a pending transition timed out.
+ *
+ * A turn-on the kettle did not act on (no water, lifted) drops back to
+ * OFF; a turn-off settles on whatever the element is doing.
+ *
+ * @param state Current state
+ * @param gpio_heating Heating state input
+ * @return Next state, unchanged if @p state was not pending
+ */
+kettle_state_t kettle_state_timeout(kettle_state_t state, bool gpio_heating);
+
+/**
+ * Pending state a turn on/off command moves to.
+ *
+ * @param state Current state
+ * @param on Requested heating
+ * @return TURNING_ON/TURNING_OFF if the button must be pressed, or @p state
+ *         if the kettle is already there or on its way
+ */
+kettle_state_t kettle_state_command(kettle_state_t state, bool on);
+
+/**
+ * Load a press sequence.
+ *
+ * @param seq Sequence to (re)start
+ * @param steps Durations in ms alternating press/gap, starting and ending
+ *              with a press (odd count), e.g. {200, 200, 200} for a
+ *              double press
+ * @param count Number of steps, at most KETTLE_BUTTON_SEQ_MAX
+ * @return 0 on success, -EINVAL on a malformed sequence (@p seq untouched)
+ */
+int button_seq_load(struct button_seq *seq, const uint16_t *steps, uint8_t count);
+
+/**
+ * Start the next step of a press sequence.
+ *
+ * Called at the start of the sequence and at each step's end. Once every
+ * step has run the line is left released.
+ *
+ * @param seq Loaded sequence
+ * @param pressed Set to the line level for this step
+ * @param hold_ms Set to how long to hold it
+ * @return true if a step was started, false once the sequence has ended
+ */
+bool button_seq_step(struct button_seq *seq, bool *pressed, uint32_t *hold_ms);
+
+#endif /* KETTLE_SENSE_H */
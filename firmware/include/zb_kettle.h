@@ -10,8 +10,12 @@
  * - Identify Cluster (0x0003) - Device identification
  * - Groups Cluster (0x0004) - Group membership
  * - On/Off Cluster (0x0006) - Kettle power state (read-only reporting)
- * - Thermostat Cluster (0x0201) - Target temperature setpoint
+ * - Thermostat Cluster (0x0201) - Target temperature setpoint, plus a
+ *   manufacturer-specific time-to-setpoint estimate
  * - Temperature Measurement Cluster (0x0402) - Current water temperature
+ * - Kettle Cluster (0xFC00) - Manufacturer-specific field calibration,
+ *   water ready state, history readout and telemetry stream
+ * - Diagnostics Cluster (0xFC01) - Manufacturer-specific timing histograms
  */
 
 #ifndef ZB_KETTLE_H
@@ -25,11 +29,115 @@
  */
 #define ZB_KETTLE_DEVICE_ID 0x0301  /* Thermostat device */
 
+/**
+ * Manufacturer code for the kettle's manufacturer-specific attributes
+ * (CONFIG_KETTLE_MANUF_CODE; the default is a placeholder)
+ */
+#define ZB_KETTLE_MANUF_CODE CONFIG_KETTLE_MANUF_CODE
+
+/**
+ * Thermostat cluster: estimated seconds until the water reaches the
+ * setpoint (U16, 0xFFFF = unknown). Manufacturer-specific.
+ */
+#define ZB_ZCL_ATTR_THERMOSTAT_KETTLE_TIME_TO_SETPOINT_ID 0x4000
+
+/**
+ * Kettle cluster (manufacturer-specific): per-unit calibration of the
+ * water NTC and the target dial
+ */
+#define ZB_ZCL_CLUSTER_ID_KETTLE 0xFC00
+#define ZB_ZCL_KETTLE_CLUSTER_REVISION_DEFAULT ((zb_uint16_t)0x0001u)
+
+/* Kettle cluster attributes */
+#define ZB_ZCL_ATTR_KETTLE_CALIBRATION_STATE_ID  0x0000  /* ENUM8, ZB_KETTLE_CAL_STATE_* */
+#define ZB_ZCL_ATTR_KETTLE_CALIBRATION_POINTS_ID 0x0001  /* BITMAP8, BIT(ZB_KETTLE_CAL_POINT_*) applied */
+#define ZB_ZCL_ATTR_KETTLE_AMBIENT_REFERENCE_ID  0x0002  /* S16 0.01°C, ambient point reference */
+#define ZB_ZCL_ATTR_KETTLE_BOIL_REFERENCE_ID     0x0003  /* S16 0.01°C, boil point reference */
+#define ZB_ZCL_ATTR_KETTLE_WATER_READY_ID        0x0004  /* ENUM8, ZB_KETTLE_READY_*, reported */
+#define ZB_ZCL_ATTR_KETTLE_STREAM_INTERVAL_ID    0x0005  /* U16 seconds between stream frames, 0 = off */
+#define ZB_ZCL_ATTR_KETTLE_HEATING_STATE_ID      0x0006  /* ENUM8, ZB_KETTLE_HEATING_*, reported */
+
+/* Kettle cluster commands (client to server) */
+#define ZB_ZCL_CMD_KETTLE_CALIBRATION_START      0x00
+#define ZB_ZCL_CMD_KETTLE_CALIBRATION_CAPTURE    0x01  /* U8 point, S16 reference (0x8000 = attribute) */
+#define ZB_ZCL_CMD_KETTLE_CALIBRATION_FINISH     0x02  /* Refit, apply and persist */
+#define ZB_ZCL_CMD_KETTLE_CALIBRATION_CANCEL     0x03
+#define ZB_ZCL_CMD_KETTLE_CALIBRATION_RESET      0x04  /* Back to the built-in tables */
+#define ZB_ZCL_CMD_KETTLE_HISTORY_READ           0x05  /* U32 position (0 = oldest) */
+
+/* Kettle cluster commands (server to client) */
+#define ZB_ZCL_CMD_KETTLE_HISTORY_DATA           0x00  /* Response to History Read */
+#define ZB_ZCL_CMD_KETTLE_STREAM_DATA            0x01  /* Telemetry stream batch, unsolicited */
+
+/* Stream interval attribute limit (seconds) */
+#define ZB_KETTLE_STREAM_INTERVAL_MAX            60
+
+/* Calibration state attribute values */
+#define ZB_KETTLE_CAL_STATE_IDLE                 0
+#define ZB_KETTLE_CAL_STATE_ACTIVE               1
+
+/* Water ready attribute values */
+#define ZB_KETTLE_READY_NONE                     0
+#define ZB_KETTLE_READY_SETPOINT                 1  /* Reached the dial setpoint */
+#define ZB_KETTLE_READY_BOILING                  2  /* Boiling (setpoint 99°C and up) */
+
+/* Heating state attribute values (On/Off follows the GPIO, this adds the pending states) */
+#define ZB_KETTLE_HEATING_OFF                    0
+#define ZB_KETTLE_HEATING_STARTING               1  /* Button pulsed, waiting for the element */
+#define ZB_KETTLE_HEATING_ON                     2
+#define ZB_KETTLE_HEATING_STOPPING               3  /* Button pulsed, waiting for the element to stop */
+
+/* Calibration points */
+#define ZB_KETTLE_CAL_POINT_AMBIENT              0  /* Water NTC at ambient */
+#define ZB_KETTLE_CAL_POINT_BOIL                 1  /* Water NTC at boiling */
+#define ZB_KETTLE_CAL_POINT_DIAL_MAX             2  /* Dial at its 100°C end stop */
+#define ZB_KETTLE_CAL_POINT_DIAL_MIN             3  /* Dial at its 50°C end stop */
+#define ZB_KETTLE_CAL_POINT_COUNT                4
+
+void zb_zcl_kettle_init_server(void);
+#define ZB_ZCL_CLUSTER_ID_KETTLE_SERVER_ROLE_INIT zb_zcl_kettle_init_server
+#define ZB_ZCL_CLUSTER_ID_KETTLE_CLIENT_ROLE_INIT ((zb_zcl_cluster_init_t)NULL)
+
+/** Diagnostics cluster (manufacturer-specific): hot path timing histograms */
+#define ZB_ZCL_CLUSTER_ID_KETTLE_DIAGNOSTICS 0xFC01
+#define ZB_ZCL_KETTLE_DIAGNOSTICS_CLUSTER_REVISION_DEFAULT ((zb_uint16_t)0x0001u)
+
+/* Diagnostics cluster attributes, OCTET_STRING: U32 max us, 16 x U16 log2 buckets */
+#define ZB_ZCL_ATTR_KETTLE_DIAG_BURST_ID              0x0000  /* Burst capture to reading */
+#define ZB_ZCL_ATTR_KETTLE_DIAG_UPDATE_TEMPS_ID       0x0001  /* Temperature update run time */
+#define ZB_ZCL_ATTR_KETTLE_DIAG_WORKQUEUE_LATENCY_ID  0x0002  /* Sampling work lateness */
+#define ZB_ZCL_ATTR_KETTLE_DIAG_EDGE_TO_REPORT_ID     0x0003  /* State edge to On/Off report */
+#define ZB_ZCL_ATTR_KETTLE_DIAG_BUFFER_ACQUIRE_ID     0x0004  /* ZBOSS buffer allocation */
+#define ZB_ZCL_ATTR_KETTLE_DIAG_APS_RTT_ID            0x0005  /* Report to APS ACK */
+
+/* Diagnostics cluster attributes: buffer pool and routing load counters */
+#define ZB_ZCL_ATTR_KETTLE_DIAG_ALLOC_FAILURES_ID     0x0010  /* U32, report frames with no buffer */
+#define ZB_ZCL_ATTR_KETTLE_DIAG_RETRIED_ID            0x0011  /* U32, report frames sent after backoff */
+#define ZB_ZCL_ATTR_KETTLE_DIAG_DEFERRED_ID           0x0012  /* U32, deferred by buffer pressure */
+#define ZB_ZCL_ATTR_KETTLE_DIAG_DROPPED_ID            0x0013  /* U32, changes dropped after retries */
+#define ZB_ZCL_ATTR_KETTLE_DIAG_APS_FAILURES_ID       0x0014  /* U32, frames without APS ACK */
+#define ZB_ZCL_ATTR_KETTLE_DIAG_POOL_LOW_ID           0x0015  /* U32, flush passes with the pool low */
+#define ZB_ZCL_ATTR_KETTLE_DIAG_POOL_OOM_ID           0x0016  /* U32, flush passes with the pool empty */
+#define ZB_ZCL_ATTR_KETTLE_DIAG_IN_FLIGHT_MAX_ID      0x0017  /* U8, most own frames awaiting ACK */
+
+/* Diagnostics cluster attributes: OTA image download (zero without CONFIG_ZIGBEE_FOTA) */
+#define ZB_ZCL_ATTR_KETTLE_DIAG_OTA_PROGRESS_ID       0x0020  /* U8, percent of the image received */
+#define ZB_ZCL_ATTR_KETTLE_DIAG_OTA_OFFSET_ID         0x0021  /* U32, image bytes received */
+#define ZB_ZCL_ATTR_KETTLE_DIAG_OTA_THROUGHPUT_ID     0x0022  /* U16, bytes/s since the download started */
+#define ZB_ZCL_ATTR_KETTLE_DIAG_OTA_BLOCK_PERIOD_ID   0x0023  /* U16, ms between block requests */
+
+/* Diagnostics cluster commands (client to server) */
+#define ZB_ZCL_CMD_KETTLE_DIAG_RESET                  0x00  /* Clear histograms and counters */
+
+void zb_zcl_kettle_diag_init_server(void);
+#define ZB_ZCL_CLUSTER_ID_KETTLE_DIAGNOSTICS_SERVER_ROLE_INIT zb_zcl_kettle_diag_init_server
+#define ZB_ZCL_CLUSTER_ID_KETTLE_DIAGNOSTICS_CLIENT_ROLE_INIT ((zb_zcl_cluster_init_t)NULL)
+
 /** Kettle device version */
 #define ZB_DEVICE_VER_KETTLE 1
 
 /** Kettle IN (server) clusters number */
-#define ZB_KETTLE_IN_CLUSTER_NUM 6
+#define ZB_KETTLE_IN_CLUSTER_NUM 8
 
 /** Kettle OUT (client) clusters number */
 #define ZB_KETTLE_OUT_CLUSTER_NUM 0
@@ -41,10 +149,11 @@
 /** Number of attributes for reporting
  * Increased to handle all reportable attributes:
  * - temp_measurement value
- * - thermostat local_temp
+ * - thermostat local_temp (unless CONFIG_KETTLE_LOCAL_TEMP_ALIAS)
  * - thermostat occupied_heating_setpoint
  * - on_off state
  * - thermostat system_mode
+ * - thermostat time_to_setpoint
  * Plus spare slots for stack-initiated reports
  */
 #define ZB_KETTLE_REPORT_ATTR_COUNT 8
@@ -59,7 +168,9 @@
 	groups_attr_list,						\
 	on_off_attr_list,						\
 	thermostat_attr_list,						\
-	temp_measurement_attr_list)					\
+	temp_measurement_attr_list,					\
+	kettle_attr_list,						\
+	diag_attr_list)							\
 	zb_zcl_cluster_desc_t cluster_list_name[] =			\
 	{								\
 		ZB_ZCL_CLUSTER_DESC(					\
@@ -103,14 +214,37 @@
 			(temp_measurement_attr_list),			\
 			ZB_ZCL_CLUSTER_SERVER_ROLE,			\
 			ZB_ZCL_MANUF_CODE_INVALID			\
+		),							\
+		ZB_ZCL_CLUSTER_DESC(					\
+			ZB_ZCL_CLUSTER_ID_KETTLE,			\
+			ZB_ZCL_ARRAY_SIZE(kettle_attr_list, zb_zcl_attr_t), \
+			(kettle_attr_list),				\
+			ZB_ZCL_CLUSTER_SERVER_ROLE,			\
+			ZB_KETTLE_MANUF_CODE				\
+		),							\
+		ZB_ZCL_CLUSTER_DESC(					\
+			ZB_ZCL_CLUSTER_ID_KETTLE_DIAGNOSTICS,		\
+			ZB_ZCL_ARRAY_SIZE(diag_attr_list, zb_zcl_attr_t), \
+			(diag_attr_list),				\
+			ZB_ZCL_CLUSTER_SERVER_ROLE,			\
+			ZB_KETTLE_MANUF_CODE				\
 		)							\
 	}
 
+/**
+ * @brief Declare the simple descriptor type of the Kettle device
+ *
+ * Once per translation unit, with ZB_KETTLE_IN_CLUSTER_NUM and
+ * ZB_KETTLE_OUT_CLUSTER_NUM, before the first ZB_DECLARE_KETTLE_EP(): the
+ * type is shared by every kettle endpoint.
+ */
+#define ZB_DECLARE_KETTLE_SIMPLE_DESC_TYPE(in_clust_num, out_clust_num)	\
+	ZB_DECLARE_SIMPLE_DESC(in_clust_num, out_clust_num)
+
 /**
  * @brief Declare simple descriptor for Kettle device
  */
 #define ZB_ZCL_DECLARE_KETTLE_SIMPLE_DESC(ep_name, ep_id, in_clust_num, out_clust_num) \
-	ZB_DECLARE_SIMPLE_DESC(in_clust_num, out_clust_num);				\
 	ZB_AF_SIMPLE_DESC_TYPE(in_clust_num, out_clust_num) simple_desc_##ep_name =	\
 	{										\
 		ep_id,									\
@@ -127,11 +261,15 @@
 			ZB_ZCL_CLUSTER_ID_ON_OFF,					\
 			ZB_ZCL_CLUSTER_ID_THERMOSTAT,					\
 			ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT,				\
+			ZB_ZCL_CLUSTER_ID_KETTLE,					\
+			ZB_ZCL_CLUSTER_ID_KETTLE_DIAGNOSTICS,				\
 		}									\
 	}
 
 /**
  * @brief Declare endpoint for Kettle device
+ *
+ * Needs ZB_DECLARE_KETTLE_SIMPLE_DESC_TYPE() earlier in the file.
  */
 #define ZB_DECLARE_KETTLE_EP(ep_name, ep_id, cluster_list)			\
 	ZB_ZCL_DECLARE_KETTLE_SIMPLE_DESC(ep_name, ep_id,			\
@@ -0,0 +1,26 @@
+/*
+ * Copyright (c) 2025
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * ZBOSS memory configuration for the lean router image (CONFIG_KETTLE_LEAN)
+ */
+
+#ifndef ZB_MEM_CONFIG_KETTLE_H
+#define ZB_MEM_CONFIG_KETTLE_H 1
+
+/*
+ * Same traffic profile as zb_mem_config_max.h, with network tables sized
+ * for a home mesh and the RAM they free spent on the buffer pool, which
+ * holds frames the router forwards as well as its own reports.
+ */
+#define ZB_CONFIG_OVERALL_NETWORK_SIZE CONFIG_KETTLE_ZB_NETWORK_SIZE
+#define ZB_CONFIG_HIGH_TRAFFIC
+#define ZB_CONFIG_APPLICATION_COMPLEX
+
+#include "zb_mem_config_common.h"
+
+#undef ZB_CONFIG_IOBUF_POOL_SIZE
+#define ZB_CONFIG_IOBUF_POOL_SIZE CONFIG_KETTLE_ZB_IOBUF_POOL_SIZE
+
+#endif /* ZB_MEM_CONFIG_KETTLE_H */
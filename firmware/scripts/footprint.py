@@ -0,0 +1,153 @@
+#!/usr/bin/env python3
+#
+# Per-module RAM/ROM breakdown of the firmware image
+#
+# SPDX-License-Identifier: Apache-2.0
+#
+"""Summarise zephyr.map into a per-module RAM/ROM table.
+
+Every input section the linker placed in the image is charged to the
+library it came from (libapp.a is the application, libzboss*.a the
+Zigbee stack, libdrivers__adc.a the ADC driver, libc.a the C library),
+so the cost of a Kconfig change shows up next to the module it touches.
+Initialised data counts against both RAM and ROM (its load image lives
+in flash); .bss and .noinit against RAM only.
+
+Usage: footprint.py [--objects] [--top N] build/firmware/zephyr/zephyr.map
+"""
+
+import argparse
+import os
+import re
+import sys
+from collections import defaultdict
+
+SECTION_ONLY = re.compile(r"^ (\.\S+|COMMON)$")
+SECTION_LINE = re.compile(r"^ (\.\S+|COMMON)\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(\S.*)$")
+CONTINUATION = re.compile(r"^\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(\S.*)$")
+REGION_LINE = re.compile(r"^(\S+)\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s*(\S*)$")
+ARCHIVE_MEMBER = re.compile(r"^(.*?)\((.*)\)$")
+
+# Pseudo regions the linker script defines but never loads
+SKIP_REGIONS = {"IDT_LIST", "*default*"}
+
+# Not part of the image
+SKIP_SECTIONS = (".debug", ".comment", ".ARM.attributes", ".stab", ".note")
+
+
+def parse_regions(lines):
+    """Memory Configuration table: name -> (origin, end, writable)."""
+    regions = {}
+    in_table = False
+    for line in lines:
+        if line.startswith("Memory Configuration"):
+            in_table = True
+            continue
+        if in_table and line.startswith("Linker script and memory map"):
+            break
+        m = REGION_LINE.match(line) if in_table else None
+        if m and m.group(1) not in SKIP_REGIONS:
+            origin, length = int(m.group(2), 16), int(m.group(3), 16)
+            regions[m.group(1)] = (origin, origin + length, "w" in m.group(4))
+    return regions
+
+
+def input_sections(lines):
+    """Yield (section, address, size, file) for each placed input section."""
+    in_map = False
+    pending = None
+    for line in lines:
+        if line.startswith("Linker script and memory map"):
+            in_map = True
+            continue
+        if not in_map:
+            continue
+        if pending:
+            m = CONTINUATION.match(line)
+            if m:
+                yield pending, int(m.group(1), 16), int(m.group(2), 16), m.group(3)
+            pending = None
+            continue
+        m = SECTION_LINE.match(line)
+        if m:
+            yield m.group(1), int(m.group(2), 16), int(m.group(3), 16), m.group(4)
+            continue
+        m = SECTION_ONLY.match(line)
+        if m:
+            pending = m.group(1)
+
+
+def module_name(path, objects):
+    """libdrivers__adc.a(adc_nrfx_saadc.c.obj) -> drivers/adc"""
+    m = ARCHIVE_MEMBER.match(path)
+    archive, member = (m.group(1), m.group(2)) if m else (None, path)
+    if archive is None or objects:
+        name = os.path.basename(member)
+        return name if archive is None else "{}:{}".format(module_name(archive, False), name)
+    name = os.path.basename(archive)
+    if name.startswith("lib"):
+        name = name[3:]
+    if name.endswith(".a"):
+        name = name[:-2]
+    return name.replace("__", "/")
+
+
+def is_zero_init(section):
+    return section.startswith((".bss", ".noinit", "COMMON", ".tbss")) or ".noinit" in section
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("map", help="linker map file (zephyr.map)")
+    parser.add_argument("--objects", action="store_true",
+                        help="break modules down by object file")
+    parser.add_argument("--top", type=int, default=30,
+                        help="modules to list, largest ROM + RAM first (default: 30)")
+    args = parser.parse_args()
+
+    with open(args.map) as f:
+        lines = f.read().splitlines()
+
+    regions = parse_regions(lines)
+    if not regions:
+        sys.exit("{}: no Memory Configuration table".format(args.map))
+
+    rom = defaultdict(int)
+    ram = defaultdict(int)
+    used = defaultdict(int)
+    for section, addr, size, path in input_sections(lines):
+        if size == 0 or section.startswith(SKIP_SECTIONS):
+            continue
+        region = next((name for name, (lo, hi, _) in regions.items() if lo <= addr < hi), None)
+        if region is None:
+            continue
+        used[region] += size
+        module = module_name(path, args.objects)
+        if not regions[region][2]:
+            rom[module] += size
+        else:
+            ram[module] += size
+            if not is_zero_init(section):
+                rom[module] += size
+
+    modules = sorted(set(rom) | set(ram), key=lambda k: rom[k] + ram[k], reverse=True)
+    width = max([len("Module")] + [len(k) for k in modules[:args.top]])
+    print("{:<{w}} {:>9} {:>9}".format("Module", "ROM", "RAM", w=width))
+    for module in modules[:args.top]:
+        print("{:<{w}} {:>9} {:>9}".format(module, rom[module], ram[module], w=width))
+    rest = modules[args.top:]
+    if rest:
+        print("{:<{w}} {:>9} {:>9}".format("({} more)".format(len(rest)),
+                                            sum(rom[k] for k in rest),
+                                            sum(ram[k] for k in rest), w=width))
+    print("{:<{w}} {:>9} {:>9}".format("Total", sum(rom.values()), sum(ram.values()), w=width))
+    print()
+    for name, (lo, hi, _) in regions.items():
+        if used[name]:
+            print("{}: {} of {} bytes ({:.1f}%)".format(name, used[name], hi - lo,
+                                                       100.0 * used[name] / (hi - lo)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+#
+# Generate the ADC code to temperature lookup tables
+#
+# SPDX-License-Identifier: Apache-2.0
+#
+"""Generate kettle_temp_lut.h from a calibration file.
+
+Maps every ADC code to a Zigbee temperature (0.01 C) for both the target
+dial and the water NTC, so the firmware converts with a single array
+lookup. The arithmetic mirrors the integer math the firmware used at run
+time (truncating mV conversion, truncating interpolation), so regenerating
+from the same points yields identical readings.
+
+Usage: gen_temp_lut.py --output kettle_temp_lut.h calibration.json
+"""
+
+import argparse
+import json
+import os
+import sys
+
+TEMP_INVALID_ZB = -0x8000
+
+
+def cdiv(a, b):
+    """C integer division (truncates toward zero)."""
+    q = abs(a) // abs(b)
+    return q if (a >= 0) == (b >= 0) else -q
+
+
+def interpolate(points, mv, i):
+    (v0, t0), (v1, t1) = points[i], points[i + 1]
+    return t0 + cdiv((t1 - t0) * (mv - v0), v1 - v0)
+
+
+def lookup(points, mv):
+    """Piecewise linear, clamped to the last point above the table."""
+    for i in range(len(points) - 1):
+        if mv <= points[i + 1][0]:
+            return interpolate(points, mv, i)
+    return points[-1][1]
+
+
+def check_points(name, points):
+    if len(points) < 2:
+        sys.exit(f"{name}: need at least two calibration points")
+    for (v0, _), (v1, _) in zip(points, points[1:]):
+        if v1 <= v0:
+            sys.exit(f"{name}: voltages must be strictly increasing ({v0} -> {v1})")
+    for _, t in points:
+        if not -0x7FFF <= t <= 0x7FFF:
+            sys.exit(f"{name}: temperature {t} does not fit int16")
+
+
+def build_tables(cal):
+    adc = cal["adc"]
+    codes = 1 << adc["resolution"]
+    max_code = codes - 1
+
+    def orig_mv(code):
+        return code * adc["full_scale_mv"] // max_code * adc["divider_ratio"]
+
+    target = [[int(v), int(t)] for v, t in cal["target"]["points"]]
+    current = [[int(v), int(t)] for v, t in cal["current"]["points"]]
+    check_points("target", target)
+    check_points("current", current)
+
+    min_code = cal["current"]["min_code"]
+    off_base_mv = cal["current"]["off_base_mv"]
+
+    target_lut = [lookup(target, orig_mv(c)) for c in range(codes)]
+
+    current_lut = []
+    for c in range(codes):
+        mv = orig_mv(c)
+        if c < min_code or mv < off_base_mv:
+            current_lut.append(TEMP_INVALID_ZB)
+        elif mv < current[0][0]:
+            # Extrapolate below the first point, floored at 0 C
+            current_lut.append(max(interpolate(current, mv, 0), 0))
+        else:
+            current_lut.append(lookup(current, mv))
+
+    off_base_code = next((c for c in range(codes) if orig_mv(c) >= off_base_mv), codes)
+
+    return codes, off_base_code, target_lut, current_lut
+
+
+def format_table(name, values, codes):
+    lines = [f"static const int16_t {name}[KETTLE_TEMP_LUT_CODES] = {{"]
+    for base in range(0, codes, 8):
+        row = ", ".join(f"{v:6d}" for v in values[base:base + 8])
+        lines.append(f"\t{row},  /* {base:4d} */")
+    lines.append("};")
+    return "\n".join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("calibration", help="calibration JSON file")
+    parser.add_argument("--output", required=True, help="header to write")
+    args = parser.parse_args()
+
+    with open(args.calibration) as f:
+        cal = json.load(f)
+
+    codes, off_base_code, target_lut, current_lut = build_tables(cal)
+    adc = cal["adc"]
+
+    header = f"""/*
+ * Generated by scripts/gen_temp_lut.py from {os.path.basename(args.calibration)}
+ * Do not edit - change the calibration points and rebuild.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef KETTLE_TEMP_LUT_H
+#define KETTLE_TEMP_LUT_H
+
+#include <stdint.h>
+
+/* ADC front end the tables were generated for */
+#define KETTLE_TEMP_LUT_CODES           {codes}
+#define KETTLE_TEMP_LUT_FULL_SCALE_MV   {adc["full_scale_mv"]}
+#define KETTLE_TEMP_LUT_DIVIDER_RATIO   {adc["divider_ratio"]}
+
+/* Lowest water NTC code with the kettle on its base ({cal["current"]["off_base_mv"]}mV before divider) */
+#define KETTLE_OFF_BASE_CODE            {off_base_code}
+
+/* Target dial: ADC code -> setpoint (0.01 C) */
+{format_table("kettle_target_temp_lut", target_lut, codes)}
+
+/* Water NTC: ADC code -> temperature (0.01 C), TEMP_INVALID_ZB off base */
+{format_table("kettle_current_temp_lut", current_lut, codes)}
+
+#endif /* KETTLE_TEMP_LUT_H */
+"""
+
+    os.makedirs(os.path.dirname(os.path.abspath(args.output)), exist_ok=True)
+    with open(args.output, "w") as f:
+        f.write(header)
+
+
+if __name__ == "__main__":
+    main()
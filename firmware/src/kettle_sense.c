@@ -0,0 +1,542 @@
+/**
+ * @file kettle_sense.c
+ * @brief Kettle sensing: burst statistics, phase tracking, filters, conversion and state
+ *
+ * Pure functions of their arguments, no ZBOSS, drivers or kernel objects,
+ * so the same code runs on the kettle and under tests/sense on native_sim.
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include <zephyr/toolchain.h>
+#include <zephyr/sys/util.h>
+
+#include "kettle_sense.h"
+
+/* ==========================================================================
+ * Burst Statistics
+ * ========================================================================== */
+
+BUILD_ASSERT(2 * BURST_HIST_BITS == ADC_RESOLUTION,
+	     "Two histogram levels must cover the ADC resolution");
+BUILD_ASSERT(BURST_SAMPLE_COUNT <= UINT8_MAX,
+	     "Histogram bins are 8-bit counters");
+
+/**
+ * Find the histogram bin containing the sample of the given rank.
+ *
+ * @param hist Histogram to walk
+ * @param rank Zero-based rank; on return, the rank within the found bin
+ * @return Index of the bin holding that rank
+ */
+static inline uint8_t burst_hist_find(const uint8_t *hist, uint8_t *rank)
+{
+	uint8_t bin = 0;
+
+	while (*rank >= hist[bin]) {
+		*rank -= hist[bin];
+		bin++;
+	}
+	return bin;
+}
+
+/*
+ * One pass over the samples builds the coarse histogram and tracks min/max;
+ * a second pass fills fine histograms only for the two bins holding the
+ * wanted ranks. Cost is O(n) with no comparator calls, and the samples are
+ * left untouched.
+ */
+void burst_select(const int16_t *samples, uint8_t count, uint8_t low_rank,
+		  struct burst_stats *stats)
+{
+	uint8_t coarse[BURST_HIST_BINS] = { 0 };
+	uint8_t fine_low[BURST_HIST_BINS] = { 0 };
+	uint8_t fine_median[BURST_HIST_BINS] = { 0 };
+	int16_t min = ADC_MAX_VALUE;
+	int16_t max = 0;
+
+	for (uint8_t i = 0; i < count; i++) {
+		int16_t v = CLAMP(samples[i], 0, ADC_MAX_VALUE);
+
+		min = MIN(min, v);
+		max = MAX(max, v);
+		coarse[v >> BURST_HIST_BITS]++;
+	}
+
+	uint8_t low_fine_rank = low_rank;
+	uint8_t median_fine_rank = count / 2;
+	uint8_t low_bin = burst_hist_find(coarse, &low_fine_rank);
+	uint8_t median_bin = burst_hist_find(coarse, &median_fine_rank);
+
+	for (uint8_t i = 0; i < count; i++) {
+		int16_t v = CLAMP(samples[i], 0, ADC_MAX_VALUE);
+		uint8_t bin = v >> BURST_HIST_BITS;
+
+		if (bin == low_bin) {
+			fine_low[v & BURST_HIST_MASK]++;
+		}
+		if (bin == median_bin) {
+			fine_median[v & BURST_HIST_MASK]++;
+		}
+	}
+
+	stats->min = min;
+	stats->max = max;
+	stats->low = (low_bin << BURST_HIST_BITS) |
+		     burst_hist_find(fine_low, &low_fine_rank);
+	stats->median = (median_bin << BURST_HIST_BITS) |
+			burst_hist_find(fine_median, &median_fine_rank);
+}
+
+/* ==========================================================================
+ * Pulse Phase Tracking
+ *
+ * Where the low window of the NTC pulse sits, learnt from a full burst and
+ * trimmed by every short capture taken inside it. The caller supplies the
+ * times: main.c from the conversion timestamps, the tests from the trace.
+ * ========================================================================== */
+
+/** Classify a sample against the pulse threshold, with hysteresis */
+static bool burst_phase_is_low(const struct burst_phase *phase, int16_t v, bool was_low)
+{
+	if (v < phase->threshold - phase->hysteresis) {
+		return true;
+	}
+	if (v > phase->threshold + phase->hysteresis) {
+		return false;
+	}
+	return was_low;
+}
+
+/** Re-centre the classification threshold on a new low level */
+static void burst_phase_set_level(struct burst_phase *phase, int16_t low)
+{
+	int16_t swing = MAX(phase->amplitude, PHASE_MIN_AMPLITUDE);
+
+	phase->threshold = low + swing / 2;
+	phase->hysteresis = swing / 8;
+}
+
+/** Snap a measured period to the mains period it came from, or 0 if none */
+static uint32_t burst_phase_snap_period(uint32_t period_us)
+{
+	if (IN_RANGE(period_us, PHASE_PERIOD_50HZ_US - PHASE_PERIOD_TOL_US,
+		     PHASE_PERIOD_50HZ_US + PHASE_PERIOD_TOL_US)) {
+		return PHASE_PERIOD_50HZ_US;
+	}
+	if (IN_RANGE(period_us, PHASE_PERIOD_60HZ_US - PHASE_PERIOD_TOL_US,
+		     PHASE_PERIOD_60HZ_US + PHASE_PERIOD_TOL_US)) {
+		return PHASE_PERIOD_60HZ_US;
+	}
+	return 0;
+}
+
+void burst_phase_learn(struct burst_phase *phase, const int16_t *samples,
+		       const struct burst_stats *stats, uint32_t first_us, uint32_t interval_us)
+{
+	int fall = -1, rise = -1, prev_rise = -1, next_fall = -1;
+	int period_samples = 0;
+	bool low;
+
+	phase->locked = false;
+	phase->locked_cycles = 0;
+	phase->interval_us = interval_us;
+	phase->amplitude = stats->max - stats->low;
+	burst_phase_set_level(phase, stats->low);
+
+	if (phase->amplitude < PHASE_MIN_AMPLITUDE) {
+		phase->period_us = 0;
+		phase->locked = true;
+		return;
+	}
+
+	low = samples[0] < phase->threshold;
+	for (int i = 1; i < BURST_SAMPLE_COUNT; i++) {
+		bool now_low = burst_phase_is_low(phase, samples[i], low);
+
+		if (now_low && !low) {
+			if (fall < 0) {
+				fall = i;
+			} else if (rise >= 0 && next_fall < 0) {
+				next_fall = i;
+			}
+		} else if (!now_low && low) {
+			if (fall < 0) {
+				prev_rise = i;
+			} else if (rise < 0) {
+				rise = i;
+			}
+		}
+		low = now_low;
+	}
+
+	/* No usable low window */
+	if (fall < 0 || rise < 0 || rise - fall < PHASE_MIN_LOW_SAMPLES) {
+		return;
+	}
+
+	if (next_fall >= 0) {
+		period_samples = next_fall - fall;
+	} else if (prev_rise >= 0) {
+		period_samples = rise - prev_rise;
+	}
+
+	uint32_t period_us = burst_phase_snap_period(period_samples * interval_us);
+
+	if (period_us == 0) {
+		return;
+	}
+
+	/* Centre of the low run, from the first low sample to the last */
+	phase->ref_us = first_us + (fall + rise - 1) * interval_us / 2;
+	phase->period_us = period_us;
+	phase->locked = true;
+}
+
+int32_t burst_phase_schedule(struct burst_phase *phase, uint32_t now_us)
+{
+	if (phase->period_us == 0) {
+		return 0;
+	}
+
+	uint32_t half_us = (PHASE_LOCKED_SAMPLE_COUNT - 1) * phase->interval_us / 2;
+	uint32_t elapsed_us = now_us - phase->ref_us;
+
+	if (elapsed_us > PHASE_MAX_COAST_US) {
+		return -EAGAIN;
+	}
+
+	uint32_t periods = DIV_ROUND_UP(elapsed_us + PHASE_START_GUARD_US + half_us,
+					phase->period_us);
+	uint32_t centre_us = periods * phase->period_us;
+
+	phase->expected_periods = periods;
+	phase->expected_us = phase->ref_us + centre_us;
+
+	return centre_us - half_us - elapsed_us;
+}
+
+int burst_phase_track(struct burst_phase *phase, const int16_t *samples,
+		      uint32_t first_us, uint32_t interval_us, int16_t *adc)
+{
+	const uint8_t count = PHASE_LOCKED_SAMPLE_COUNT;
+	uint32_t low_index_sum = 0;
+	uint8_t low_count = 0;
+	bool low = samples[0] < phase->threshold;
+	struct burst_stats stats;
+
+	for (uint8_t i = 0; i < count; i++) {
+		low = burst_phase_is_low(phase, samples[i], low);
+		if (low) {
+			low_count++;
+			low_index_sum += i;
+		}
+	}
+
+	if (low_count < count / 2 ||
+	    (phase->period_us == 0 && low_count < count)) {
+		phase->locked = false;
+		return -EAGAIN;
+	}
+
+	if (phase->period_us != 0) {
+		if (low_count < count) {
+			uint32_t centre_us = first_us + low_index_sum * interval_us / low_count;
+			int32_t error_us = (int32_t)(centre_us - phase->expected_us);
+
+			if (error_us > (int32_t)phase->period_us / 4 ||
+			    error_us < -(int32_t)phase->period_us / 4) {
+				phase->locked = false;
+				return -EAGAIN;
+			}
+
+			phase->ref_us = centre_us;
+			phase->period_us = (int32_t)phase->period_us +
+				error_us / (2 * (int32_t)phase->expected_periods);
+		} else {
+			phase->ref_us = phase->expected_us;
+		}
+	}
+
+	burst_select(samples, count, BURST_LOW_RANK(low_count), &stats);
+	burst_phase_set_level(phase, stats.low);
+
+	/* Refresh amplitude and phase from a full burst now and then */
+	if (++phase->locked_cycles >= PHASE_RELEARN_CYCLES) {
+		phase->locked = false;
+	}
+
+	*adc = stats.low;
+	return 0;
+}
+
+/* ==========================================================================
+ * ADC Filters
+ *
+ * Raw codes are smoothed in Q16 fixed point before conversion. The
+ * fractional accumulator has no dead band, unlike the former integer
+ * division EMA, which stalled up to 3 codes (its divisor less one) short
+ * of a new level. Filters per channel:
+ *   EMA:        x += (z - x) >> ADC_FILTER_EMA_SHIFT
+ *   Median-EMA: EMA of the median of the last 3 codes; drops single spikes
+ *   Alpha-beta: predicts x + v * dt, corrects with fixed gains. Follows a
+ *               heating ramp without the steady EMA lag (~3 samples), and
+ *               settles back when the rate changes.
+ * ========================================================================== */
+
+static int16_t median3(int16_t a, int16_t b, int16_t c)
+{
+	return MAX(MIN(a, b), MIN(MAX(a, b), c));
+}
+
+void adc_filter_reset(struct adc_filter *f)
+{
+	f->count = 0;
+	f->v_q16 = 0;
+}
+
+int32_t adc_filter_value(const struct adc_filter *f)
+{
+	if (f->count == 0) {
+		return -1;
+	}
+
+	/* Signed constant: BIT() is unsigned and would make the shift logical */
+	return CLAMP((f->x_q16 + ((int32_t)1 << 15)) >> 16, 0, ADC_MAX_VALUE);
+}
+
+int16_t adc_filter_update(struct adc_filter *f, int16_t code, int64_t now_ms)
+{
+	int32_t z_q16;
+
+	/* Raw SAADC codes dip slightly below 0 near 0 V */
+	code = CLAMP(code, 0, ADC_MAX_VALUE);
+
+	if (f->count == 0) {
+		/* First sample: start at it */
+		f->x_q16 = (int32_t)code << 16;
+		f->v_q16 = 0;
+		f->recent[0] = f->recent[1] = code;
+		f->last_ms = now_ms;
+		f->count = 1;
+		return code;
+	}
+
+	if (f->kind == ADC_FILTER_MEDIAN_EMA && f->count >= 2) {
+		z_q16 = (int32_t)median3(code, f->recent[0], f->recent[1]) << 16;
+	} else {
+		z_q16 = (int32_t)code << 16;
+	}
+	f->recent[1] = f->recent[0];
+	f->recent[0] = code;
+	f->count = MIN(f->count + 1, 3);
+
+	if (f->kind == ADC_FILTER_ALPHA_BETA) {
+		int32_t dt_ms = (int32_t)CLAMP(now_ms - f->last_ms, 1, 10000);
+		int32_t residual;
+
+		f->x_q16 += (int32_t)(((int64_t)f->v_q16 * dt_ms) / 1000);
+		residual = z_q16 - f->x_q16;
+		f->x_q16 += residual >> ADC_FILTER_AB_ALPHA_SHIFT;
+		f->v_q16 += (int32_t)((((int64_t)residual >> ADC_FILTER_AB_BETA_SHIFT) * 1000) / dt_ms);
+	} else {
+		f->x_q16 += (z_q16 - f->x_q16) >> ADC_FILTER_EMA_SHIFT;
+	}
+	f->last_ms = now_ms;
+
+	/* Keep the state inside the code range so a fast rate cannot run off */
+	f->x_q16 = CLAMP(f->x_q16, 0, (int32_t)ADC_MAX_VALUE << 16);
+
+	return (int16_t)adc_filter_value(f);
+}
+
+/* ==========================================================================
+ * Temperature Conversion
+ *
+ * A single lookup in tables generated at build time by
+ * scripts/gen_temp_lut.py (see Temperature Conversion Functions in main.c).
+ * ========================================================================== */
+
+int16_t adc_to_target_temp(const struct kettle_temp_tables *tables, int16_t adc_val)
+{
+	return tables->target[CLAMP(adc_val, 0, ADC_MAX_VALUE)];
+}
+
+int16_t adc_to_current_temp(const struct kettle_temp_tables *tables, int16_t adc_val)
+{
+	if (adc_val < 0) {
+		return TEMP_INVALID_ZB;
+	}
+
+	return tables->current[MIN(adc_val, ADC_MAX_VALUE)];
+}
+
+/* ==========================================================================
+ * Water Channel
+ *
+ * One sampling cycle of the water NTC, from the burst's low-percentile code
+ * to a temperature and the slope the sampling policy and the ready
+ * detector follow.
+ * ========================================================================== */
+
+enum water_status water_channel_update(struct water_channel *ch,
+				       const struct kettle_temp_tables *tables,
+				       int16_t burst_code, int64_t now_ms,
+				       int16_t *code, int16_t *temp)
+{
+	*temp = TEMP_INVALID_ZB;
+
+	if (burst_code < ch->off_base_code) {
+		adc_filter_reset(&ch->filter);
+		ch->last_temp_ms = 0;
+		ch->slope = 0;
+		return WATER_OFF_BASE;
+	}
+
+	*code = adc_filter_update(&ch->filter, burst_code, now_ms);
+	*temp = adc_to_current_temp(tables, *code);
+	if (*temp == TEMP_INVALID_ZB) {
+		return WATER_INVALID;
+	}
+
+	if (ch->last_temp_ms != 0 && now_ms > ch->last_temp_ms) {
+		int32_t slope = (int32_t)(*temp - ch->last_temp) * 1000 /
+				(int32_t)(now_ms - ch->last_temp_ms);
+
+		ch->slope += (slope - ch->slope) / WATER_SLOPE_COEFF;
+	}
+	ch->last_temp = *temp;
+	ch->last_temp_ms = now_ms;
+
+	return WATER_VALID;
+}
+
+/* ==========================================================================
+ * Sampling Policy
+ *
+ * Fast while the dial turns or the kettle heats, default while the water
+ * temperature moves, and slow when idle or lifted off the base.
+ * ========================================================================== */
+
+uint32_t adc_sample_interval_ms(bool dial_active, kettle_state_t state,
+				int16_t water_temp, int32_t slope)
+{
+	if (dial_active) {
+		return ADC_INTERVAL_DIAL_MS;
+	}
+
+	if (state != KETTLE_STATE_OFF) {
+		return ADC_INTERVAL_HEATING_MS;
+	}
+
+	if (water_temp == TEMP_INVALID_ZB) {
+		return ADC_INTERVAL_LIFTED_MS;
+	}
+
+	if (slope >= ADC_SLOPE_STEADY || slope <= -ADC_SLOPE_STEADY) {
+		return ADC_SAMPLE_INTERVAL_MS;
+	}
+
+	return ADC_INTERVAL_IDLE_MS;
+}
+
+/* ==========================================================================
+ * Kettle State Transitions
+ * ========================================================================== */
+
+const char *kettle_state_name(kettle_state_t state)
+{
+	switch (state) {
+	case KETTLE_STATE_OFF: return "OFF";
+	case KETTLE_STATE_TURNING_ON: return "TURNING_ON";
+	case KETTLE_STATE_ON: return "ON";
+	case KETTLE_STATE_TURNING_OFF: return "TURNING_OFF";
+	default: return "UNKNOWN";
+	}
+}
+
+kettle_state_t kettle_state_next(kettle_state_t state, bool gpio_heating)
+{
+	switch (state) {
+	case KETTLE_STATE_OFF:
+		/* Physical button or external: follow the element */
+		return gpio_heating ? KETTLE_STATE_ON : state;
+
+	case KETTLE_STATE_TURNING_ON:
+		/* Kettle accepted the command; if not heating yet, wait for timeout */
+		return gpio_heating ? KETTLE_STATE_ON : state;
+
+	case KETTLE_STATE_ON:
+		/* Reached temperature, manual off, or lifted */
+		return gpio_heating ? state : KETTLE_STATE_OFF;
+
+	case KETTLE_STATE_TURNING_OFF:
+		/* If still heating, wait for timeout */
+		return gpio_heating ? state : KETTLE_STATE_OFF;
+	}
+
+	return state;
+}
+
+kettle_state_t kettle_state_timeout(kettle_state_t state, bool gpio_heating)
+{
+	switch (state) {
+	case KETTLE_STATE_TURNING_ON:
+		/* Kettle declined - no water? */
+		return KETTLE_STATE_OFF;
+
+	case KETTLE_STATE_TURNING_OFF:
+		return gpio_heating ? KETTLE_STATE_ON : KETTLE_STATE_OFF;
+
+	default:
+		return state;
+	}
+}
+
+kettle_state_t kettle_state_command(kettle_state_t state, bool on)
+{
+	if (on) {
+		return (state == KETTLE_STATE_ON || state == KETTLE_STATE_TURNING_ON) ?
+		       state : KETTLE_STATE_TURNING_ON;
+	}
+
+	return (state == KETTLE_STATE_OFF || state == KETTLE_STATE_TURNING_OFF) ?
+	       state : KETTLE_STATE_TURNING_OFF;
+}
+
+/* ==========================================================================
+ * Button Sequences
+ * ========================================================================== */
+
+int button_seq_load(struct button_seq *seq, const uint16_t *steps, uint8_t count)
+{
+	/* A sequence must end on a press so the line is released after it */
+	if (count == 0 || count > KETTLE_BUTTON_SEQ_MAX || !(count & 1)) {
+		return -EINVAL;
+	}
+	for (uint8_t i = 0; i < count; i++) {
+		if (steps[i] == 0) {
+			return -EINVAL;
+		}
+	}
+
+	memcpy(seq->steps, steps, count * sizeof(steps[0]));
+	seq->count = count;
+	seq->next = 0;
+	return 0;
+}
+
+bool button_seq_step(struct button_seq *seq, bool *pressed, uint32_t *hold_ms)
+{
+	if (seq->next >= seq->count) {
+		*pressed = false;
+		*hold_ms = 0;
+		return false;
+	}
+
+	/* Even steps press, odd steps release */
+	*pressed = !(seq->next & 1);
+	*hold_ms = seq->steps[seq->next++];
+	return true;
+}
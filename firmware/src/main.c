@@ -10,6 +10,8 @@
  * - Status LED for network indication
  */
 
+#include <stdlib.h>
+
 #include <zephyr/types.h>
 #include <zephyr/kernel.h>
 #include <zephyr/device.h>
@@ -18,24 +20,58 @@
 #include <zephyr/drivers/adc.h>
 #include <zephyr/logging/log.h>
 #include <zephyr/settings/settings.h>
-#include <stdlib.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/spsc_lockfree.h>
 
 #include <zboss_api.h>
 #include <zboss_api_addons.h>
+#ifdef CONFIG_KETTLE_LEAN
+#include "zb_mem_config_kettle.h"  /* Smaller network tables, larger buffer pool */
+#else
 #include <zb_mem_config_max.h>  /* Use max buffers for router long-term stability */
+#endif
 #include <zigbee/zigbee_app_utils.h>
 #include <zigbee/zigbee_error_handler.h>
 #include <zb_nrf_platform.h>
 #include "zb_kettle.h"
+#include "kettle_sense.h"
+#include "kettle_temp_lut.h"        /* Generated from CONFIG_KETTLE_CALIBRATION_FILE */
 
 #ifdef CONFIG_ZIGBEE_FOTA
 #include <zigbee/zigbee_fota.h>
 #include <zephyr/dfu/mcuboot.h>
+#ifdef CONFIG_KETTLE_OTA_RESUME
+#include <dfu/dfu_target.h>
+#endif
 #include <zephyr/sys/reboot.h>
 #endif
 
 LOG_MODULE_REGISTER(app, LOG_LEVEL_INF);
 
+/*
+ * Logging profile (CONFIG_KETTLE_LOG_PROFILE). Per-sample lines go through
+ * LOG_SAMPLE(): info with the verbose profile, compiled out with the
+ * production one, where the health report carries the sample counters.
+ * Warnings that can repeat every sampling cycle use LOG_WRN_HOT(), which
+ * in production lets one through per call site per
+ * CONFIG_KETTLE_LOG_RATELIMIT_MS.
+ */
+#ifdef CONFIG_KETTLE_LOG_PRODUCTION
+#define LOG_SAMPLE(...) LOG_DBG(__VA_ARGS__)
+#define LOG_WRN_HOT(...)							\
+	do {									\
+		static int64_t next_ms;						\
+		int64_t now_ms = k_uptime_get();				\
+		if (now_ms >= next_ms) {					\
+			next_ms = now_ms + CONFIG_KETTLE_LOG_RATELIMIT_MS;	\
+			LOG_WRN(__VA_ARGS__);					\
+		}								\
+	} while (0)
+#else
+#define LOG_SAMPLE(...) LOG_INF(__VA_ARGS__)
+#define LOG_WRN_HOT(...) LOG_WRN(__VA_ARGS__)
+#endif
+
 /* ==========================================================================
  * UTC Time Stub (required by Zigbee stack)
  * ========================================================================== */
@@ -53,7 +89,9 @@ zb_uint32_t zb_get_utc_time(void)
  * Configuration
  * ========================================================================== */
 
-#define KETTLE_ENDPOINT                 1
+/* Kettle instances are the enabled kitchenaid,kettle devicetree nodes */
+#define DT_DRV_COMPAT                   kitchenaid_kettle
+#define KETTLE_INSTANCE_COUNT           DT_NUM_INST_STATUS_OKAY(DT_DRV_COMPAT)
 
 #define KETTLE_INIT_BASIC_APP_VERSION   1
 #define KETTLE_INIT_BASIC_STACK_VERSION 1
@@ -65,45 +103,24 @@ zb_uint32_t zb_get_utc_time(void)
 #define KETTLE_INIT_BASIC_PH_ENV        ZB_ZCL_BASIC_ENV_UNSPECIFIED
 
 #define BUTTON_LONG_PRESS_MS            3000
-#define KETTLE_BUTTON_PULSE_MS          200     /* Duration to hold simulated button press */
-#define KETTLE_TRANSITION_TIMEOUT_MS    5000    /* Max time to wait for kettle state change */
-
-/* Kettle heating state machine */
-typedef enum {
-	KETTLE_STATE_OFF,           /* Not heating, idle */
-	KETTLE_STATE_TURNING_ON,    /* Button pressed, waiting for heating to start */
-	KETTLE_STATE_ON,            /* Heating active */
-	KETTLE_STATE_TURNING_OFF,   /* Button pressed, waiting for heating to stop */
-} kettle_state_t;
-
-/* Temperature ranges (in 0.01°C units for Zigbee) */
-#define TEMP_MIN_CELSIUS        50
-#define TEMP_MAX_CELSIUS        100
-#define TEMP_MIN_ZB             (TEMP_MIN_CELSIUS * 100)   /* 5000 = 50.00°C */
-#define TEMP_MAX_ZB             (TEMP_MAX_CELSIUS * 100)   /* 10000 = 100.00°C */
-#define TEMP_INVALID_ZB         0x8000                      /* Invalid temperature */
+#define BUTTON_CAL_PRESSES              3       /* Short presses that enter calibration mode */
+#define BUTTON_CAL_WINDOW_MS            2000    /* ...within this window */
 
 /* ADC voltage divider after op-amp buffer */
 #define ADC_DIVIDER_RATIO       2       /* 10K:10K divider after buffer */
 
-/* ADC configuration */
-#define ADC_RESOLUTION          12
-#define ADC_MAX_VALUE           ((1 << ADC_RESOLUTION) - 1)
-#define ADC_SAMPLE_INTERVAL_MS  1000    /* Sample every second */
-
-/* EMA filter: filtered = prev + (new - prev) / ADC_FILTER_COEFF
- * Higher value = more smoothing, slower response
- * 4 = moderate smoothing, 8 = heavy smoothing
+/* ADC code to mV before the divider, Q16 so logging needs no division.
+ * GAIN_1_4 + 0.9V internal ref = 3.6V full scale.
  */
-#define ADC_FILTER_COEFF        4
+#define ADC_MV_PER_CODE_Q16     ((KETTLE_TEMP_LUT_FULL_SCALE_MV * ADC_DIVIDER_RATIO * 65536 + \
+				  ADC_MAX_VALUE / 2) / ADC_MAX_VALUE)
+#define ADC_CODE_TO_MV(code)    ((int32_t)(((int32_t)(code) * ADC_MV_PER_CODE_Q16) >> 16))
 
-/* Burst sampling configuration for pulsed signals
- * The current temperature signal is pulsed at ~50Hz (20ms period).
- * We sample rapidly and take the minimum to get the true value.
- */
-#define BURST_SAMPLE_COUNT      80      /* Number of samples in burst */
-#define BURST_SAMPLE_INTERVAL_US 500    /* 0.5ms between samples = 40ms total window */
-#define BURST_PERCENTILE_INDEX  8       /* 10th percentile (8th lowest of 80) */
+/* Sampling policy timing; the intervals themselves are in kettle_sense.h */
+#define ADC_DIAL_ACTIVE_MS      3000    /* Fast sampling after the last dial change */
+#define ADC_DIAL_WATCH_MS       ADC_INTERVAL_HEATING_MS /* Dial-only check between slow cycles */
+#define ADC_DIAL_WATCH_CODES    24      /* Dial movement that starts a cycle (~0.5°C) */
+#define ADC_FIRST_SAMPLE_WAIT_MS 250    /* Boot: max wait for the first cycle before starting Zigbee */
 
 /* ==========================================================================
  * Device Tree
@@ -111,14 +128,30 @@ typedef enum {
 
 static const struct gpio_dt_spec button = GPIO_DT_SPEC_GET(DT_ALIAS(sw0), gpios);
 static const struct gpio_dt_spec status_led = GPIO_DT_SPEC_GET(DT_ALIAS(led0), gpios);
-static const struct gpio_dt_spec kettle_state_gpio = GPIO_DT_SPEC_GET(DT_NODELABEL(kettle_state_gpio), gpios);
-static const struct gpio_dt_spec kettle_button_gpio = GPIO_DT_SPEC_GET(DT_NODELABEL(kettle_button_gpio), gpios);
+/* Hardware of one kettle, from its kitchenaid,kettle node */
+struct kettle_hw {
+	struct gpio_dt_spec state_gpio;     /* heating state input */
+	struct gpio_dt_spec button_gpio;    /* simulated button output */
+	struct adc_dt_spec  adc_target;     /* dial (target temperature) */
+	struct adc_dt_spec  adc_current;    /* water (current temperature) */
+	uint8_t             endpoint;
+};
+
+#define KETTLE_HW_INIT(inst) {						\
+		.state_gpio = GPIO_DT_SPEC_INST_GET(inst, state_gpios),	\
+		.button_gpio = GPIO_DT_SPEC_INST_GET(inst, button_gpios), \
+		.adc_target = ADC_DT_SPEC_INST_GET_BY_NAME(inst, target), \
+		.adc_current = ADC_DT_SPEC_INST_GET_BY_NAME(inst, current), \
+		.endpoint = DT_INST_PROP(inst, zigbee_endpoint),	\
+	},
+
+static const struct kettle_hw kettle_instances[] = {
+	DT_INST_FOREACH_STATUS_OKAY(KETTLE_HW_INIT)
+};
 
-/* ADC device and channel configuration using devicetree io-channels */
-static const struct adc_dt_spec adc_target_temp =
-	ADC_DT_SPEC_GET_BY_IDX(DT_PATH(zephyr_user), 0);
-static const struct adc_dt_spec adc_current_temp =
-	ADC_DT_SPEC_GET_BY_IDX(DT_PATH(zephyr_user), 1);
+BUILD_ASSERT(KETTLE_INSTANCE_COUNT >= 1, "no enabled kitchenaid,kettle devicetree node");
+/* Sampling and reporting keep BIT(kettle index) masks */
+BUILD_ASSERT(KETTLE_INSTANCE_COUNT <= 32, "too many kitchenaid,kettle devicetree nodes");
 
 /* ==========================================================================
  * Application Context
@@ -131,13 +164,15 @@ typedef struct {
 
 /* Thermostat cluster attributes (target temperature setpoint) */
 typedef struct {
-	zb_int16_t local_temperature;           /* Current temp (0.01°C) - mirrored from temp measurement */
+	zb_int16_t local_temperature;           /* Current temp (0.01°C) - mirrored from temp measurement,
+						 * unused with CONFIG_KETTLE_LOCAL_TEMP_ALIAS */
 	zb_int16_t occupied_cooling_setpoint;   /* Not used, but required */
 	zb_int16_t occupied_heating_setpoint;   /* Target temperature (0.01°C) */
 	zb_int16_t min_heat_setpoint_limit;     /* 50°C min */
 	zb_int16_t max_heat_setpoint_limit;     /* 100°C max */
 	zb_uint8_t control_sequence;            /* Heating only */
 	zb_uint8_t system_mode;                 /* Off/Heat */
+	zb_uint16_t time_to_setpoint;           /* Seconds to setpoint, 0xFFFF unknown (manuf-specific) */
 } thermostat_attrs_t;
 
 /* Temperature measurement cluster attributes */
@@ -147,6 +182,41 @@ typedef struct {
 	zb_int16_t max_measured_value;          /* 100°C */
 } temp_measurement_attrs_t;
 
+/* Kettle cluster attributes (manufacturer-specific, see Field Calibration) */
+typedef struct {
+	zb_uint8_t calibration_state;           /* ZB_KETTLE_CAL_STATE_* */
+	zb_uint8_t calibration_points;          /* BIT(ZB_KETTLE_CAL_POINT_*) in use */
+	zb_int16_t ambient_reference;           /* Ambient point reference (0.01°C) */
+	zb_int16_t boil_reference;              /* Boil point reference (0.01°C), lower at altitude */
+	zb_uint8_t water_ready;                 /* ZB_KETTLE_READY_*, see Ready Detection */
+	zb_uint16_t stream_interval;            /* Seconds between stream frames, 0 = off (see Telemetry Stream) */
+	zb_uint8_t heating_state;               /* ZB_KETTLE_HEATING_*, see Kettle State Machine */
+} kettle_attrs_t;
+
+/* Diagnostics cluster histograms (see Diagnostics) */
+enum diag_metric {
+	DIAG_BURST,                 /* burst capture start to filtered reading */
+	DIAG_UPDATE_TEMPS,          /* update_temperatures() run time */
+	DIAG_WORKQUEUE_LATENCY,     /* adc_sample_work run time past its due time */
+	DIAG_EDGE_TO_REPORT,        /* kettle state GPIO edge to On/Off report sent */
+	DIAG_BUFFER_ACQUIRE,        /* ZBOSS buffer request to buffer in hand */
+	DIAG_APS_RTT,               /* report sent to APS ACK (report_sent_cb()) */
+	DIAG_METRIC_COUNT
+};
+
+#define DIAG_HIST_BUCKETS       16
+
+/* One histogram, laid out as a ZCL octet string */
+typedef struct {
+	zb_uint8_t  len;                        /* octet string length */
+	zb_uint32_t max_us;                     /* largest sample */
+	zb_uint16_t count[DIAG_HIST_BUCKETS];   /* log2 buckets, see Diagnostics */
+} __packed diag_hist_t;
+
+typedef struct {
+	diag_hist_t hist[DIAG_METRIC_COUNT];
+} diag_attrs_t;
+
 typedef struct {
 	zb_zcl_basic_attrs_ext_t    basic_attr;
 	zb_zcl_identify_attrs_t     identify_attr;
@@ -154,444 +224,2185 @@ typedef struct {
 	on_off_attrs_t              on_off_attr;
 	thermostat_attrs_t          thermostat_attr;
 	temp_measurement_attrs_t    temp_measurement_attr;
+	kettle_attrs_t              kettle_attr;
 } kettle_device_ctx_t;
 
-static kettle_device_ctx_t dev_ctx;
+/* Diagnostics histograms: device-wide, served on every kettle endpoint */
+static diag_attrs_t diag_attr;
+
+/* Field calibration points (persisted, see Field Calibration) */
+struct kettle_calibration {
+	uint8_t version;
+	uint8_t points;                          /* BIT(ZB_KETTLE_CAL_POINT_*) captured */
+	int16_t code[ZB_KETTLE_CAL_POINT_COUNT]; /* filtered ADC code at capture */
+	int16_t ref[ZB_KETTLE_CAL_POINT_COUNT];  /* reference temperature (0.01°C) */
+};
 
 /* Button state */
 static struct {
 	int64_t press_time;
+	int64_t first_short_ms;     /* start of the current short press series */
+	uint8_t short_presses;      /* short presses in the series */
 	bool    pressed;
 } button_state;
 
-/* Kettle heating state machine */
-static kettle_state_t kettle_heating_state = KETTLE_STATE_OFF;
-
 static struct gpio_callback button_cb_data;
-static struct gpio_callback kettle_state_cb_data;
 static struct k_work button_work;
 static struct k_work_delayable long_press_work;
 static struct k_work_delayable adc_sample_work;
-static struct k_work_delayable kettle_button_release_work;
-static struct k_work_delayable kettle_transition_timeout_work;
+static struct k_work_delayable adc_dial_watch_work;
 static struct k_work_delayable health_monitor_work;
 
+/* Sensor workqueue: sampling and filtering, kept off the system workqueue
+ * so button, LED and kettle pulse timing never waits on an ADC cycle
+ */
+static struct k_work_q sensor_wq;
+static K_THREAD_STACK_DEFINE(sensor_wq_stack, CONFIG_KETTLE_SENSOR_STACK_SIZE);
+
+/* Inputs without an edge interrupt (no GPIOTE on their port) are polled
+ * from main(); the bits below mark which ones.
+ */
+#define GPIO_POLL_INTERVAL_MS   50
+#define GPIO_POLL_BUTTON        BIT(0)
+#define GPIO_POLL_KETTLE_STATE  BIT(1)  /* at least one kettle, see kettle_ctx.state_polled */
+static uint8_t gpio_polled_inputs;
+
 /* Health monitoring interval (5 minutes) */
 #define HEALTH_MONITOR_INTERVAL_MS (5 * 60 * 1000)
 
-/* ADC buffer and sequence (configured per-read) */
-static int16_t adc_buffer;
+/* Burst sample buffer for pulsed signal detection (filled by EasyDMA).
+ * A batched burst interleaves the water channels of every kettle in it,
+ * one conversion each per sampling, in ascending channel order.
+ */
+static int16_t burst_samples[BURST_SAMPLE_COUNT * KETTLE_INSTANCE_COUNT];
+
+/* Background burst capture: timer-paced conversions, completion via signal */
+static struct adc_sequence_options burst_options;
+static struct adc_sequence burst_sequence;
+static struct k_poll_signal burst_signal;
+static struct k_poll_event burst_event;
+static struct k_work_poll burst_done_work;
+static struct k_work_delayable burst_start_work;
+
+/* Capture in flight: the kettles it covers and whether it is a short locked one */
+static uint32_t burst_scan;                 /* BIT(kettle index) */
+static bool burst_locked;
+
+/* Phase clock (see burst_clock_us()) at the first and last conversion of
+ * the capture in flight (written from the ADC sequence callback)
+ */
+static volatile uint32_t burst_first_us;
+static volatile uint32_t burst_last_us;
+
+/* Sampling cycle flags (set from any context, see request_adc_sample_now()) */
+static atomic_t adc_cycle_flags;
+static uint32_t adc_cycle_interval_ms;  /* Delay before the next cycle (sensor workqueue) */
+#define ADC_CYCLE_BUSY          0       /* A capture is scheduled or in flight */
+#define ADC_CYCLE_REQUESTED     1       /* Start the next cycle without delay */
+
+/* Kettles still waiting for their water capture in the cycle in flight */
+static uint32_t adc_cycle_todo;             /* BIT(kettle index) */
+
+/* Filter stage of the target dial and water NTC channels */
+#define ADC_TARGET_FILTER_KIND							\
+	(IS_ENABLED(CONFIG_KETTLE_FILTER_DIAL_ALPHA_BETA) ? ADC_FILTER_ALPHA_BETA :	\
+	 IS_ENABLED(CONFIG_KETTLE_FILTER_DIAL_MEDIAN_EMA) ? ADC_FILTER_MEDIAN_EMA :	\
+	 ADC_FILTER_EMA)
+#define ADC_CURRENT_FILTER_KIND							\
+	(IS_ENABLED(CONFIG_KETTLE_FILTER_WATER_ALPHA_BETA) ? ADC_FILTER_ALPHA_BETA :	\
+	 IS_ENABLED(CONFIG_KETTLE_FILTER_WATER_MEDIAN_EMA) ? ADC_FILTER_MEDIAN_EMA :	\
+	 ADC_FILTER_EMA)
+
+/* Report queue statistics (used by reporting callbacks and health monitor,
+ * served as Diagnostics cluster attributes)
+ */
+static struct {
+	uint8_t  pressure;          /* buffer pressure level, 0 = none */
+	uint32_t alloc_failures;    /* frames that found no free buffer */
+	uint32_t retried;           /* frames sent after backing off */
+	uint32_t deferred;          /* frames held back by buffer pressure */
+	uint32_t dropped;           /* low priority changes given up after retries */
+	uint32_t aps_failures;      /* frames sent without an APS ACK */
+	uint32_t pool_low;          /* flush passes that found the buffer pool low */
+	uint32_t pool_oom;          /* ...or out of memory */
+	uint8_t  in_flight;         /* frames awaiting report_sent_cb() */
+	uint8_t  in_flight_max;     /* high-water mark of in_flight */
+} report_stats;
+
+/* Telemetry stream statistics (see Telemetry Stream) */
+static struct {
+	uint32_t frames;            /* Stream Data frames sent */
+	uint32_t dropped;           /* samples lost to backlog */
+} stream_stats;
+
+/* OTA download statistics (see Zigbee FOTA, served as Diagnostics attributes) */
+static struct {
+	uint8_t  progress;          /* percent of the image received */
+	uint32_t offset;            /* image bytes received */
+	uint16_t throughput;        /* bytes/s since the download (re)started */
+	uint16_t block_period;      /* ms between Image Block Requests */
+} ota_stats;
+
+#ifdef CONFIG_KETTLE_OTA_RESUME
+/* Download to pick up after a reboot (see Zigbee FOTA), persisted as
+ * "kettle/ota_offset"; written on the ZBOSS thread under ota_resume_lock
+ */
+static struct ota_resume {
+	uint32_t file_version;      /* image being downloaded, 0 = none */
+	uint16_t manufacturer;
+	uint16_t image_type;
+	uint32_t file_offset;       /* client File Offset at the last progress event */
+	uint32_t image_offset;      /* DFU target write offset at the same block */
+} ota_resume;
+static K_MUTEX_DEFINE(ota_resume_lock);
+#endif
+
+/* ==========================================================================
+ * Kettle Instances
+ *
+ * Everything that exists once per kitchenaid,kettle node lives in a
+ * struct kettle_ctx; kettles[] is indexed by devicetree instance number,
+ * like kettle_instances[]. What the kettles share stays file scope: the
+ * sensor workqueue and the capture in flight, the report pass and buffer
+ * pressure, persistence, the pairing button and the diagnostics.
+ * ========================================================================== */
+
+/* Inputs of the adaptive sampling policy (see Sampling Policy) */
+struct adc_policy {
+	int64_t dial_active_until;  /* uptime until which the dial counts as moving */
+	int16_t dial_code;          /* raw dial code of the last cycle, -1 = none */
+};
+
+/* Calibration session, guarded by cal_lock (see Field Calibration) */
+struct cal_session {
+	bool active;
+	uint8_t button_point;                   /* next point captured by the button */
+	struct kettle_calibration pending;
+};
+
+/* Guards the calibration sessions and points of all kettles (ZBOSS thread,
+ * workqueues and settings flushes)
+ */
+static K_MUTEX_DEFINE(cal_lock);
+
+/* Heating fit (see Time-to-Setpoint Estimation) */
+#define TTS_WINDOW              32      /* Samples in the fit (~16s while heating) */
+
+struct tts_fit {
+	int64_t origin_ms;          /* uptime of t = 0, 0 = fit not started */
+	int32_t t[TTS_WINDOW];      /* sample times (TTS_TICK_MS since origin) */
+	int16_t y[TTS_WINDOW];      /* sample temperatures (0.01°C) */
+	uint8_t head;
+	uint8_t count;
+	int64_t sum_t;
+	int64_t sum_y;
+	int64_t sum_tt;
+	int64_t sum_ty;
+};
+
+/* Plateau detector (see Ready Detection) */
+struct ready_detector {
+	bool    armed;              /* a heating cycle started since the last reset */
+	bool    was_heating;
+	int64_t flat_since_ms;      /* uptime the plateau started, 0 = rising */
+};
+
+/* Temperature ring buffer (see History) */
+#define HISTORY_BYTES           2048    /* Power of two */
+
+struct history_ring {
+	uint8_t  buf[HISTORY_BYTES];
+	uint32_t head;              /* position after the newest record */
+	uint32_t tail;              /* position of the oldest record */
+	int16_t  base;              /* temperature before the oldest record */
+	int16_t  last;              /* temperature of the newest record */
+	int64_t  last_ms;           /* uptime of the newest record, 0 = empty */
+};
+
+/* Samples awaiting a Stream Data frame (see Telemetry Stream) */
+#define STREAM_MAX_SAMPLES      32
+
+struct stream_buf {
+	int16_t  temp[STREAM_MAX_SAMPLES];
+	int64_t  ms[STREAM_MAX_SAMPLES];    /* uptime of each sample */
+	uint8_t  count;
+};
+
+/* Attributes sent by the report coalescer (see Zigbee Reporting) */
+enum report_attr {
+	REPORT_ON_OFF,
+	REPORT_SYSTEM_MODE,
+	REPORT_HEATING_SETPOINT,
+	REPORT_LOCAL_TEMP,
+	REPORT_MEASURED_VALUE,
+	REPORT_WATER_READY,
+	REPORT_HEATING_STATE,
+	REPORT_ATTR_COUNT
+};
+
+/* Attributes carrying the water temperature */
+#ifdef CONFIG_KETTLE_LOCAL_TEMP_ALIAS
+#define REPORT_TEMP_MASK        BIT(REPORT_MEASURED_VALUE)
+#else
+#define REPORT_TEMP_MASK        (BIT(REPORT_MEASURED_VALUE) | BIT(REPORT_LOCAL_TEMP))
+#endif
+
+/* Clusters with a report queue slot each, see report_clusters[] */
+#define REPORT_CLUSTER_COUNT    4
+
+/* Report queue slot: one cluster frame of one kettle. The dirty bits are
+ * the payload, so a newer value supersedes a queued one and the queue
+ * cannot overflow.
+ */
+struct report_slot {
+	uint8_t retries;            /* failed allocations since the last send */
+	int64_t not_before_ms;      /* backoff: no allocation before this uptime */
+	bool    direct;             /* next frame to the coordinator: cluster has no binding */
+};
 
-/* Burst sample buffer for pulsed signal detection */
-static int16_t burst_samples[BURST_SAMPLE_COUNT];
+struct kettle_ctx {
+	const struct kettle_hw *hw;
+	uint8_t index;                          /* devicetree instance number */
+
+	kettle_device_ctx_t dev_ctx;            /* ZCL attribute storage of the endpoint */
+	struct kettle_calibration cal;
+
+	/* Kettle state machine, driven in ZBOSS context (see kettle_state_cb()) */
+	kettle_state_t heating_state;
+	struct gpio_callback state_cb_data;
+	atomic_t state_events;                  /* BIT(KETTLE_EVENT_*) */
+	struct k_work_delayable state_work;     /* hands state_events to ZBOSS */
+	struct k_work_delayable transition_timeout_work;
+	bool state_polled;                      /* state GPIO has no edge interrupt */
+	int state_gpio_last;                    /* last polled level, -1 = none */
+
+	/* Kettle button simulation */
+	struct k_timer pulse_timer;
+	struct button_seq pulse_seq;            /* played by pulse_timer */
+	atomic_t pulse_busy;
+
+	/* Sampling */
+	struct burst_phase burst_phase;
+	struct adc_policy adc_policy;
+	struct adc_filter adc_target_filter;    /* filtered dial code */
+	struct water_channel water;             /* water NTC filter and slope */
+	int16_t burst_adc;                      /* water code of this cycle, -1 = none */
+
+	/* Field calibration: tables in use, per-unit tables and session */
+	struct kettle_temp_tables temp_tables;
+	int16_t cal_target_lut[KETTLE_TEMP_LUT_CODES];
+	int16_t cal_current_lut[KETTLE_TEMP_LUT_CODES];
+	struct cal_session cal_session;
+	struct k_work cal_apply_work;
+	struct k_work_delayable cal_timeout_work;
+
+	struct tts_fit tts;
+	struct ready_detector ready;
+	struct history_ring history;
+
+	struct stream_buf stream;
+	struct k_work_delayable stream_work;
+
+	/* Report coalescer */
+	atomic_t report_dirty;                  /* BIT(enum report_attr) */
+	int64_t report_last_ms[REPORT_ATTR_COUNT]; /* uptime of last report per attr */
+	struct report_slot report_queue[REPORT_CLUSTER_COUNT];
+
+	/* Diagnostics: kettle state GPIO edge (ISR or poll) awaiting its On/Off report */
+	volatile uint32_t diag_edge_cyc;
+	atomic_t diag_flags;
+#define DIAG_EDGE_PENDING       0           /* diag_edge_cyc awaits its On/Off report */
+
+	atomic_t persist_dirty;                 /* BIT(enum persist_key) */
+};
 
-/* EMA filtered ADC values (initialized to -1 to indicate first sample) */
-static int32_t adc_target_filtered = -1;
-static int32_t adc_current_filtered = -1;
+/* Set up by kettles_init() before anything else runs */
+static struct kettle_ctx kettles[KETTLE_INSTANCE_COUNT];
 
-/* Report retry counters (used by reporting callbacks and health monitor) */
-static uint8_t state_report_retry_count = 0;
-static uint8_t system_mode_retry_count = 0;
+/* Kettle serving a Zigbee endpoint, or NULL (e.g. the FOTA endpoint) */
+static struct kettle_ctx *kettle_by_endpoint(zb_uint8_t endpoint)
+{
+	ARRAY_FOR_EACH_PTR(kettles, kettle) {
+		if (kettle->hw->endpoint == endpoint) {
+			return kettle;
+		}
+	}
+	return NULL;
+}
 
 /* ==========================================================================
  * Persistent Settings
  * ========================================================================== */
 
+/* Dirty values are flushed once quiet this long, e.g. after the dial stops */
+#define PERSIST_QUIET_MS        5000
+/* ...but never held back longer than this while changes keep coming */
+#define PERSIST_MAX_DELAY_MS    60000
+
+/* Persisted values, stored as "kettle/<name>" for the first kettle and
+ * "kettle/<n>/<name>" for kettle n > 0. Device-wide values live under the
+ * first kettle's keys and are marked on kettles[0].
+ */
+enum persist_key {
+	PERSIST_TARGET_TEMP,
+	PERSIST_CALIBRATION,
+	PERSIST_AMBIENT_REF,
+	PERSIST_BOIL_REF,
+	PERSIST_STREAM_INTERVAL,
+#ifdef CONFIG_KETTLE_OTA_RESUME
+	PERSIST_OTA_OFFSET,
+#endif
+	PERSIST_KEY_COUNT
+};
+
+struct persist_entry {
+	const char *name;
+	size_t      offset;         /* live RAM copy in struct kettle_ctx, copied out on flush */
+	size_t      size;
+	void       *device;         /* ...or this device-wide copy instead */
+	struct k_mutex *lock;       /* held while copying out, if the writer takes it */
+};
+
+#define PERSIST_ENTRY(key, member) {						\
+		.name = key, .offset = offsetof(struct kettle_ctx, member),	\
+		.size = sizeof(((struct kettle_ctx *)0)->member),		\
+	}
+
+#define PERSIST_DEVICE(key, var, mutex) {					\
+		.name = key, .size = sizeof(var), .device = &(var), .lock = (mutex), \
+	}
+
+static const struct persist_entry persist_entries[PERSIST_KEY_COUNT] = {
+	[PERSIST_TARGET_TEMP] =
+		PERSIST_ENTRY("target_temp", dev_ctx.thermostat_attr.occupied_heating_setpoint),
+	/* The calibration is written whole under cal_lock on the ZBOSS thread */
+	[PERSIST_CALIBRATION] = {
+		.name = "calibration", .offset = offsetof(struct kettle_ctx, cal),
+		.size = sizeof(struct kettle_calibration), .lock = &cal_lock,
+	},
+	[PERSIST_AMBIENT_REF] = PERSIST_ENTRY("ambient_ref", dev_ctx.kettle_attr.ambient_reference),
+	[PERSIST_BOIL_REF] = PERSIST_ENTRY("boil_ref", dev_ctx.kettle_attr.boil_reference),
+	[PERSIST_STREAM_INTERVAL] =
+		PERSIST_ENTRY("stream_interval", dev_ctx.kettle_attr.stream_interval),
+#ifdef CONFIG_KETTLE_OTA_RESUME
+	[PERSIST_OTA_OFFSET] = PERSIST_DEVICE("ota_offset", ota_resume, &ota_resume_lock),
+#endif
+};
+
+static inline void *persist_value(struct kettle_ctx *kettle, const struct persist_entry *entry)
+{
+	return entry->device ? entry->device : (uint8_t *)kettle + entry->offset;
+}
+
+/* Largest persisted value; flushes save a snapshot, not the live copy */
+#define PERSIST_VALUE_MAX       sizeof(struct kettle_calibration)
+#ifdef CONFIG_KETTLE_OTA_RESUME
+BUILD_ASSERT(sizeof(struct ota_resume) <= PERSIST_VALUE_MAX);
+#endif
+
+/* k_uptime_get_32() of the oldest unsaved change, 0 = none; marked from any thread */
+static atomic_t persist_first_dirty_ms;
+static K_MUTEX_DEFINE(persist_lock);                /* serializes flushes */
+static struct k_work_delayable persist_work;
+
 static int kettle_settings_set(const char *name, size_t len,
 			       settings_read_cb read_cb, void *cb_arg)
 {
-	if (!strcmp(name, "target_temp")) {
-		if (len != sizeof(dev_ctx.thermostat_attr.occupied_heating_setpoint)) {
+	struct kettle_ctx *kettle = &kettles[0];
+	const char *next;
+
+	/* "<n>/<name>" addresses kettle n, a bare "<name>" the first one */
+	if (settings_name_next(name, &next) && next != NULL) {
+		char *end;
+		unsigned long index = strtoul(name, &end, 10);
+
+		if (end == name || *end != '/' || index >= KETTLE_INSTANCE_COUNT) {
+			return 0;   /* kettle no longer in the devicetree */
+		}
+		kettle = &kettles[index];
+		name = next;
+	}
+
+	for (int i = 0; i < PERSIST_KEY_COUNT; i++) {
+		const struct persist_entry *entry = &persist_entries[i];
+
+		if (strcmp(name, entry->name)) {
+			continue;
+		}
+		if (entry->device && kettle != &kettles[0]) {
+			return 0;   /* device-wide values only live under the bare name */
+		}
+		if (len != entry->size) {
 			return -EINVAL;
 		}
-		read_cb(cb_arg, &dev_ctx.thermostat_attr.occupied_heating_setpoint, len);
-		LOG_INF("Restored target temp: %d (0.01°C)",
-			dev_ctx.thermostat_attr.occupied_heating_setpoint);
+		read_cb(cb_arg, persist_value(kettle, entry), len);
+		LOG_INF("Restored kettle %u %s (%zu bytes)", kettle->index, entry->name, len);
+		return 0;
 	}
 	return 0;
 }
 
 SETTINGS_STATIC_HANDLER_DEFINE(kettle, "kettle", NULL, kettle_settings_set, NULL, NULL);
 
-static void save_kettle_state(void)
+/**
+ * Write all dirty values to NVS.
+ *
+ * Blocks on flash; called from persist_work or right before a reset.
+ */
+static void persist_flush(void)
+{
+	char key[32];
+	uint8_t value[PERSIST_VALUE_MAX] __aligned(4);
+	int err;
+
+	k_mutex_lock(&persist_lock, K_FOREVER);
+
+	atomic_clear(&persist_first_dirty_ms);
+
+	ARRAY_FOR_EACH_PTR(kettles, kettle) {
+		uint32_t dirty = atomic_clear(&kettle->persist_dirty);
+
+		for (int i = 0; i < PERSIST_KEY_COUNT; i++) {
+			const struct persist_entry *entry = &persist_entries[i];
+
+			if (!(dirty & BIT(i))) {
+				continue;
+			}
+			if (kettle->index == 0) {
+				snprintk(key, sizeof(key), "kettle/%s", entry->name);
+			} else {
+				snprintk(key, sizeof(key), "kettle/%u/%s", kettle->index, entry->name);
+			}
+
+			__ASSERT_NO_MSG(entry->size <= sizeof(value));
+			if (entry->lock) {
+				k_mutex_lock(entry->lock, K_FOREVER);
+			}
+			memcpy(value, persist_value(kettle, entry), entry->size);
+			if (entry->lock) {
+				k_mutex_unlock(entry->lock);
+			}
+
+			err = settings_save_one(key, value, entry->size);
+			if (err) {
+				LOG_ERR("Failed to save %s: %d", key, err);
+				/* retried on the next flush */
+				atomic_or(&kettle->persist_dirty, BIT(i));
+			}
+		}
+
+		if (dirty) {
+			LOG_DBG("Persisted kettle %u 0x%02x", kettle->index, dirty);
+		}
+	}
+
+	k_mutex_unlock(&persist_lock);
+}
+
+static void persist_work_handler(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	persist_flush();
+}
+
+/**
+ * Mark a persisted value of a kettle as changed.
+ *
+ * Only touches RAM; the write happens PERSIST_QUIET_MS after the last
+ * change, so a dial sweep costs one flash write instead of dozens.
+ */
+static void persist_mark(struct kettle_ctx *kettle, enum persist_key key)
+{
+	uint32_t now = MAX(k_uptime_get_32(), 1);   /* 0 means nothing unsaved */
+
+	atomic_set_bit(&kettle->persist_dirty, key);
+	(void)atomic_cas(&persist_first_dirty_ms, 0, now);
+
+	int32_t deadline = (int32_t)((uint32_t)atomic_get(&persist_first_dirty_ms) +
+				     PERSIST_MAX_DELAY_MS - now);
+
+	k_work_reschedule(&persist_work, K_MSEC(CLAMP(deadline, 0, PERSIST_QUIET_MS)));
+}
+
+/* Flush before a reset so nothing changed in the last quiet period is lost */
+static void persist_flush_now(void)
 {
-	settings_save_one("kettle/target_temp",
-			  &dev_ctx.thermostat_attr.occupied_heating_setpoint,
-			  sizeof(dev_ctx.thermostat_attr.occupied_heating_setpoint));
+	k_work_cancel_delayable(&persist_work);
+	persist_flush();
 }
 
 /* ==========================================================================
  * Zigbee Cluster Declarations
  * ========================================================================== */
 
-ZB_ZCL_DECLARE_BASIC_ATTRIB_LIST_EXT(
-	basic_attr_list,
-	&dev_ctx.basic_attr.zcl_version,
-	&dev_ctx.basic_attr.app_version,
-	&dev_ctx.basic_attr.stack_version,
-	&dev_ctx.basic_attr.hw_version,
-	dev_ctx.basic_attr.mf_name,
-	dev_ctx.basic_attr.model_id,
-	dev_ctx.basic_attr.date_code,
-	&dev_ctx.basic_attr.power_source,
-	dev_ctx.basic_attr.location_id,
-	&dev_ctx.basic_attr.ph_env,
-	dev_ctx.basic_attr.sw_ver);
-
-ZB_ZCL_DECLARE_IDENTIFY_ATTRIB_LIST(
-	identify_attr_list,
-	&dev_ctx.identify_attr.identify_time);
-
-ZB_ZCL_DECLARE_GROUPS_ATTRIB_LIST(
-	groups_attr_list,
-	&dev_ctx.groups_attr.name_support);
-
-/* On/Off attribute list (controllable kettle state) */
-ZB_ZCL_START_DECLARE_ATTRIB_LIST_CLUSTER_REVISION(on_off_attr_list, ZB_ZCL_ON_OFF)
-ZB_ZCL_SET_ATTR_DESC_M(ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID,
-	(&dev_ctx.on_off_attr.on_off),
-	ZB_ZCL_ATTR_TYPE_BOOL,
-	ZB_ZCL_ATTR_ACCESS_READ_WRITE | ZB_ZCL_ATTR_ACCESS_REPORTING)
+/* Diagnostics cluster attributes (manufacturer-specific cluster, see Diagnostics) */
+ZB_ZCL_START_DECLARE_ATTRIB_LIST_CLUSTER_REVISION(diag_attr_list, ZB_ZCL_KETTLE_DIAGNOSTICS)
+ZB_ZCL_SET_MANUF_SPEC_ATTR_DESC(ZB_ZCL_ATTR_KETTLE_DIAG_BURST_ID,
+	ZB_ZCL_ATTR_TYPE_OCTET_STRING,
+	ZB_ZCL_ATTR_ACCESS_READ_ONLY,
+	ZB_KETTLE_MANUF_CODE,
+	(&diag_attr.hist[DIAG_BURST]))
+ZB_ZCL_SET_MANUF_SPEC_ATTR_DESC(ZB_ZCL_ATTR_KETTLE_DIAG_UPDATE_TEMPS_ID,
+	ZB_ZCL_ATTR_TYPE_OCTET_STRING,
+	ZB_ZCL_ATTR_ACCESS_READ_ONLY,
+	ZB_KETTLE_MANUF_CODE,
+	(&diag_attr.hist[DIAG_UPDATE_TEMPS]))
+ZB_ZCL_SET_MANUF_SPEC_ATTR_DESC(ZB_ZCL_ATTR_KETTLE_DIAG_WORKQUEUE_LATENCY_ID,
+	ZB_ZCL_ATTR_TYPE_OCTET_STRING,
+	ZB_ZCL_ATTR_ACCESS_READ_ONLY,
+	ZB_KETTLE_MANUF_CODE,
+	(&diag_attr.hist[DIAG_WORKQUEUE_LATENCY]))
+ZB_ZCL_SET_MANUF_SPEC_ATTR_DESC(ZB_ZCL_ATTR_KETTLE_DIAG_EDGE_TO_REPORT_ID,
+	ZB_ZCL_ATTR_TYPE_OCTET_STRING,
+	ZB_ZCL_ATTR_ACCESS_READ_ONLY,
+	ZB_KETTLE_MANUF_CODE,
+	(&diag_attr.hist[DIAG_EDGE_TO_REPORT]))
+ZB_ZCL_SET_MANUF_SPEC_ATTR_DESC(ZB_ZCL_ATTR_KETTLE_DIAG_BUFFER_ACQUIRE_ID,
+	ZB_ZCL_ATTR_TYPE_OCTET_STRING,
+	ZB_ZCL_ATTR_ACCESS_READ_ONLY,
+	ZB_KETTLE_MANUF_CODE,
+	(&diag_attr.hist[DIAG_BUFFER_ACQUIRE]))
+ZB_ZCL_SET_MANUF_SPEC_ATTR_DESC(ZB_ZCL_ATTR_KETTLE_DIAG_APS_RTT_ID,
+	ZB_ZCL_ATTR_TYPE_OCTET_STRING,
+	ZB_ZCL_ATTR_ACCESS_READ_ONLY,
+	ZB_KETTLE_MANUF_CODE,
+	(&diag_attr.hist[DIAG_APS_RTT]))
+ZB_ZCL_SET_MANUF_SPEC_ATTR_DESC(ZB_ZCL_ATTR_KETTLE_DIAG_ALLOC_FAILURES_ID,
+	ZB_ZCL_ATTR_TYPE_U32,
+	ZB_ZCL_ATTR_ACCESS_READ_ONLY,
+	ZB_KETTLE_MANUF_CODE,
+	(&report_stats.alloc_failures))
+ZB_ZCL_SET_MANUF_SPEC_ATTR_DESC(ZB_ZCL_ATTR_KETTLE_DIAG_RETRIED_ID,
+	ZB_ZCL_ATTR_TYPE_U32,
+	ZB_ZCL_ATTR_ACCESS_READ_ONLY,
+	ZB_KETTLE_MANUF_CODE,
+	(&report_stats.retried))
+ZB_ZCL_SET_MANUF_SPEC_ATTR_DESC(ZB_ZCL_ATTR_KETTLE_DIAG_DEFERRED_ID,
+	ZB_ZCL_ATTR_TYPE_U32,
+	ZB_ZCL_ATTR_ACCESS_READ_ONLY,
+	ZB_KETTLE_MANUF_CODE,
+	(&report_stats.deferred))
+ZB_ZCL_SET_MANUF_SPEC_ATTR_DESC(ZB_ZCL_ATTR_KETTLE_DIAG_DROPPED_ID,
+	ZB_ZCL_ATTR_TYPE_U32,
+	ZB_ZCL_ATTR_ACCESS_READ_ONLY,
+	ZB_KETTLE_MANUF_CODE,
+	(&report_stats.dropped))
+ZB_ZCL_SET_MANUF_SPEC_ATTR_DESC(ZB_ZCL_ATTR_KETTLE_DIAG_APS_FAILURES_ID,
+	ZB_ZCL_ATTR_TYPE_U32,
+	ZB_ZCL_ATTR_ACCESS_READ_ONLY,
+	ZB_KETTLE_MANUF_CODE,
+	(&report_stats.aps_failures))
+ZB_ZCL_SET_MANUF_SPEC_ATTR_DESC(ZB_ZCL_ATTR_KETTLE_DIAG_POOL_LOW_ID,
+	ZB_ZCL_ATTR_TYPE_U32,
+	ZB_ZCL_ATTR_ACCESS_READ_ONLY,
+	ZB_KETTLE_MANUF_CODE,
+	(&report_stats.pool_low))
+ZB_ZCL_SET_MANUF_SPEC_ATTR_DESC(ZB_ZCL_ATTR_KETTLE_DIAG_POOL_OOM_ID,
+	ZB_ZCL_ATTR_TYPE_U32,
+	ZB_ZCL_ATTR_ACCESS_READ_ONLY,
+	ZB_KETTLE_MANUF_CODE,
+	(&report_stats.pool_oom))
+ZB_ZCL_SET_MANUF_SPEC_ATTR_DESC(ZB_ZCL_ATTR_KETTLE_DIAG_IN_FLIGHT_MAX_ID,
+	ZB_ZCL_ATTR_TYPE_U8,
+	ZB_ZCL_ATTR_ACCESS_READ_ONLY,
+	ZB_KETTLE_MANUF_CODE,
+	(&report_stats.in_flight_max))
+ZB_ZCL_SET_MANUF_SPEC_ATTR_DESC(ZB_ZCL_ATTR_KETTLE_DIAG_OTA_PROGRESS_ID,
+	ZB_ZCL_ATTR_TYPE_U8,
+	ZB_ZCL_ATTR_ACCESS_READ_ONLY,
+	ZB_KETTLE_MANUF_CODE,
+	(&ota_stats.progress))
+ZB_ZCL_SET_MANUF_SPEC_ATTR_DESC(ZB_ZCL_ATTR_KETTLE_DIAG_OTA_OFFSET_ID,
+	ZB_ZCL_ATTR_TYPE_U32,
+	ZB_ZCL_ATTR_ACCESS_READ_ONLY,
+	ZB_KETTLE_MANUF_CODE,
+	(&ota_stats.offset))
+ZB_ZCL_SET_MANUF_SPEC_ATTR_DESC(ZB_ZCL_ATTR_KETTLE_DIAG_OTA_THROUGHPUT_ID,
+	ZB_ZCL_ATTR_TYPE_U16,
+	ZB_ZCL_ATTR_ACCESS_READ_ONLY,
+	ZB_KETTLE_MANUF_CODE,
+	(&ota_stats.throughput))
+ZB_ZCL_SET_MANUF_SPEC_ATTR_DESC(ZB_ZCL_ATTR_KETTLE_DIAG_OTA_BLOCK_PERIOD_ID,
+	ZB_ZCL_ATTR_TYPE_U16,
+	ZB_ZCL_ATTR_ACCESS_READ_ONLY,
+	ZB_KETTLE_MANUF_CODE,
+	(&ota_stats.block_period))
 ZB_ZCL_FINISH_DECLARE_ATTRIB_LIST;
 
-/* Thermostat cluster attributes
- * Use _M macro for attributes that need reporting access flag
- */
-ZB_ZCL_START_DECLARE_ATTRIB_LIST_CLUSTER_REVISION(thermostat_attr_list, ZB_ZCL_THERMOSTAT)
-ZB_ZCL_SET_ATTR_DESC_M(ZB_ZCL_ATTR_THERMOSTAT_LOCAL_TEMPERATURE_ID,
-	(&dev_ctx.thermostat_attr.local_temperature),
-	ZB_ZCL_ATTR_TYPE_S16,
-	ZB_ZCL_ATTR_ACCESS_READ_ONLY | ZB_ZCL_ATTR_ACCESS_REPORTING)
-ZB_ZCL_SET_ATTR_DESC(ZB_ZCL_ATTR_THERMOSTAT_OCCUPIED_COOLING_SETPOINT_ID,
-	(&dev_ctx.thermostat_attr.occupied_cooling_setpoint))
-ZB_ZCL_SET_ATTR_DESC_M(ZB_ZCL_ATTR_THERMOSTAT_OCCUPIED_HEATING_SETPOINT_ID,
-	(&dev_ctx.thermostat_attr.occupied_heating_setpoint),
-	ZB_ZCL_ATTR_TYPE_S16,
-	ZB_ZCL_ATTR_ACCESS_READ_WRITE | ZB_ZCL_ATTR_ACCESS_REPORTING)
-ZB_ZCL_SET_ATTR_DESC(ZB_ZCL_ATTR_THERMOSTAT_MIN_HEAT_SETPOINT_LIMIT_ID,
-	(&dev_ctx.thermostat_attr.min_heat_setpoint_limit))
-ZB_ZCL_SET_ATTR_DESC(ZB_ZCL_ATTR_THERMOSTAT_MAX_HEAT_SETPOINT_LIMIT_ID,
-	(&dev_ctx.thermostat_attr.max_heat_setpoint_limit))
-ZB_ZCL_SET_ATTR_DESC(ZB_ZCL_ATTR_THERMOSTAT_CONTROL_SEQUENCE_OF_OPERATION_ID,
-	(&dev_ctx.thermostat_attr.control_sequence))
-ZB_ZCL_SET_ATTR_DESC_M(ZB_ZCL_ATTR_THERMOSTAT_SYSTEM_MODE_ID,
-	(&dev_ctx.thermostat_attr.system_mode),
-	ZB_ZCL_ATTR_TYPE_8BIT_ENUM,
-	ZB_ZCL_ATTR_ACCESS_READ_WRITE | ZB_ZCL_ATTR_ACCESS_REPORTING)
-ZB_ZCL_FINISH_DECLARE_ATTRIB_LIST;
+/*
+ * Every kitchenaid,kettle node gets its own endpoint: the attribute lists
+ * below point into its kettles[] entry. The Diagnostics cluster is the
+ * exception, its counters are device-wide and one list serves all
+ * endpoints.
+ */
+
+#ifdef CONFIG_KETTLE_LOCAL_TEMP_ALIAS
+/* Read-time alias: served from measured_value, reported only by that cluster */
+#define KETTLE_LOCAL_TEMP_ATTR_DESC(inst)					\
+	ZB_ZCL_SET_ATTR_DESC_M(ZB_ZCL_ATTR_THERMOSTAT_LOCAL_TEMPERATURE_ID,	\
+		(&kettles[inst].dev_ctx.temp_measurement_attr.measured_value),	\
+		ZB_ZCL_ATTR_TYPE_S16,						\
+		ZB_ZCL_ATTR_ACCESS_READ_ONLY)
+#else
+#define KETTLE_LOCAL_TEMP_ATTR_DESC(inst)					\
+	ZB_ZCL_SET_ATTR_DESC_M(ZB_ZCL_ATTR_THERMOSTAT_LOCAL_TEMPERATURE_ID,	\
+		(&kettles[inst].dev_ctx.thermostat_attr.local_temperature),	\
+		ZB_ZCL_ATTR_TYPE_S16,						\
+		ZB_ZCL_ATTR_ACCESS_READ_ONLY | ZB_ZCL_ATTR_ACCESS_REPORTING)
+#endif
+
+#ifdef CONFIG_ZIGBEE_FOTA
+#define KETTLE_FOTA_ENDPOINT_ASSERT(inst)					\
+	BUILD_ASSERT(DT_INST_PROP(inst, zigbee_endpoint) != CONFIG_ZIGBEE_FOTA_ENDPOINT, \
+		     "zigbee-endpoint collides with CONFIG_ZIGBEE_FOTA_ENDPOINT");
+#else
+#define KETTLE_FOTA_ENDPOINT_ASSERT(inst)
+#endif
+
+/* Attribute lists, cluster list and endpoint of kettle <inst> */
+#define KETTLE_ZCL_DECLARE(inst)					\
+ZB_ZCL_DECLARE_BASIC_ATTRIB_LIST_EXT(					\
+	basic_attr_list_##inst,						\
+	&kettles[inst].dev_ctx.basic_attr.zcl_version,			\
+	&kettles[inst].dev_ctx.basic_attr.app_version,			\
+	&kettles[inst].dev_ctx.basic_attr.stack_version,		\
+	&kettles[inst].dev_ctx.basic_attr.hw_version,			\
+	kettles[inst].dev_ctx.basic_attr.mf_name,			\
+	kettles[inst].dev_ctx.basic_attr.model_id,			\
+	kettles[inst].dev_ctx.basic_attr.date_code,			\
+	&kettles[inst].dev_ctx.basic_attr.power_source,			\
+	kettles[inst].dev_ctx.basic_attr.location_id,			\
+	&kettles[inst].dev_ctx.basic_attr.ph_env,			\
+	kettles[inst].dev_ctx.basic_attr.sw_ver);			\
+									\
+ZB_ZCL_DECLARE_IDENTIFY_ATTRIB_LIST(					\
+	identify_attr_list_##inst,					\
+	&kettles[inst].dev_ctx.identify_attr.identify_time);		\
+									\
+ZB_ZCL_DECLARE_GROUPS_ATTRIB_LIST(					\
+	groups_attr_list_##inst,					\
+	&kettles[inst].dev_ctx.groups_attr.name_support);		\
+									\
+ZB_ZCL_START_DECLARE_ATTRIB_LIST_CLUSTER_REVISION(on_off_attr_list_##inst, ZB_ZCL_ON_OFF) \
+ZB_ZCL_SET_ATTR_DESC_M(ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID,			\
+	(&kettles[inst].dev_ctx.on_off_attr.on_off),			\
+	ZB_ZCL_ATTR_TYPE_BOOL,						\
+	ZB_ZCL_ATTR_ACCESS_READ_WRITE | ZB_ZCL_ATTR_ACCESS_REPORTING)	\
+ZB_ZCL_FINISH_DECLARE_ATTRIB_LIST;					\
+									\
+ZB_ZCL_START_DECLARE_ATTRIB_LIST_CLUSTER_REVISION(thermostat_attr_list_##inst, ZB_ZCL_THERMOSTAT) \
+KETTLE_LOCAL_TEMP_ATTR_DESC(inst)					\
+ZB_ZCL_SET_ATTR_DESC(ZB_ZCL_ATTR_THERMOSTAT_OCCUPIED_COOLING_SETPOINT_ID,	\
+	(&kettles[inst].dev_ctx.thermostat_attr.occupied_cooling_setpoint))	\
+ZB_ZCL_SET_ATTR_DESC_M(ZB_ZCL_ATTR_THERMOSTAT_OCCUPIED_HEATING_SETPOINT_ID,	\
+	(&kettles[inst].dev_ctx.thermostat_attr.occupied_heating_setpoint),	\
+	ZB_ZCL_ATTR_TYPE_S16,						\
+	ZB_ZCL_ATTR_ACCESS_READ_WRITE | ZB_ZCL_ATTR_ACCESS_REPORTING)	\
+ZB_ZCL_SET_ATTR_DESC(ZB_ZCL_ATTR_THERMOSTAT_MIN_HEAT_SETPOINT_LIMIT_ID,	\
+	(&kettles[inst].dev_ctx.thermostat_attr.min_heat_setpoint_limit))	\
+ZB_ZCL_SET_ATTR_DESC(ZB_ZCL_ATTR_THERMOSTAT_MAX_HEAT_SETPOINT_LIMIT_ID,	\
+	(&kettles[inst].dev_ctx.thermostat_attr.max_heat_setpoint_limit))	\
+ZB_ZCL_SET_ATTR_DESC(ZB_ZCL_ATTR_THERMOSTAT_CONTROL_SEQUENCE_OF_OPERATION_ID,	\
+	(&kettles[inst].dev_ctx.thermostat_attr.control_sequence))	\
+ZB_ZCL_SET_ATTR_DESC_M(ZB_ZCL_ATTR_THERMOSTAT_SYSTEM_MODE_ID,		\
+	(&kettles[inst].dev_ctx.thermostat_attr.system_mode),		\
+	ZB_ZCL_ATTR_TYPE_8BIT_ENUM,					\
+	ZB_ZCL_ATTR_ACCESS_READ_WRITE | ZB_ZCL_ATTR_ACCESS_REPORTING)	\
+ZB_ZCL_SET_MANUF_SPEC_ATTR_DESC(ZB_ZCL_ATTR_THERMOSTAT_KETTLE_TIME_TO_SETPOINT_ID, \
+	ZB_ZCL_ATTR_TYPE_U16,						\
+	ZB_ZCL_ATTR_ACCESS_READ_ONLY | ZB_ZCL_ATTR_ACCESS_REPORTING,	\
+	ZB_KETTLE_MANUF_CODE,						\
+	(&kettles[inst].dev_ctx.thermostat_attr.time_to_setpoint))	\
+ZB_ZCL_FINISH_DECLARE_ATTRIB_LIST;					\
+									\
+ZB_ZCL_START_DECLARE_ATTRIB_LIST_CLUSTER_REVISION(temp_measurement_attr_list_##inst, ZB_ZCL_TEMP_MEASUREMENT) \
+ZB_ZCL_SET_ATTR_DESC_M(ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_ID,		\
+	(&kettles[inst].dev_ctx.temp_measurement_attr.measured_value),	\
+	ZB_ZCL_ATTR_TYPE_S16,						\
+	ZB_ZCL_ATTR_ACCESS_READ_ONLY | ZB_ZCL_ATTR_ACCESS_REPORTING)	\
+ZB_ZCL_SET_ATTR_DESC(ZB_ZCL_ATTR_TEMP_MEASUREMENT_MIN_VALUE_ID,		\
+	(&kettles[inst].dev_ctx.temp_measurement_attr.min_measured_value))	\
+ZB_ZCL_SET_ATTR_DESC(ZB_ZCL_ATTR_TEMP_MEASUREMENT_MAX_VALUE_ID,		\
+	(&kettles[inst].dev_ctx.temp_measurement_attr.max_measured_value))	\
+ZB_ZCL_FINISH_DECLARE_ATTRIB_LIST;					\
+									\
+ZB_ZCL_START_DECLARE_ATTRIB_LIST_CLUSTER_REVISION(kettle_attr_list_##inst, ZB_ZCL_KETTLE) \
+ZB_ZCL_SET_MANUF_SPEC_ATTR_DESC(ZB_ZCL_ATTR_KETTLE_CALIBRATION_STATE_ID,	\
+	ZB_ZCL_ATTR_TYPE_8BIT_ENUM,					\
+	ZB_ZCL_ATTR_ACCESS_READ_ONLY,					\
+	ZB_KETTLE_MANUF_CODE,						\
+	(&kettles[inst].dev_ctx.kettle_attr.calibration_state))		\
+ZB_ZCL_SET_MANUF_SPEC_ATTR_DESC(ZB_ZCL_ATTR_KETTLE_CALIBRATION_POINTS_ID,	\
+	ZB_ZCL_ATTR_TYPE_8BITMAP,					\
+	ZB_ZCL_ATTR_ACCESS_READ_ONLY,					\
+	ZB_KETTLE_MANUF_CODE,						\
+	(&kettles[inst].dev_ctx.kettle_attr.calibration_points))	\
+ZB_ZCL_SET_MANUF_SPEC_ATTR_DESC(ZB_ZCL_ATTR_KETTLE_AMBIENT_REFERENCE_ID,	\
+	ZB_ZCL_ATTR_TYPE_S16,						\
+	ZB_ZCL_ATTR_ACCESS_READ_WRITE,					\
+	ZB_KETTLE_MANUF_CODE,						\
+	(&kettles[inst].dev_ctx.kettle_attr.ambient_reference))		\
+ZB_ZCL_SET_MANUF_SPEC_ATTR_DESC(ZB_ZCL_ATTR_KETTLE_BOIL_REFERENCE_ID,	\
+	ZB_ZCL_ATTR_TYPE_S16,						\
+	ZB_ZCL_ATTR_ACCESS_READ_WRITE,					\
+	ZB_KETTLE_MANUF_CODE,						\
+	(&kettles[inst].dev_ctx.kettle_attr.boil_reference))		\
+ZB_ZCL_SET_MANUF_SPEC_ATTR_DESC(ZB_ZCL_ATTR_KETTLE_WATER_READY_ID,	\
+	ZB_ZCL_ATTR_TYPE_8BIT_ENUM,					\
+	ZB_ZCL_ATTR_ACCESS_READ_ONLY | ZB_ZCL_ATTR_ACCESS_REPORTING,	\
+	ZB_KETTLE_MANUF_CODE,						\
+	(&kettles[inst].dev_ctx.kettle_attr.water_ready))		\
+ZB_ZCL_SET_MANUF_SPEC_ATTR_DESC(ZB_ZCL_ATTR_KETTLE_STREAM_INTERVAL_ID,	\
+	ZB_ZCL_ATTR_TYPE_U16,						\
+	ZB_ZCL_ATTR_ACCESS_READ_WRITE,					\
+	ZB_KETTLE_MANUF_CODE,						\
+	(&kettles[inst].dev_ctx.kettle_attr.stream_interval))		\
+ZB_ZCL_SET_MANUF_SPEC_ATTR_DESC(ZB_ZCL_ATTR_KETTLE_HEATING_STATE_ID,	\
+	ZB_ZCL_ATTR_TYPE_8BIT_ENUM,					\
+	ZB_ZCL_ATTR_ACCESS_READ_ONLY | ZB_ZCL_ATTR_ACCESS_REPORTING,	\
+	ZB_KETTLE_MANUF_CODE,						\
+	(&kettles[inst].dev_ctx.kettle_attr.heating_state))		\
+ZB_ZCL_FINISH_DECLARE_ATTRIB_LIST;					\
+									\
+ZB_DECLARE_KETTLE_CLUSTER_LIST(						\
+	kettle_clusters_##inst,						\
+	basic_attr_list_##inst,						\
+	identify_attr_list_##inst,					\
+	groups_attr_list_##inst,					\
+	on_off_attr_list_##inst,					\
+	thermostat_attr_list_##inst,					\
+	temp_measurement_attr_list_##inst,				\
+	kettle_attr_list_##inst,					\
+	diag_attr_list);						\
+									\
+ZB_DECLARE_KETTLE_EP(							\
+	kettle_ep_##inst,						\
+	DT_INST_PROP(inst, zigbee_endpoint),				\
+	kettle_clusters_##inst);					\
+									\
+BUILD_ASSERT(DT_INST_PROP(inst, zigbee_endpoint) >= 1 &&		\
+	     DT_INST_PROP(inst, zigbee_endpoint) <= 240,		\
+	     "zigbee-endpoint must be an application endpoint (1-240)");	\
+KETTLE_FOTA_ENDPOINT_ASSERT(inst)
+
+ZB_DECLARE_KETTLE_SIMPLE_DESC_TYPE(ZB_KETTLE_IN_CLUSTER_NUM, ZB_KETTLE_OUT_CLUSTER_NUM);
+
+DT_INST_FOREACH_STATUS_OKAY(KETTLE_ZCL_DECLARE)
+
+#define KETTLE_EP_PTR(inst) &kettle_ep_##inst,
+
+#ifdef CONFIG_ZIGBEE_FOTA
+extern zb_af_endpoint_desc_t zigbee_fota_client_ep;
+
+ZBOSS_DECLARE_DEVICE_CTX_EP_VA(
+	kettle_zb_ctx,
+	&zigbee_fota_client_ep,
+	DT_INST_FOREACH_STATUS_OKAY(KETTLE_EP_PTR));
+#else
+ZBOSS_DECLARE_DEVICE_CTX_EP_VA(
+	kettle_zb_ctx,
+	DT_INST_FOREACH_STATUS_OKAY(KETTLE_EP_PTR));
+#endif
+
+/* ==========================================================================
+ * Temperature Conversion Functions
+ *
+ * Both conversions (adc_to_target_temp() and adc_to_current_temp() in
+ * kettle_sense.c) are a single lookup in tables generated at build time by
+ * scripts/gen_temp_lut.py from CONFIG_KETTLE_CALIBRATION_FILE. Change the
+ * calibration points there, not here. A field calibration swaps in per-unit
+ * RAM tables of the same shape (see Field Calibration).
+ *
+ * Target dial: outputs 0-5V but NOT linear. We read through buffer + 2:1
+ * divider. Calibration points (original voltage before divider):
+ *   0.0V = 100°C,  0.8V = 95°C,  1.7V = 90°C,  2.6V = 80°C
+ *   3.7V = 70°C,   4.5V = 60°C,  5.0V = 50°C
+ *
+ * Current temperature: NTC thermistor, physics-based calibration points.
+ *   Circuit: 5V -> R_fixed -> junction -> NTC -> GND
+ *   V_junction = Vcc * R_ntc / (R_fixed + R_ntc)
+ *   NTC model: R(T) = R25 * exp(Beta * (1/T - 1/298.15)), Beta ≈ 2720K
+ *   fitted from ambient ~20°C at ~1076mV and boiling ~99°C at ~3260mV.
+ *   Codes below the off-base threshold map to TEMP_INVALID_ZB.
+ * ========================================================================== */
+
+BUILD_ASSERT(KETTLE_TEMP_LUT_CODES == ADC_MAX_VALUE + 1,
+	     "Temperature tables generated for a different ADC resolution");
+BUILD_ASSERT(KETTLE_TEMP_LUT_DIVIDER_RATIO == ADC_DIVIDER_RATIO,
+	     "Temperature tables generated for a different divider");
+
+/* Tables in use (kettle_ctx.temp_tables): built-in, or per-unit after a
+ * field calibration; kettles_init() starts every kettle on the built-in ones
+ */
+
+/* ==========================================================================
+ * Field Calibration
+ *
+ * Per-unit correction of the built-in tables. Reference points are captured
+ * from the filtered ADC codes while calibration mode is active, entered via
+ * the Kettle cluster or a triple press of the pairing button (each further
+ * press captures the ambient, then the boil point and finishes). Finishing
+ * refits RAM tables that the conversions index exactly like the built-in
+ * ones, so a calibrated reading costs nothing extra.
+ *
+ * - NTC: ambient and boil points correct the built-in curve linearly in the
+ *   temperature domain (one point shifts it, two fix the gain as well).
+ * - Dial: codes read at the end stops are stretched onto the built-in end
+ *   stop codes (one point shifts them).
+ *
+ * Each kettle has its own points, tables and session. The pairing button
+ * calibrates the first kettle; the others go through their Kettle cluster.
+ * Only the points are persisted; the tables are rebuilt at boot.
+ * ========================================================================== */
+
+#define CAL_VERSION             1
+#define CAL_TIMEOUT_MS          (30 * 60 * 1000)    /* Abandon an unfinished session */
+#define CAL_NTC_MIN_SPAN_ZB     1000                /* Two NTC points >= 10°C apart */
+#define CAL_REF_DEFAULT         ((int16_t)0x8000)   /* Capture: use the reference attribute */
+#define CAL_AMBIENT_REF_ZB      2000                /* Default ambient reference (20°C) */
+#define CAL_BOIL_REF_ZB         TEMP_MAX_ZB         /* Default boil reference (sea level) */
+
+#define CAL_NTC_POINTS          (BIT(ZB_KETTLE_CAL_POINT_AMBIENT) | BIT(ZB_KETTLE_CAL_POINT_BOIL))
+#define CAL_DIAL_POINTS         (BIT(ZB_KETTLE_CAL_POINT_DIAL_MAX) | BIT(ZB_KETTLE_CAL_POINT_DIAL_MIN))
+
+/* Built-in dial end stops: last code reading 100°C, first code reading 50°C */
+static void cal_dial_end_stops(int32_t *code_max, int32_t *code_min)
+{
+	int32_t c = 0;
+
+	while (c < ADC_MAX_VALUE && kettle_target_temp_lut[c + 1] >= TEMP_MAX_ZB) {
+		c++;
+	}
+	*code_max = c;
+
+	while (c < ADC_MAX_VALUE && kettle_target_temp_lut[c] > TEMP_MIN_ZB) {
+		c++;
+	}
+	*code_min = c;
+}
+
+/**
+ * Check that a set of points can be fitted.
+ *
+ * Also guards the table indices: points are loaded from flash.
+ *
+ * @return 0 or -EINVAL
+ */
+static int cal_validate(const struct kettle_calibration *cal)
+{
+	for (int i = 0; i < ZB_KETTLE_CAL_POINT_COUNT; i++) {
+		if ((cal->points & BIT(i)) && !IN_RANGE(cal->code[i], 0, ADC_MAX_VALUE)) {
+			return -EINVAL;
+		}
+		if ((cal->points & BIT(i) & CAL_NTC_POINTS) &&
+		    cal->code[i] < KETTLE_OFF_BASE_CODE) {
+			return -EINVAL;
+		}
+	}
+
+	if ((cal->points & CAL_NTC_POINTS) == CAL_NTC_POINTS) {
+		int32_t ref_span = cal->ref[ZB_KETTLE_CAL_POINT_BOIL] -
+				   cal->ref[ZB_KETTLE_CAL_POINT_AMBIENT];
+		int32_t lut_span = kettle_current_temp_lut[cal->code[ZB_KETTLE_CAL_POINT_BOIL]] -
+				   kettle_current_temp_lut[cal->code[ZB_KETTLE_CAL_POINT_AMBIENT]];
+
+		if (ref_span < CAL_NTC_MIN_SPAN_ZB || lut_span < CAL_NTC_MIN_SPAN_ZB) {
+			LOG_WRN("Calibration: NTC points too close (%d/%d)", ref_span, lut_span);
+			return -EINVAL;
+		}
+		/* Gain outside 3/4..4/3 is a bad capture, not drift */
+		if (4 * ref_span < 3 * lut_span || 3 * ref_span > 4 * lut_span) {
+			LOG_WRN("Calibration: NTC gain out of range (%d/%d)", ref_span, lut_span);
+			return -EINVAL;
+		}
+	}
+
+	if ((cal->points & CAL_DIAL_POINTS) == CAL_DIAL_POINTS) {
+		int32_t lut_max, lut_min;
+		int32_t span = cal->code[ZB_KETTLE_CAL_POINT_DIAL_MIN] -
+			       cal->code[ZB_KETTLE_CAL_POINT_DIAL_MAX];
+
+		cal_dial_end_stops(&lut_max, &lut_min);
+		if (2 * span < lut_min - lut_max || span > 2 * (lut_min - lut_max)) {
+			LOG_WRN("Calibration: dial span out of range (%d)", span);
+			return -EINVAL;
+		}
+	}
+
+	return 0;
+}
+
+/* Rebuild the water temperature table from the NTC points */
+static void cal_fit_ntc(struct kettle_ctx *kettle, const struct kettle_calibration *cal)
+{
+	uint8_t points = cal->points & CAL_NTC_POINTS;
+
+	if (!points) {
+		kettle->temp_tables.current = kettle_current_temp_lut;
+		return;
+	}
+
+	int a = (points & BIT(ZB_KETTLE_CAL_POINT_AMBIENT)) ?
+		ZB_KETTLE_CAL_POINT_AMBIENT : ZB_KETTLE_CAL_POINT_BOIL;
+	int32_t lut_a = kettle_current_temp_lut[cal->code[a]];
+	int32_t ref_a = cal->ref[a];
+	int32_t num = 1, den = 1;
+
+	if (points == CAL_NTC_POINTS) {
+		num = cal->ref[ZB_KETTLE_CAL_POINT_BOIL] - ref_a;
+		den = kettle_current_temp_lut[cal->code[ZB_KETTLE_CAL_POINT_BOIL]] - lut_a;
+	}
+
+	for (int c = 0; c < KETTLE_TEMP_LUT_CODES; c++) {
+		int32_t t = kettle_current_temp_lut[c];
+
+		kettle->cal_current_lut[c] = (t == TEMP_INVALID_ZB) ? TEMP_INVALID_ZB :
+			CLAMP(ref_a + (t - lut_a) * num / den, 0, TEMP_MAX_ZB);
+	}
+	kettle->temp_tables.current = kettle->cal_current_lut;
+}
+
+/* Rebuild the dial table from the end stop points */
+static void cal_fit_dial(struct kettle_ctx *kettle, const struct kettle_calibration *cal)
+{
+	uint8_t points = cal->points & CAL_DIAL_POINTS;
+	int32_t lut_max, lut_min;
+
+	if (!points) {
+		kettle->temp_tables.target = kettle_target_temp_lut;
+		return;
+	}
+
+	cal_dial_end_stops(&lut_max, &lut_min);
+
+	int32_t m_max = (points & BIT(ZB_KETTLE_CAL_POINT_DIAL_MAX)) ?
+			cal->code[ZB_KETTLE_CAL_POINT_DIAL_MAX] : -1;
+	int32_t m_min = (points & BIT(ZB_KETTLE_CAL_POINT_DIAL_MIN)) ?
+			cal->code[ZB_KETTLE_CAL_POINT_DIAL_MIN] : -1;
+
+	/* A single end stop shifts the curve */
+	if (m_max < 0) {
+		m_max = m_min - (lut_min - lut_max);
+	} else if (m_min < 0) {
+		m_min = m_max + (lut_min - lut_max);
+	}
+
+	for (int c = 0; c < KETTLE_TEMP_LUT_CODES; c++) {
+		int32_t code = lut_max + (c - m_max) * (lut_min - lut_max) / (m_min - m_max);
+
+		kettle->cal_target_lut[c] = kettle_target_temp_lut[CLAMP(code, 0, ADC_MAX_VALUE)];
+	}
+	kettle->temp_tables.target = kettle->cal_target_lut;
+}
+
+/**
+ * Swap in the tables for the current calibration.
+ *
+ * Runs on the sensor workqueue, like the conversions, so a sample never
+ * sees a half-built table.
+ */
+static void calibration_apply(struct kettle_ctx *kettle)
+{
+	struct kettle_calibration cal;
+
+	k_mutex_lock(&cal_lock, K_FOREVER);
+	if (kettle->cal.points &&
+	    (kettle->cal.version != CAL_VERSION || cal_validate(&kettle->cal))) {
+		LOG_WRN("Kettle %u: stored calibration invalid, using built-in tables",
+			kettle->index);
+		memset(&kettle->cal, 0, sizeof(kettle->cal));
+	}
+	cal = kettle->cal;
+	k_mutex_unlock(&cal_lock);
+
+	cal_fit_ntc(kettle, &cal);
+	cal_fit_dial(kettle, &cal);
+	kettle->dev_ctx.kettle_attr.calibration_points = cal.points;
+
+	LOG_INF("Kettle %u: calibration applied (points 0x%02x)", kettle->index, cal.points);
+}
+
+static void cal_apply_work_handler(struct k_work *work)
+{
+	calibration_apply(CONTAINER_OF(work, struct kettle_ctx, cal_apply_work));
+}
+
+static void cal_end_session(struct kettle_ctx *kettle)
+{
+	kettle->cal_session.active = false;
+	kettle->dev_ctx.kettle_attr.calibration_state = ZB_KETTLE_CAL_STATE_IDLE;
+}
+
+/* Start (or restart) a session from the points in use */
+static int calibration_start(struct kettle_ctx *kettle)
+{
+	k_mutex_lock(&cal_lock, K_FOREVER);
+	kettle->cal_session.active = true;
+	kettle->cal_session.button_point = ZB_KETTLE_CAL_POINT_AMBIENT;
+	kettle->cal_session.pending = kettle->cal;
+	kettle->cal_session.pending.version = CAL_VERSION;
+	kettle->dev_ctx.kettle_attr.calibration_state = ZB_KETTLE_CAL_STATE_ACTIVE;
+	k_mutex_unlock(&cal_lock);
+
+	k_work_reschedule(&kettle->cal_timeout_work, K_MSEC(CAL_TIMEOUT_MS));
+	LOG_INF("Kettle %u: calibration started", kettle->index);
+	return 0;
+}
+
+/**
+ * Capture a reference point from the current filtered reading.
+ *
+ * @param point ZB_KETTLE_CAL_POINT_*
+ * @param ref Reference temperature (0.01°C) for NTC points, or
+ *            CAL_REF_DEFAULT for the reference attribute; dial points use
+ *            their end stop temperature
+ * @return 0, -EPERM outside a session, -ENODATA without a reading, or -EINVAL
+ */
+static int calibration_capture(struct kettle_ctx *kettle, uint8_t point, int16_t ref)
+{
+	int32_t code;
+	int err = 0;
+
+	if (point >= ZB_KETTLE_CAL_POINT_COUNT) {
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&cal_lock, K_FOREVER);
+
+	if (!kettle->cal_session.active) {
+		err = -EPERM;
+	} else if (BIT(point) & CAL_NTC_POINTS) {
+		code = adc_filter_value(&kettle->water.filter);
+		if (ref == CAL_REF_DEFAULT) {
+			ref = (point == ZB_KETTLE_CAL_POINT_AMBIENT) ?
+			      kettle->dev_ctx.kettle_attr.ambient_reference :
+			      kettle->dev_ctx.kettle_attr.boil_reference;
+		}
+		if (code < KETTLE_OFF_BASE_CODE) {
+			err = -ENODATA;
+		} else if (!IN_RANGE(ref, 0, TEMP_MAX_ZB)) {
+			err = -EINVAL;
+		}
+	} else {
+		code = adc_filter_value(&kettle->adc_target_filter);
+		ref = (point == ZB_KETTLE_CAL_POINT_DIAL_MAX) ? TEMP_MAX_ZB : TEMP_MIN_ZB;
+		if (code < 0) {
+			err = -ENODATA;
+		}
+	}
+
+	if (!err) {
+		kettle->cal_session.pending.code[point] = code;
+		kettle->cal_session.pending.ref[point] = ref;
+		kettle->cal_session.pending.points |= BIT(point);
+	}
+
+	k_mutex_unlock(&cal_lock);
+
+	if (err) {
+		LOG_WRN("Kettle %u: calibration point %d not captured: %d",
+			kettle->index, point, err);
+	} else {
+		LOG_INF("Kettle %u: calibration point %d: code %d, reference %d.%02d°C",
+			kettle->index, point, code, ref / 100, ref % 100);
+	}
+	return err;
+}
+
+/* Fit, apply and persist the session's points; the session stays open on failure */
+static int calibration_finish(struct kettle_ctx *kettle)
+{
+	int err = 0;
+
+	k_mutex_lock(&cal_lock, K_FOREVER);
+	if (!kettle->cal_session.active) {
+		err = -EPERM;
+	} else {
+		err = cal_validate(&kettle->cal_session.pending);
+	}
+	if (!err) {
+		kettle->cal = kettle->cal_session.pending;
+		cal_end_session(kettle);
+	}
+	k_mutex_unlock(&cal_lock);
+
+	if (err) {
+		return err;
+	}
+
+	k_work_cancel_delayable(&kettle->cal_timeout_work);
+	k_work_submit_to_queue(&sensor_wq, &kettle->cal_apply_work);
+	persist_mark(kettle, PERSIST_CALIBRATION);
+	LOG_INF("Kettle %u: calibration finished", kettle->index);
+	return 0;
+}
+
+static void calibration_cancel(struct kettle_ctx *kettle)
+{
+	k_mutex_lock(&cal_lock, K_FOREVER);
+	cal_end_session(kettle);
+	k_mutex_unlock(&cal_lock);
+
+	k_work_cancel_delayable(&kettle->cal_timeout_work);
+	LOG_INF("Kettle %u: calibration cancelled", kettle->index);
+}
+
+/* Drop the per-unit calibration and go back to the built-in tables */
+static void calibration_reset(struct kettle_ctx *kettle)
+{
+	k_mutex_lock(&cal_lock, K_FOREVER);
+	memset(&kettle->cal, 0, sizeof(kettle->cal));
+	kettle->cal.version = CAL_VERSION;
+	cal_end_session(kettle);
+	k_mutex_unlock(&cal_lock);
+
+	k_work_cancel_delayable(&kettle->cal_timeout_work);
+	k_work_submit_to_queue(&sensor_wq, &kettle->cal_apply_work);
+	persist_mark(kettle, PERSIST_CALIBRATION);
+	LOG_INF("Kettle %u: calibration reset to built-in tables", kettle->index);
+}
+
+static void cal_timeout_work_handler(struct k_work *work)
+{
+	struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+	struct kettle_ctx *kettle = CONTAINER_OF(dwork, struct kettle_ctx, cal_timeout_work);
+
+	LOG_WRN("Kettle %u: calibration timed out", kettle->index);
+	calibration_cancel(kettle);
+}
+
+/* Pairing button in a session: capture ambient, then boil and finish */
+static void calibration_button_press(struct kettle_ctx *kettle)
+{
+	uint8_t point = kettle->cal_session.button_point;
+
+	if (calibration_capture(kettle, point, CAL_REF_DEFAULT)) {
+		return;  /* e.g. off base - press again */
+	}
+
+	if (point == ZB_KETTLE_CAL_POINT_AMBIENT) {
+		kettle->cal_session.button_point = ZB_KETTLE_CAL_POINT_BOIL;
+	} else if (calibration_finish(kettle)) {
+		LOG_WRN("Calibration rejected, capture again or cancel");
+		kettle->cal_session.button_point = ZB_KETTLE_CAL_POINT_AMBIENT;
+	}
+}
+
+/* ==========================================================================
+ * Diagnostics
+ *
+ * Timing histograms of the hot paths, served by the manufacturer-specific
+ * Diagnostics cluster (0xFC01) so they can be watched across the fleet.
+ * Timestamps come from k_cycle_get_32() (1us GRTC ticks on nRF54L15, no
+ * DWT needed); recording is a clz and an increment.
+ *
+ * Each histogram attribute is an octet string holding the largest sample in
+ * us (U32) and DIAG_HIST_BUCKETS log2 bucket counts (U16): bucket 0 is below
+ * 16us, bucket n covers 2^(n+3) to 2^(n+4) us, the last is open ended. When
+ * a bucket saturates all of them are halved, so the shape is kept.
+ * Histograms are written by one thread each and read by ZBOSS without a
+ * lock; a read may be a sample behind.
+ * ========================================================================== */
+
+#define DIAG_HIST_MIN_SHIFT     4       /* Bucket 0: below 16us */
+
+static uint32_t diag_burst_cyc;             /* burst capture started */
+static uint32_t diag_adc_due_cyc;           /* adc_sample_work due */
+static uint32_t diag_buf_request_cyc;       /* delayed buffer requested */
+/* Kettle state GPIO edges are timed per kettle, see kettle_ctx.diag_edge_cyc */
+
+/* Wrap-safe microseconds since a k_cycle_get_32() timestamp */
+static inline uint32_t diag_since_us(uint32_t start_cyc)
+{
+	return k_cyc_to_us_floor32(k_cycle_get_32() - start_cyc);
+}
+
+static void diag_record(enum diag_metric metric, uint32_t us)
+{
+	diag_hist_t *hist = &diag_attr.hist[metric];
+	uint8_t bucket = 0;
+
+	if (us >= BIT(DIAG_HIST_MIN_SHIFT)) {
+		bucket = MIN(31 - __builtin_clz(us) - (DIAG_HIST_MIN_SHIFT - 1),
+			     DIAG_HIST_BUCKETS - 1);
+	}
+
+	if (hist->count[bucket] == UINT16_MAX) {
+		for (int i = 0; i < DIAG_HIST_BUCKETS; i++) {
+			hist->count[i] /= 2;
+		}
+	}
+	hist->count[bucket]++;
+	hist->max_us = MAX(hist->max_us, us);
+}
+
+/* Clear the histograms and the report counters; pressure and in-flight frames are live state */
+static void diag_reset(void)
+{
+	for (int i = 0; i < DIAG_METRIC_COUNT; i++) {
+		diag_hist_t *hist = &diag_attr.hist[i];
+
+		memset(hist, 0, sizeof(*hist));
+		hist->len = sizeof(*hist) - sizeof(hist->len);
+	}
+
+	report_stats.alloc_failures = 0;
+	report_stats.retried = 0;
+	report_stats.deferred = 0;
+	report_stats.dropped = 0;
+	report_stats.aps_failures = 0;
+	report_stats.pool_low = 0;
+	report_stats.pool_oom = 0;
+	report_stats.in_flight_max = report_stats.in_flight;
+}
+
+/* Diagnostics cluster: Reset command */
+static zb_bool_t diag_cluster_handler(zb_uint8_t param)
+{
+	zb_zcl_parsed_hdr_t cmd_info;
+	zb_uint8_t status = ZB_ZCL_STATUS_SUCCESS;
+
+	ZB_ZCL_COPY_PARSED_HEADER(param, &cmd_info);
+
+	if (cmd_info.is_common_command ||
+	    cmd_info.cmd_direction != ZB_ZCL_FRAME_DIRECTION_TO_SRV) {
+		return ZB_FALSE;
+	}
+
+	switch (cmd_info.cmd_id) {
+	case ZB_ZCL_CMD_KETTLE_DIAG_RESET:
+		diag_reset();
+		LOG_INF("Diagnostics reset");
+		break;
+
+	default:
+		status = ZB_ZCL_STATUS_UNSUP_CMD;
+		break;
+	}
+
+	ZB_ZCL_PROCESS_COMMAND_FINISH(param, &cmd_info, status);
+	return ZB_TRUE;
+}
+
+void zb_zcl_kettle_diag_init_server(void)
+{
+	zb_zcl_add_cluster_handlers(ZB_ZCL_CLUSTER_ID_KETTLE_DIAGNOSTICS, ZB_ZCL_CLUSTER_SERVER_ROLE,
+				    NULL, NULL, diag_cluster_handler);
+}
+
+/* ==========================================================================
+ * ADC Sampling
+ * ========================================================================== */
+
+/* Forward declarations for reporting helpers */
+static void report_changed(struct kettle_ctx *kettle, uint32_t mask);
+static void stream_sample(struct kettle_ctx *kettle, int16_t temp);
+static void stream_flush_now(struct kettle_ctx *kettle);
+
+/* Microsecond clock of the phase tracker; wraps every ~71 minutes */
+static inline uint32_t burst_clock_us(void)
+{
+#ifdef CONFIG_TIMER_HAS_64BIT_CYCLE_COUNTER
+	return (uint32_t)k_cyc_to_us_floor64(k_cycle_get_64());
+#else
+	return (uint32_t)k_ticks_to_us_floor64(k_uptime_ticks());
+#endif
+}
+
+/* Timestamp the first and last conversion so phase maths uses real times */
+static enum adc_action burst_sample_cb(const struct device *dev,
+				       const struct adc_sequence *sequence,
+				       uint16_t sampling_index)
+{
+	ARG_UNUSED(dev);
+
+	uint32_t now = burst_clock_us();
+
+	if (sampling_index == 0) {
+		burst_first_us = now;
+	}
+	if (sampling_index == sequence->options->extra_samplings) {
+		burst_last_us = now;
+	}
+	return ADC_ACTION_CONTINUE;
+}
+
+/**
+ * Start a background burst capture of one or more ADC channels.
+ *
+ * The SAADC driver triggers each sampling every BURST_SAMPLE_INTERVAL_US
+ * and EasyDMA writes the results straight into burst_samples[], so neither
+ * the CPU nor the workqueue is held for the capture window. Completion
+ * raises burst_signal, which submits burst_done_work. With several channels
+ * every sampling scans all of them, see burst_scan_samples().
+ *
+ * @param adc_spec ADC channel to sample (the others share its device and settings)
+ * @param channels BIT(channel id) of every channel to sample
+ * @param count Number of samplings (1..BURST_SAMPLE_COUNT)
+ * @return 0 if the capture was started, negative errno otherwise
+ */
+static int burst_sample_start(const struct adc_dt_spec *adc_spec, uint32_t channels,
+			      uint8_t count)
+{
+	int ret;
+
+	ret = adc_sequence_init_dt(adc_spec, &burst_sequence);
+	if (ret != 0) {
+		LOG_WRN_HOT("Burst sample: sequence init failed: %d", ret);
+		return ret;
+	}
+	burst_options.interval_us = BURST_SAMPLE_INTERVAL_US;
+	burst_options.extra_samplings = count - 1;
+	burst_options.callback = burst_sample_cb;
+	burst_sequence.options = &burst_options;
+	burst_sequence.channels = channels;
+	burst_sequence.buffer = burst_samples;
+	burst_sequence.buffer_size =
+		count * __builtin_popcount(channels) * sizeof(burst_samples[0]);
+
+	k_poll_signal_reset(&burst_signal);
+	burst_event.state = K_POLL_STATE_NOT_READY;
+
+	ret = k_work_poll_submit_to_queue(&sensor_wq, &burst_done_work, &burst_event, 1, K_FOREVER);
+	if (ret != 0) {
+		LOG_WRN_HOT("Burst sample: completion work submit failed: %d", ret);
+		return ret;
+	}
+
+	ret = adc_read_async(adc_spec->dev, &burst_sequence, &burst_signal);
+	if (ret != 0) {
+		LOG_WRN_HOT("Burst sample: capture start failed: %d", ret);
+		k_work_poll_cancel(&burst_done_work);
+		return ret;
+	}
+
+	return 0;
+}
+
+/**
+ * Copy one kettle's water conversions out of the last capture.
+ *
+ * A scan stores each sampling's conversions in ascending channel order, so
+ * the kettle's are every n-th value, n being the number of channels.
+ *
+ * @param kettle Kettle whose water channel to extract
+ * @param samples Output, one value per sampling
+ * @param count Number of samplings in the capture
+ */
+static void burst_scan_samples(const struct kettle_ctx *kettle, int16_t *samples, uint8_t count)
+{
+	uint32_t channels = burst_sequence.channels;
+	uint8_t stride = __builtin_popcount(channels);
+	uint8_t pos = __builtin_popcount(channels & (BIT(kettle->hw->adc_current.channel_id) - 1));
+
+	for (uint8_t i = 0; i < count; i++) {
+		samples[i] = burst_samples[i * stride + pos];
+	}
+}
+
+/** Measured spacing of the samplings of the last capture, in microseconds */
+static uint32_t burst_interval_us(uint8_t count)
+{
+	return (burst_last_us - burst_first_us) / (count - 1);
+}
+
+/**
+ * Evaluate a kettle's part of a completed capture to handle pulsed signals.
+ *
+ * The current temperature signal is pulsed at ~50Hz - it goes high during
+ * part of each cycle. A full burst samples rapidly over multiple cycles and
+ * takes a low percentile to capture the true analog level when the pulse is
+ * low, and teaches the phase tracker where that low window is. A locked
+ * capture samples only inside the window.
+ *
+ * @param kettle Kettle to evaluate, one of the capture's burst_scan
+ * @param adc Output low-percentile ADC value
+ * @return 0 on success, -EAGAIN if a locked capture lost lock and a full
+ *         burst is needed
+ */
+static int burst_sample_eval(struct kettle_ctx *kettle, int16_t *adc)
+{
+	int16_t samples[BURST_SAMPLE_COUNT];
+
+	if (burst_locked) {
+		burst_scan_samples(kettle, samples, PHASE_LOCKED_SAMPLE_COUNT);
+		if (burst_phase_track(&kettle->burst_phase, samples, burst_first_us,
+				      burst_interval_us(PHASE_LOCKED_SAMPLE_COUNT), adc) != 0) {
+			LOG_DBG("Phase %u: lock lost", kettle->index);
+			return -EAGAIN;
+		}
+		return 0;
+	}
+
+	struct burst_stats stats;
+
+	burst_scan_samples(kettle, samples, BURST_SAMPLE_COUNT);
+	burst_select(samples, BURST_SAMPLE_COUNT, BURST_PERCENTILE_INDEX, &stats);
+
+	/* Log burst statistics for debugging */
+	LOG_DBG("Burst %u: min=%d, p10=%d, median=%d, max=%d",
+		kettle->index, stats.min, stats.low, stats.median, stats.max);
+
+	burst_phase_learn(&kettle->burst_phase, samples, &stats, burst_first_us,
+			  burst_interval_us(BURST_SAMPLE_COUNT));
+	if (kettle->burst_phase.locked) {
+		LOG_DBG("Phase %u locked: period=%uus", kettle->index,
+			(unsigned int)kettle->burst_phase.period_us);
+	} else {
+		LOG_DBG("Phase %u: no usable low window", kettle->index);
+	}
+
+	/* Return the 10th percentile value (low but not minimum, for noise robustness) */
+	*adc = stats.low;
+	return 0;
+}
+
+/** Check that the capture in flight completed, -EIO if it failed */
+static int burst_sample_finish(void)
+{
+	unsigned int signaled;
+	int result;
+
+	k_poll_signal_check(&burst_signal, &signaled, &result);
+	if (!signaled || result != 0) {
+		LOG_WRN_HOT("Burst capture failed: %d", result);
+		return -EIO;
+	}
+	return 0;
+}
+
+/* ==========================================================================
+ * Sampling Policy
+ *
+ * The interval to the next sampling cycle follows what the kettle is doing:
+ * fast while the dial turns or the kettle heats, default while the water
+ * temperature moves, and slow when idle or lifted off the base.
+ * ========================================================================== */
+
+/* Note when adc_sample_work is due, for DIAG_WORKQUEUE_LATENCY */
+static void adc_sample_due(uint32_t delay_ms)
+{
+	diag_adc_due_cyc = k_cycle_get_32() + k_ms_to_cyc_ceil32(delay_ms);
+}
+
+/**
+ * Run a sampling cycle as soon as possible.
+ *
+ * Safe from any context. If a cycle is already in flight, the next one
+ * starts right after it completes instead.
+ */
+static void request_adc_sample_now(void)
+{
+	atomic_set_bit(&adc_cycle_flags, ADC_CYCLE_REQUESTED);
+	if (!atomic_test_bit(&adc_cycle_flags, ADC_CYCLE_BUSY)) {
+		adc_sample_due(0);
+		k_work_reschedule_for_queue(&sensor_wq, &adc_sample_work, K_NO_WAIT);
+	}
+}
+
+/**
+ * End the current sampling cycle and schedule the next one.
+ *
+ * The cycle samples every kettle, so it runs at the pace of the busiest.
+ */
+static void adc_cycle_finish(void)
+{
+	atomic_clear_bit(&adc_cycle_flags, ADC_CYCLE_BUSY);
+
+	if (atomic_test_and_clear_bit(&adc_cycle_flags, ADC_CYCLE_REQUESTED)) {
+		adc_sample_due(0);
+		k_work_reschedule_for_queue(&sensor_wq, &adc_sample_work, K_NO_WAIT);
+	} else {
+		int64_t now = k_uptime_get();
+		uint32_t interval_ms = UINT32_MAX;
+
+		ARRAY_FOR_EACH_PTR(kettles, kettle) {
+			interval_ms = MIN(interval_ms, adc_sample_interval_ms(
+				now < kettle->adc_policy.dial_active_until, kettle->heating_state,
+				kettle->dev_ctx.temp_measurement_attr.measured_value,
+				kettle->water.slope));
+		}
+
+		adc_sample_due(interval_ms);
+		k_work_schedule_for_queue(&sensor_wq, &adc_sample_work, K_MSEC(interval_ms));
+
+		adc_cycle_interval_ms = interval_ms;
+		if (interval_ms > ADC_DIAL_WATCH_MS) {
+			/* No-op while the watch is already pending */
+			k_work_schedule_for_queue(&sensor_wq, &adc_dial_watch_work,
+						  K_MSEC(ADC_DIAL_WATCH_MS));
+		}
+	}
+}
+
+/**
+ * Dial watch (sensor workqueue): between slow cycles, read the dial alone
+ * every ADC_DIAL_WATCH_MS and start a cycle as soon as it moves, so a turn
+ * from idle is followed within ADC_DIAL_WATCH_MS rather than on the next
+ * ADC_INTERVAL_IDLE_MS cycle. adc_cycle_finish() starts it when the next
+ * cycle is further away than ADC_DIAL_WATCH_MS; it stops itself once the
+ * cycles read the dial at least that often (heating, dial turning).
+ */
+static void adc_dial_watch_work_handler(struct k_work *work)
+{
+	int16_t code;
+	struct adc_sequence sequence = {
+		.buffer = &code,
+		.buffer_size = sizeof(code),
+	};
+
+	if (adc_cycle_interval_ms <= ADC_DIAL_WATCH_MS) {
+		return;
+	}
+
+	k_work_schedule_for_queue(&sensor_wq, k_work_delayable_from_work(work),
+				  K_MSEC(ADC_DIAL_WATCH_MS));
+
+	if (atomic_test_bit(&adc_cycle_flags, ADC_CYCLE_BUSY)) {
+		return;
+	}
+
+	/* One conversion per dial: ADC_DIAL_WATCH_CODES is well above its noise,
+	 * and the cycle this starts takes the oversampled reading
+	 */
+	ARRAY_FOR_EACH_PTR(kettles, kettle) {
+		if (kettle->adc_policy.dial_code < 0 ||
+		    k_uptime_get() < kettle->adc_policy.dial_active_until) {
+			continue;
+		}
+
+		if (adc_sequence_init_dt(&kettle->hw->adc_target, &sequence) != 0) {
+			continue;
+		}
+		sequence.oversampling = 0;
+		if (adc_read_dt(&kettle->hw->adc_target, &sequence) != 0) {
+			continue;
+		}
+
+		int32_t moved = code - kettle->adc_policy.dial_code;
+
+		if (moved >= ADC_DIAL_WATCH_CODES || moved <= -ADC_DIAL_WATCH_CODES) {
+			request_adc_sample_now();
+			return;
+		}
+	}
+}
+
+/* ==========================================================================
+ * Time-to-Setpoint Estimation
+ *
+ * While heating, a least-squares line is fitted to the last TTS_WINDOW
+ * water temperature samples. Running sums keep each update O(1). The
+ * fitted temperature now and the slope give the seconds until the dial
+ * setpoint is reached.
+ * ========================================================================== */
+
+#define TTS_MIN_SAMPLES         8       /* Samples before the first estimate */
+#define TTS_MIN_SLOPE           2       /* 0.01°C/s; flatter than this stays unknown */
+#define TTS_TICK_MS             100     /* Time unit of the fit */
+#define TTS_MAX_FIT_MS          (30 * 60 * 1000) /* Restart the fit to bound the sums */
+#define TTS_UNKNOWN             0xFFFF
+
+/** Publish a new estimate; the stack reports it on a significant change */
+static void tts_publish(struct kettle_ctx *kettle, uint16_t seconds)
+{
+	if (kettle->dev_ctx.thermostat_attr.time_to_setpoint == seconds) {
+		return;
+	}
+	kettle->dev_ctx.thermostat_attr.time_to_setpoint = seconds;
+	zb_zcl_mark_attr_for_reporting_manuf(kettle->hw->endpoint, ZB_ZCL_CLUSTER_ID_THERMOSTAT,
+		ZB_ZCL_CLUSTER_SERVER_ROLE, ZB_ZCL_ATTR_THERMOSTAT_KETTLE_TIME_TO_SETPOINT_ID,
+		ZB_KETTLE_MANUF_CODE);
+}
+
+/** Drop the fit and report the estimate as unknown */
+static void tts_invalidate(struct kettle_ctx *kettle)
+{
+	memset(&kettle->tts, 0, sizeof(kettle->tts));
+	tts_publish(kettle, TTS_UNKNOWN);
+}
+
+/**
+ * Add a water temperature sample to the heating fit and refresh the estimate.
+ *
+ * @param temp Water temperature (0.01°C)
+ */
+static void tts_update(struct kettle_ctx *kettle, int16_t temp)
+{
+	struct tts_fit *tts = &kettle->tts;
+	int64_t now = k_uptime_get();
+
+	if (kettle->heating_state != KETTLE_STATE_ON) {
+		tts_invalidate(kettle);
+		return;
+	}
+
+	if (tts->origin_ms == 0 || now - tts->origin_ms > TTS_MAX_FIT_MS) {
+		memset(tts, 0, sizeof(*tts));
+		tts->origin_ms = now;
+	}
+
+	int32_t t = (int32_t)((now - tts->origin_ms) / TTS_TICK_MS);
+
+	if (tts->count == TTS_WINDOW) {
+		/* Slide the window: the slot at head holds the oldest sample */
+		int32_t old_t = tts->t[tts->head];
+		int16_t old_y = tts->y[tts->head];
+
+		tts->sum_t -= old_t;
+		tts->sum_y -= old_y;
+		tts->sum_tt -= (int64_t)old_t * old_t;
+		tts->sum_ty -= (int64_t)old_t * old_y;
+	} else {
+		tts->count++;
+	}
+
+	tts->t[tts->head] = t;
+	tts->y[tts->head] = temp;
+	tts->head = (tts->head + 1) % TTS_WINDOW;
+	tts->sum_t += t;
+	tts->sum_y += temp;
+	tts->sum_tt += (int64_t)t * t;
+	tts->sum_ty += (int64_t)t * temp;
+
+	if (tts->count < TTS_MIN_SAMPLES) {
+		tts_publish(kettle, TTS_UNKNOWN);
+		return;
+	}
+
+	/* slope = num / den in 0.01°C per tick */
+	int64_t n = tts->count;
+	int64_t den = n * tts->sum_tt - tts->sum_t * tts->sum_t;
+	int64_t num = n * tts->sum_ty - tts->sum_t * tts->sum_y;
+
+	if (den <= 0 || num * (1000 / TTS_TICK_MS) < TTS_MIN_SLOPE * den) {
+		tts_publish(kettle, TTS_UNKNOWN);
+		return;
+	}
+
+	/* n * fitted temperature at t: sum_y + slope * (n * t - sum_t) */
+	int64_t fit_n = tts->sum_y + num * (n * t - tts->sum_t) / den;
+	int64_t remaining_n = n * kettle->dev_ctx.thermostat_attr.occupied_heating_setpoint - fit_n;
+
+	if (remaining_n <= 0) {
+		tts_publish(kettle, 0);
+		return;
+	}
+
+	int64_t seconds = remaining_n * den / (n * num * (1000 / TTS_TICK_MS));
+
+	tts_publish(kettle, (uint16_t)MIN(seconds, TTS_UNKNOWN - 1));
+}
+
+/* ==========================================================================
+ * Ready Detection
+ *
+ * Flags the water as ready as soon as the filtered temperature stops
+ * rising near the setpoint, or crosses it, rather than waiting for the
+ * kettle's own switch-off and the temperature report interval. The state
+ * goes out immediately as a state-priority report. Only a heating cycle
+ * arms the detector, so water cooling past the setpoint never counts.
+ * ========================================================================== */
+
+#define READY_BAND_ZB           100     /* Plateau this close below the setpoint counts */
+#define READY_FLAT_SLOPE        5       /* 0.01°C/s; slower rise counts as flat */
+#define READY_HOLD_MS           2000    /* Flat for this long before flagging */
+#define READY_RESET_BAND_ZB     300     /* Cooled this far below the setpoint: not ready */
+#define READY_BOIL_SETPOINT_ZB  (TEMP_MAX_ZB - 100)  /* Setpoints from 99°C mean boiling */
+
+static void ready_publish(struct kettle_ctx *kettle, uint8_t level)
+{
+	if (kettle->dev_ctx.kettle_attr.water_ready == level) {
+		return;
+	}
+	kettle->dev_ctx.kettle_attr.water_ready = level;
+	report_changed(kettle, BIT(REPORT_WATER_READY));
+	LOG_INF("Water ready: %d", level);
+}
+
+/** Kettle lifted or temperature unknown: start over */
+static void ready_invalidate(struct kettle_ctx *kettle)
+{
+	memset(&kettle->ready, 0, sizeof(kettle->ready));
+	ready_publish(kettle, ZB_KETTLE_READY_NONE);
+}
+
+/**
+ * Feed a water temperature sample to the plateau detector.
+ *
+ * Uses the smoothed slope water_channel_update() keeps in kettle->water.
+ *
+ * @param temp Water temperature (0.01°C)
+ */
+static void ready_update(struct kettle_ctx *kettle, int16_t temp)
+{
+	struct ready_detector *ready = &kettle->ready;
+	int64_t now = k_uptime_get();
+	int16_t setpoint = kettle->dev_ctx.thermostat_attr.occupied_heating_setpoint;
+	bool heating = (kettle->heating_state == KETTLE_STATE_ON);
+
+	/* A new heating cycle re-arms the detector */
+	if (heating && !ready->was_heating) {
+		ready->armed = true;
+		ready->flat_since_ms = 0;
+		ready_publish(kettle, ZB_KETTLE_READY_NONE);
+	}
+	ready->was_heating = heating;
+
+	if (kettle->dev_ctx.kettle_attr.water_ready != ZB_KETTLE_READY_NONE) {
+		if (temp < setpoint - READY_RESET_BAND_ZB) {
+			ready_publish(kettle, ZB_KETTLE_READY_NONE);
+		}
+		return;
+	}
+
+	if (!ready->armed || temp < setpoint - READY_BAND_ZB) {
+		ready->flat_since_ms = 0;
+		return;
+	}
+
+	if (kettle->water.slope > READY_FLAT_SLOPE) {
+		ready->flat_since_ms = 0;
+	} else if (ready->flat_since_ms == 0) {
+		ready->flat_since_ms = now;
+	}
+
+	if (temp >= setpoint ||
+	    (ready->flat_since_ms != 0 && now - ready->flat_since_ms >= READY_HOLD_MS)) {
+		ready->armed = false;
+		ready_publish(kettle, setpoint >= READY_BOIL_SETPOINT_ZB ?
+			      ZB_KETTLE_READY_BOILING : ZB_KETTLE_READY_SETPOINT);
+	}
+}
+
+/* ==========================================================================
+ * History
+ *
+ * RAM ring buffer of the water temperature and kettle state, about 1 Hz
+ * over the last ~16 minutes, read in bulk through the Kettle cluster.
+ *
+ * Records are two bytes, oldest first:
+ *   [0] temperature delta to the previous record (int8, 0.01°C), or
+ *       HISTORY_KEYFRAME: the next two bytes hold the absolute temperature
+ *       (int16 LE, TEMP_INVALID_ZB off base)
+ *   [1] seconds since the previous record (bits 0-5, saturating) and the
+ *       HISTORY_META_* state bits
+ * Evicting a record folds its delta into history_ring.base, the temperature
+ * before the oldest record, so the buffer always decodes from the start.
+ * Positions count bytes ever written, which lets a reader resume.
+ * ========================================================================== */
+
+#define HISTORY_PERIOD_MS       1000    /* Record at most this often */
+#define HISTORY_CHUNK           48      /* Data bytes per readout response */
+#define HISTORY_KEYFRAME        ((uint8_t)0x80)
+#define HISTORY_DT_MAX          0x3F
+#define HISTORY_META_HEATING    BIT(6)
+#define HISTORY_META_READY      BIT(7)
+
+BUILD_ASSERT((HISTORY_BYTES & (HISTORY_BYTES - 1)) == 0, "HISTORY_BYTES must be a power of two");
+
+/* Guards the history of every kettle */
+static K_MUTEX_DEFINE(history_lock);
+
+static inline uint8_t history_byte(const struct history_ring *history, uint32_t pos)
+{
+	return history->buf[pos & (HISTORY_BYTES - 1)];
+}
+
+/* Drop the oldest record, keeping history_ring.base in step */
+static void history_evict(struct history_ring *history)
+{
+	uint8_t delta = history_byte(history, history->tail);
+
+	if (delta == HISTORY_KEYFRAME) {
+		history->base = (int16_t)(history_byte(history, history->tail + 2) |
+					  (history_byte(history, history->tail + 3) << 8));
+		history->tail += 4;
+	} else {
+		if (history->base != TEMP_INVALID_ZB) {
+			history->base += (int8_t)delta;
+		}
+		history->tail += 2;
+	}
+}
+
+static void history_put(struct history_ring *history, uint8_t byte)
+{
+	history->buf[history->head & (HISTORY_BYTES - 1)] = byte;
+	history->head++;
+}
+
+/**
+ * Append a sample.
+ *
+ * @param temp Water temperature (0.01°C or TEMP_INVALID_ZB)
+ * @param force Record even within HISTORY_PERIOD_MS of the last one (state changes)
+ */
+static void history_record(struct kettle_ctx *kettle, int16_t temp, bool force)
+{
+	struct history_ring *history = &kettle->history;
+	int64_t now = k_uptime_get();
+	uint8_t meta = 0;
+
+	k_mutex_lock(&history_lock, K_FOREVER);
+
+	if (!force && history->last_ms != 0 && now - history->last_ms < HISTORY_PERIOD_MS) {
+		k_mutex_unlock(&history_lock);
+		return;
+	}
+
+	if (history->last_ms != 0) {
+		meta = MIN((now - history->last_ms + 500) / 1000, HISTORY_DT_MAX);
+	}
+	if (kettle->heating_state == KETTLE_STATE_ON) {
+		meta |= HISTORY_META_HEATING;
+	}
+	if (kettle->dev_ctx.kettle_attr.water_ready != ZB_KETTLE_READY_NONE) {
+		meta |= HISTORY_META_READY;
+	}
+
+	int32_t delta = temp - history->last;
+	bool keyframe = (history->last_ms == 0) ||
+			((temp == TEMP_INVALID_ZB) != (history->last == TEMP_INVALID_ZB)) ||
+			(temp != TEMP_INVALID_ZB && !IN_RANGE(delta, -127, 127));
+	size_t len = keyframe ? 4 : 2;
 
-/* Temperature measurement cluster attributes */
-ZB_ZCL_START_DECLARE_ATTRIB_LIST_CLUSTER_REVISION(temp_measurement_attr_list, ZB_ZCL_TEMP_MEASUREMENT)
-ZB_ZCL_SET_ATTR_DESC_M(ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_ID,
-	(&dev_ctx.temp_measurement_attr.measured_value),
-	ZB_ZCL_ATTR_TYPE_S16,
-	ZB_ZCL_ATTR_ACCESS_READ_ONLY | ZB_ZCL_ATTR_ACCESS_REPORTING)
-ZB_ZCL_SET_ATTR_DESC(ZB_ZCL_ATTR_TEMP_MEASUREMENT_MIN_VALUE_ID,
-	(&dev_ctx.temp_measurement_attr.min_measured_value))
-ZB_ZCL_SET_ATTR_DESC(ZB_ZCL_ATTR_TEMP_MEASUREMENT_MAX_VALUE_ID,
-	(&dev_ctx.temp_measurement_attr.max_measured_value))
-ZB_ZCL_FINISH_DECLARE_ATTRIB_LIST;
+	while (history->head - history->tail + len > HISTORY_BYTES) {
+		history_evict(history);
+	}
 
-ZB_DECLARE_KETTLE_CLUSTER_LIST(
-	kettle_clusters,
-	basic_attr_list,
-	identify_attr_list,
-	groups_attr_list,
-	on_off_attr_list,
-	thermostat_attr_list,
-	temp_measurement_attr_list);
+	if (keyframe) {
+		history_put(history, HISTORY_KEYFRAME);
+		history_put(history, meta);
+		history_put(history, (uint16_t)temp & 0xFF);
+		history_put(history, (uint16_t)temp >> 8);
+	} else {
+		history_put(history, (temp == TEMP_INVALID_ZB) ? 0 : (uint8_t)(int8_t)delta);
+		history_put(history, meta);
+	}
 
-ZB_DECLARE_KETTLE_EP(
-	kettle_ep,
-	KETTLE_ENDPOINT,
-	kettle_clusters);
+	history->last = temp;
+	history->last_ms = now;
 
-#ifdef CONFIG_ZIGBEE_FOTA
-extern zb_af_endpoint_desc_t zigbee_fota_client_ep;
+	k_mutex_unlock(&history_lock);
+}
 
-ZBOSS_DECLARE_DEVICE_CTX_2_EP(
-	kettle_ctx,
-	zigbee_fota_client_ep,
-	kettle_ep);
-#else
-ZBOSS_DECLARE_DEVICE_CTX_1_EP(
-	kettle_ctx,
-	kettle_ep);
-#endif
+/* Record a state change with the last known temperature */
+static void history_note_state(struct kettle_ctx *kettle)
+{
+	history_record(kettle, kettle->history.last, true);
+}
 
-/* ==========================================================================
- * Temperature Conversion Functions
- * ========================================================================== */
+struct history_chunk_hdr {
+	uint32_t start;             /* position of the first data byte */
+	uint32_t tail;
+	uint32_t head;
+	int16_t  base;
+	uint16_t newest_age_s;      /* seconds since the newest record */
+};
 
 /**
- * Convert ADC value to temperature for target dial (non-linear)
- * Kettle dial outputs 0-5V but NOT linear. We read through buffer + 2:1 divider.
+ * Snapshot a chunk of a kettle's history for readout.
  *
- * Calibration points (original voltage before divider):
- *   0.0V = 100°C,  0.8V = 95°C,  1.7V = 90°C,  2.6V = 80°C
- *   3.7V = 70°C,   4.5V = 60°C,  5.0V = 50°C
+ * @param kettle Kettle to read
+ * @param pos Position to read from; clamped to the oldest record
+ * @param out Buffer of HISTORY_CHUNK bytes
+ * @param hdr Filled with the positions and base temperature
+ * @return Number of bytes copied
  */
-
-/* Lookup table: {voltage_mv, temp_zb} - voltage is BEFORE the 2:1 divider */
-static const struct {
-	int16_t voltage_mv;
-	int16_t temp_zb;
-} target_temp_lut[] = {
-	{    0, 10000 },  /* 0.0V = 100°C */
-	{  800,  9500 },  /* 0.8V = 95°C */
-	{ 1700,  9000 },  /* 1.7V = 90°C */
-	{ 2600,  8000 },  /* 2.6V = 80°C */
-	{ 3700,  7000 },  /* 3.7V = 70°C */
-	{ 4500,  6000 },  /* 4.5V = 60°C */
-	{ 5000,  5000 },  /* 5.0V = 50°C */
-};
-#define TARGET_TEMP_LUT_SIZE (sizeof(target_temp_lut) / sizeof(target_temp_lut[0]))
-
-static int16_t adc_to_target_temp(int16_t adc_val)
+static size_t history_read(struct kettle_ctx *kettle, uint32_t pos, uint8_t *out,
+			   struct history_chunk_hdr *hdr)
 {
-	if (adc_val < 0) {
-		adc_val = 0;
-	}
-
-	/* Convert ADC to voltage (mV) - 3.6V full scale with GAIN_1_4 */
-	int32_t adc_mv = (int32_t)adc_val * 3600 / ADC_MAX_VALUE;
+	const struct history_ring *history = &kettle->history;
+	size_t len = 0;
 
-	/* Convert to original voltage (before 2:1 divider) */
-	int32_t orig_mv = adc_mv * ADC_DIVIDER_RATIO;
+	k_mutex_lock(&history_lock, K_FOREVER);
 
-	/* Find the two calibration points to interpolate between */
-	size_t i;
-	for (i = 0; i < TARGET_TEMP_LUT_SIZE - 1; i++) {
-		if (orig_mv <= target_temp_lut[i + 1].voltage_mv) {
-			break;
-		}
+	/* Positions before the tail were evicted (or wrapped around) */
+	if ((int32_t)(pos - history->tail) < 0 || (int32_t)(history->head - pos) < 0) {
+		pos = history->tail;
 	}
 
-	/* Clamp to table bounds */
-	if (i >= TARGET_TEMP_LUT_SIZE - 1) {
-		return target_temp_lut[TARGET_TEMP_LUT_SIZE - 1].temp_zb;
+	hdr->start = pos;
+	hdr->tail = history->tail;
+	hdr->head = history->head;
+	hdr->base = history->base;
+	hdr->newest_age_s = (history->last_ms == 0) ? 0 :
+		MIN((k_uptime_get() - history->last_ms) / 1000, UINT16_MAX);
+
+	while (len < HISTORY_CHUNK && pos != history->head) {
+		out[len++] = history_byte(history, pos++);
 	}
 
-	/* Linear interpolation between points i and i+1 */
-	int32_t v0 = target_temp_lut[i].voltage_mv;
-	int32_t v1 = target_temp_lut[i + 1].voltage_mv;
-	int32_t t0 = target_temp_lut[i].temp_zb;
-	int32_t t1 = target_temp_lut[i + 1].temp_zb;
+	k_mutex_unlock(&history_lock);
+	return len;
+}
 
-	/* temp = t0 + (t1 - t0) * (v - v0) / (v1 - v0) */
-	int32_t temp_zb = t0 + (t1 - t0) * (orig_mv - v0) / (v1 - v0);
+/* ==========================================================================
+ * Kettle Cluster
+ *
+ * Manufacturer-specific cluster 0xFC00: calibration commands (see Field
+ * Calibration), bulk history readout (see History) and the telemetry
+ * stream setting (see Telemetry Stream).
+ * ========================================================================== */
 
-	return (int16_t)temp_zb;
+/* Kettle cluster: validate writes to the reference and stream attributes */
+static zb_ret_t kettle_cluster_check_value(zb_uint16_t attr_id, zb_uint8_t endpoint,
+					   zb_uint8_t *value)
+{
+	ARG_UNUSED(endpoint);
+
+	switch (attr_id) {
+	case ZB_ZCL_ATTR_KETTLE_AMBIENT_REFERENCE_ID:
+	case ZB_ZCL_ATTR_KETTLE_BOIL_REFERENCE_ID:
+		return IN_RANGE((int16_t)sys_get_le16(value), 0, TEMP_MAX_ZB) ? RET_OK : RET_ERROR;
+	case ZB_ZCL_ATTR_KETTLE_STREAM_INTERVAL_ID:
+		return (sys_get_le16(value) <= ZB_KETTLE_STREAM_INTERVAL_MAX) ? RET_OK : RET_ERROR;
+	default:
+		return RET_OK;
+	}
 }
 
 /**
- * Convert ADC value to temperature for NTC thermistor (current temperature)
- * Uses physics-based lookup table derived from NTC thermistor equation.
- *
- * Circuit: 5V -> R_fixed -> junction -> NTC -> GND
- * V_junction = Vcc * R_ntc / (R_fixed + R_ntc)
- * We read junction through op-amp buffer + 2:1 divider
- *
- * NTC model: R(T) = R25 * exp(Beta * (1/T - 1/298.15))
- * Fitted from empirical data:
- *   - Ambient ~20°C at ~1076mV (log start)
- *   - Boiling ~99°C at ~3260mV (log end)
- *   - Derived Beta ≈ 2720K
- *
- * Physics-based calibration points (voltage before 2:1 divider):
- */
-
-/* Voltage threshold below which kettle is considered off base (mV, before divider) */
-#define KETTLE_OFF_BASE_MV      750
-
-/* Lookup table: {voltage_mv, temp_zb} - voltage is BEFORE the 2:1 divider
- * Derived from NTC physics with Beta=2720K, anchored to measured endpoints.
- * More points in non-linear regions for better interpolation accuracy.
- */
-static const struct {
-	int16_t voltage_mv;
-	int16_t temp_zb;
-} current_temp_lut[] = {
-	{ 1060,  2000 },  /* 1.06V = 20°C (ambient baseline) */
-	{ 1180,  2500 },  /* 1.18V = 25°C */
-	{ 1440,  3500 },  /* 1.44V = 35°C */
-	{ 1720,  4500 },  /* 1.72V = 45°C */
-	{ 2000,  5500 },  /* 2.00V = 55°C */
-	{ 2260,  6500 },  /* 2.26V = 65°C */
-	{ 2500,  7500 },  /* 2.50V = 75°C */
-	{ 2720,  8500 },  /* 2.72V = 85°C */
-	{ 2900,  9500 },  /* 2.90V = 95°C */
-	{ 3000,  9900 },  /* 3.00V = 99°C */
-	{ 3260, 10000 },  /* 3.26V = 100°C (boiling ceiling) */
-};
-#define CURRENT_TEMP_LUT_SIZE (sizeof(current_temp_lut) / sizeof(current_temp_lut[0]))
-
-static int16_t adc_to_current_temp(int16_t adc_val)
+ * Answer a History Read with one chunk, reusing the request buffer.
+ *
+ * Response payload: start, tail and head positions (U32), base temperature
+ * (S16), age of the newest record in seconds (U16), data (octet string).
+ */
+static void kettle_send_history(struct kettle_ctx *kettle, zb_bufid_t bufid,
+				const zb_zcl_parsed_hdr_t *cmd_info, uint32_t pos)
 {
-	if (adc_val < 10) {
-		return TEMP_INVALID_ZB;
-	}
+	struct history_chunk_hdr hdr;
+	uint8_t data[HISTORY_CHUNK];
+	size_t len = history_read(kettle, pos, data, &hdr);
+	zb_uint8_t *cmd_ptr;
 
-	/* Convert ADC to voltage (mV) - 3.6V full scale with GAIN_1_4 */
-	int32_t adc_mv = (int32_t)adc_val * 3600 / ADC_MAX_VALUE;
+	cmd_ptr = ZB_ZCL_START_PACKET(bufid);
+	ZB_ZCL_PACKET_PUT_DATA8(cmd_ptr, 0x1D);  /* Frame ctrl: cluster cmd | manuf | srv->cli | no default resp */
+	ZB_ZCL_PACKET_PUT_DATA16_VAL(cmd_ptr, ZB_KETTLE_MANUF_CODE);
+	ZB_ZCL_PACKET_PUT_DATA8(cmd_ptr, cmd_info->seq_number);
+	ZB_ZCL_PACKET_PUT_DATA8(cmd_ptr, ZB_ZCL_CMD_KETTLE_HISTORY_DATA);
+	ZB_ZCL_PACKET_PUT_DATA32_VAL(cmd_ptr, hdr.start);
+	ZB_ZCL_PACKET_PUT_DATA32_VAL(cmd_ptr, hdr.tail);
+	ZB_ZCL_PACKET_PUT_DATA32_VAL(cmd_ptr, hdr.head);
+	ZB_ZCL_PACKET_PUT_DATA16_VAL(cmd_ptr, hdr.base);
+	ZB_ZCL_PACKET_PUT_DATA16_VAL(cmd_ptr, hdr.newest_age_s);
+	ZB_ZCL_PACKET_PUT_DATA8(cmd_ptr, len);
+	ZB_ZCL_PACKET_PUT_DATA_N(cmd_ptr, data, len);
+	ZB_ZCL_FINISH_PACKET(bufid, cmd_ptr)
 
-	/* Convert to original voltage (before 2:1 divider) */
-	int32_t orig_mv = adc_mv * ADC_DIVIDER_RATIO;
+	ZB_ZCL_SEND_COMMAND_SHORT(bufid,
+				  ZB_ZCL_PARSED_HDR_SHORT_DATA(cmd_info).source.u.short_addr,
+				  ZB_APS_ADDR_MODE_16_ENDP_PRESENT,
+				  ZB_ZCL_PARSED_HDR_SHORT_DATA(cmd_info).src_endpoint,
+				  kettle->hw->endpoint, ZB_AF_HA_PROFILE_ID,
+				  ZB_ZCL_CLUSTER_ID_KETTLE, NULL);
+
+	LOG_DBG("Kettle %u: history chunk: pos=%u, %zu bytes", kettle->index, hdr.start, len);
+}
 
-	/* Check if kettle is off base (voltage too low) */
-	if (orig_mv < KETTLE_OFF_BASE_MV) {
-		return TEMP_INVALID_ZB;
+/* Kettle cluster: calibration and history commands */
+static zb_bool_t kettle_cluster_handler(zb_uint8_t param)
+{
+	zb_zcl_parsed_hdr_t cmd_info;
+	const zb_uint8_t *payload = zb_buf_begin(param);
+	zb_uint32_t len = zb_buf_len(param);
+	zb_uint8_t status = ZB_ZCL_STATUS_SUCCESS;
+	struct kettle_ctx *kettle;
+	int err = 0;
+
+	ZB_ZCL_COPY_PARSED_HEADER(param, &cmd_info);
+
+	if (cmd_info.is_common_command ||
+	    cmd_info.cmd_direction != ZB_ZCL_FRAME_DIRECTION_TO_SRV) {
+		return ZB_FALSE;
 	}
 
-	/* Check if voltage is below minimum calibration point but above off-base threshold */
-	if (orig_mv < current_temp_lut[0].voltage_mv) {
-		/* Extrapolate below 25°C using first two points */
-		int32_t v0 = current_temp_lut[0].voltage_mv;
-		int32_t v1 = current_temp_lut[1].voltage_mv;
-		int32_t t0 = current_temp_lut[0].temp_zb;
-		int32_t t1 = current_temp_lut[1].temp_zb;
-		int32_t temp_zb = t0 + (t1 - t0) * (orig_mv - v0) / (v1 - v0);
-		return (int16_t)(temp_zb < 0 ? 0 : temp_zb);
+	kettle = kettle_by_endpoint(ZB_ZCL_PARSED_HDR_SHORT_DATA(&cmd_info).dst_endpoint);
+	if (!kettle) {
+		return ZB_FALSE;
 	}
 
-	/* Find the two calibration points to interpolate between */
-	size_t i;
-	for (i = 0; i < CURRENT_TEMP_LUT_SIZE - 1; i++) {
-		if (orig_mv <= current_temp_lut[i + 1].voltage_mv) {
+	switch (cmd_info.cmd_id) {
+	case ZB_ZCL_CMD_KETTLE_CALIBRATION_START:
+		err = calibration_start(kettle);
+		break;
+
+	case ZB_ZCL_CMD_KETTLE_CALIBRATION_CAPTURE:
+		if (len < 3) {
+			status = ZB_ZCL_STATUS_MALFORMED_CMD;
 			break;
 		}
-	}
+		err = calibration_capture(kettle, payload[0], (int16_t)sys_get_le16(&payload[1]));
+		break;
+
+	case ZB_ZCL_CMD_KETTLE_CALIBRATION_FINISH:
+		err = calibration_finish(kettle);
+		break;
+
+	case ZB_ZCL_CMD_KETTLE_CALIBRATION_CANCEL:
+		calibration_cancel(kettle);
+		break;
+
+	case ZB_ZCL_CMD_KETTLE_CALIBRATION_RESET:
+		calibration_reset(kettle);
+		break;
+
+	case ZB_ZCL_CMD_KETTLE_HISTORY_READ:
+		if (len < 4) {
+			status = ZB_ZCL_STATUS_MALFORMED_CMD;
+			break;
+		}
+		kettle_send_history(kettle, param, &cmd_info, sys_get_le32(payload));
+		return ZB_TRUE;  /* buffer reused for the response */
 
-	/* Clamp to table bounds */
-	if (i >= CURRENT_TEMP_LUT_SIZE - 1) {
-		return current_temp_lut[CURRENT_TEMP_LUT_SIZE - 1].temp_zb;
+	default:
+		status = ZB_ZCL_STATUS_UNSUP_CMD;
+		break;
 	}
 
-	/* Linear interpolation between points i and i+1 */
-	int32_t v0 = current_temp_lut[i].voltage_mv;
-	int32_t v1 = current_temp_lut[i + 1].voltage_mv;
-	int32_t t0 = current_temp_lut[i].temp_zb;
-	int32_t t1 = current_temp_lut[i + 1].temp_zb;
+	if (err == -EINVAL) {
+		status = ZB_ZCL_STATUS_INVALID_VALUE;
+	} else if (err) {
+		status = ZB_ZCL_STATUS_FAIL;
+	}
 
-	/* temp = t0 + (t1 - t0) * (v - v0) / (v1 - v0) */
-	int32_t temp_zb = t0 + (t1 - t0) * (orig_mv - v0) / (v1 - v0);
+	ZB_ZCL_PROCESS_COMMAND_FINISH(param, &cmd_info, status);
+	return ZB_TRUE;
+}
 
-	return (int16_t)temp_zb;
+void zb_zcl_kettle_init_server(void)
+{
+	zb_zcl_add_cluster_handlers(ZB_ZCL_CLUSTER_ID_KETTLE, ZB_ZCL_CLUSTER_SERVER_ROLE,
+				    kettle_cluster_check_value, NULL, kettle_cluster_handler);
 }
 
 /* ==========================================================================
- * ADC Sampling
+ * Temperature Updates
+ *
+ * Sampling and filtering run on the sensor workqueue (sensor_wq, started
+ * from main()); attributes, reports and everything fed by the water temperature
+ * are updated in ZBOSS context. Each sampling cycle posts a sensor_sample
+ * per kettle through a lock-free single-producer/single-consumer mailbox,
+ * drained by sensor_drain_cb().
  * ========================================================================== */
 
-/* Forward declarations for reporting helpers */
-static void mark_attribute_changed(zb_uint8_t endpoint, zb_uint16_t cluster_id,
-				   zb_uint16_t attr_id);
-static void schedule_state_report(void);
-static void schedule_target_temp_report(void);
+#define SENSOR_SETPOINT         BIT(0)  /* target_temp is a new setpoint */
+#define SENSOR_WATER            BIT(1)  /* current_temp is a valid reading */
+#define SENSOR_OFF_BASE         BIT(2)  /* kettle lifted */
+#define SENSOR_MAILBOX_SIZE     8       /* Power of two */
 
-/**
- * Comparison function for qsort to sort int16_t values ascending
+struct sensor_sample {
+	uint8_t kettle;             /* index into kettles[] */
+	uint8_t flags;              /* SENSOR_* */
+	int16_t target_temp;        /* 0.01°C */
+	int16_t current_temp;       /* 0.01°C */
+};
+
+SPSC_DEFINE(sensor_mailbox, struct sensor_sample, SENSOR_MAILBOX_SIZE);
+static atomic_t sensor_flags;
+#define SENSOR_DRAIN_SCHEDULED  0       /* sensor_drain_cb() queued */
+static uint32_t sensor_dropped;         /* samples lost to a full mailbox */
+
+/* Sampling cycle counters for the health report (per-sample lines are
+ * compiled out with CONFIG_KETTLE_LOG_PRODUCTION)
  */
-static int compare_int16(const void *a, const void *b)
-{
-	int16_t va = *(const int16_t *)a;
-	int16_t vb = *(const int16_t *)b;
-	return (va > vb) - (va < vb);
-}
+static struct {
+	uint32_t cycles;
+	uint32_t samples;           /* kettle readings, one per kettle and cycle */
+	uint32_t read_errors;
+} sensor_stats;
+
+/* Given after the first sampling cycle, so boot can hold the stack for it */
+static K_SEM_DEFINE(sensor_first_sem, 0, 1);
+
+static void sensor_drain_cb(zb_uint8_t param);
 
 /**
- * Perform burst sampling of an ADC channel to handle pulsed signals.
- *
- * The current temperature signal is pulsed at ~50Hz - it goes high during
- * part of each cycle. By sampling rapidly over multiple cycles and taking
- * a low percentile, we capture the true analog level when the pulse is low.
+ * Publish a new water temperature (0.01°C or TEMP_INVALID_ZB).
  *
- * @param adc_spec ADC channel to sample
- * @return The 10th percentile ADC value, or -1 on error
+ * Thermostat local temperature mirrors it, either as its own copy or, with
+ * CONFIG_KETTLE_LOCAL_TEMP_ALIAS, through the shared attribute storage.
  */
-static int16_t burst_sample_adc(const struct adc_dt_spec *adc_spec)
+static void set_water_temperature(struct kettle_ctx *kettle, int16_t temp)
 {
-	int ret;
-	struct adc_sequence sequence = {
-		.buffer = &adc_buffer,
-		.buffer_size = sizeof(adc_buffer),
-	};
+	kettle->dev_ctx.temp_measurement_attr.measured_value = temp;
+#ifndef CONFIG_KETTLE_LOCAL_TEMP_ALIAS
+	kettle->dev_ctx.thermostat_attr.local_temperature = temp;
+#endif
+	report_changed(kettle, REPORT_TEMP_MASK);
+}
 
-	/* Initialize sequence for this channel */
-	ret = adc_sequence_init_dt(adc_spec, &sequence);
-	if (ret != 0) {
-		LOG_WRN("Burst sample: sequence init failed: %d", ret);
-		return -1;
-	}
-
-	/* Collect burst samples */
-	for (int i = 0; i < BURST_SAMPLE_COUNT; i++) {
-		ret = adc_read_dt(adc_spec, &sequence);
-		if (ret != 0) {
-			LOG_WRN("Burst sample %d failed: %d", i, ret);
-			/* Fill remaining with invalid marker */
-			for (int j = i; j < BURST_SAMPLE_COUNT; j++) {
-				burst_samples[j] = INT16_MAX;
-			}
-			break;
-		}
-		burst_samples[i] = adc_buffer;
+/* Sensor workqueue: hand a sample to ZBOSS context */
+static void sensor_post(const struct sensor_sample *sample)
+{
+	struct sensor_sample *slot = spsc_acquire(&sensor_mailbox);
 
-		/* Wait before next sample (except after last) */
-		if (i < BURST_SAMPLE_COUNT - 1) {
-			k_busy_wait(BURST_SAMPLE_INTERVAL_US);
-		}
+	if (!slot) {
+		/* ZBOSS is behind by a whole mailbox; the next sample supersedes this one */
+		sensor_dropped++;
+		return;
 	}
 
-	/* Sort samples to find percentile */
-	qsort(burst_samples, BURST_SAMPLE_COUNT, sizeof(int16_t), compare_int16);
-
-	/* Return the 10th percentile value (low but not minimum, for noise robustness) */
-	int16_t result = burst_samples[BURST_PERCENTILE_INDEX];
-
-	/* Log burst statistics for debugging */
-	LOG_DBG("Burst: min=%d, p10=%d, median=%d, max=%d",
-		burst_samples[0],
-		burst_samples[BURST_PERCENTILE_INDEX],
-		burst_samples[BURST_SAMPLE_COUNT / 2],
-		burst_samples[BURST_SAMPLE_COUNT - 1]);
+	*slot = *sample;
+	spsc_produce(&sensor_mailbox);
 
-	return result;
+	if (!atomic_test_and_set_bit(&sensor_flags, SENSOR_DRAIN_SCHEDULED)) {
+		/* ZBOSS scheduler calls are only safe on the ZBOSS thread */
+		if (zigbee_schedule_callback(sensor_drain_cb, 0) != RET_OK) {
+			/* Scheduler queue full: retried with the next sample */
+			atomic_clear_bit(&sensor_flags, SENSOR_DRAIN_SCHEDULED);
+		}
+	}
 }
 
-static void update_temperatures(void)
+/**
+ * Sample and filter a kettle's dial and water temperatures (sensor workqueue).
+ *
+ * @param kettle Kettle to update
+ * @param burst_adc Low-percentile ADC value of the current temperature burst,
+ *                  or -1 if the burst capture failed
+ */
+static void update_temperatures(struct kettle_ctx *kettle, int16_t burst_adc)
 {
+	uint32_t start_cyc = k_cycle_get_32();
 	int ret;
 	int16_t target_temp, current_temp;
+	struct sensor_sample sample = {
+		.kettle = kettle->index,
+		.target_temp = TEMP_INVALID_ZB,
+		.current_temp = TEMP_INVALID_ZB,
+	};
+	int16_t dial_code;
 	struct adc_sequence sequence = {
-		.buffer = &adc_buffer,
-		.buffer_size = sizeof(adc_buffer),
+		.buffer = &dial_code,
+		.buffer_size = sizeof(dial_code),
 	};
 
-	/* Sample target temperature (channel 0) */
-	ret = adc_sequence_init_dt(&adc_target_temp, &sequence);
+	sensor_stats.samples++;
+
+	/* Sample target temperature (dial channel): one read, averaged by the
+	 * SAADC over the channel's devicetree oversampling
+	 */
+	ret = adc_sequence_init_dt(&kettle->hw->adc_target, &sequence);
 	if (ret == 0) {
-		ret = adc_read_dt(&adc_target_temp, &sequence);
+		ret = adc_read_dt(&kettle->hw->adc_target, &sequence);
 	}
 
 	if (ret == 0) {
-		/* Apply EMA filter to ADC reading */
-		if (adc_target_filtered < 0) {
-			adc_target_filtered = adc_buffer;  /* First sample */
-		} else {
-			adc_target_filtered += (adc_buffer - adc_target_filtered) / ADC_FILTER_COEFF;
-		}
-		int16_t filtered_adc = (int16_t)adc_target_filtered;
+		int16_t filtered_adc = adc_filter_update(&kettle->adc_target_filter, dial_code,
+							 k_uptime_get());
+
+		kettle->adc_policy.dial_code = dial_code;
 
-		/* Calculate raw voltage: GAIN_1_4 + 0.9V internal ref = 3.6V full scale */
-		int32_t adc_mv = (int32_t)filtered_adc * 3600 / ADC_MAX_VALUE;
-		int32_t orig_mv = adc_mv * ADC_DIVIDER_RATIO;  /* Voltage before divider */
+		int32_t orig_mv = ADC_CODE_TO_MV(filtered_adc);  /* Voltage before divider */
 
-		target_temp = adc_to_target_temp(filtered_adc);
-		int16_t current_setpoint = dev_ctx.thermostat_attr.occupied_heating_setpoint;
+		target_temp = adc_to_target_temp(&kettle->temp_tables, filtered_adc);
+		int16_t current_setpoint = kettle->dev_ctx.thermostat_attr.occupied_heating_setpoint;
 
-		LOG_INF("Target: raw=%d, filt=%d, %dmV, measured=%d.%02d°C, zigbee=%d.%02d°C",
-			adc_buffer, filtered_adc, orig_mv,
+		LOG_SAMPLE("Target %u: raw=%d, filt=%d, %dmV, measured=%d.%02d°C, zigbee=%d.%02d°C",
+			kettle->index, dial_code, filtered_adc, orig_mv,
 			target_temp / 100, target_temp % 100,
 			current_setpoint / 100, current_setpoint % 100);
 
@@ -600,152 +2411,267 @@ static void update_temperatures(void)
 		if (diff < 0) diff = -diff;
 
 		if (diff > 50) {  /* 0.5°C threshold */
-			dev_ctx.thermostat_attr.occupied_heating_setpoint = target_temp;
-
-			ZB_ZCL_SET_ATTRIBUTE(
-				KETTLE_ENDPOINT,
-				ZB_ZCL_CLUSTER_ID_THERMOSTAT,
-				ZB_ZCL_CLUSTER_SERVER_ROLE,
-				ZB_ZCL_ATTR_THERMOSTAT_OCCUPIED_HEATING_SETPOINT_ID,
-				(zb_uint8_t *)&target_temp,
-				ZB_FALSE);
-
-			/* Send immediate manual report for responsive UI */
-			schedule_target_temp_report();
-
-			/* Also mark for stack's automatic reporting as backup */
-			mark_attribute_changed(KETTLE_ENDPOINT, ZB_ZCL_CLUSTER_ID_THERMOSTAT,
-				ZB_ZCL_ATTR_THERMOSTAT_OCCUPIED_HEATING_SETPOINT_ID);
-
-			save_kettle_state();
-			LOG_INF("Target temp updated to %d.%02d°C", target_temp / 100, target_temp % 100);
+			sample.flags |= SENSOR_SETPOINT;
+			sample.target_temp = target_temp;
+			kettle->adc_policy.dial_active_until = k_uptime_get() + ADC_DIAL_ACTIVE_MS;
 		}
 	} else {
-		LOG_WRN("Target temp ADC read failed: %d", ret);
+		sensor_stats.read_errors++;
+		LOG_WRN_HOT("Kettle %u: target temp ADC read failed: %d", kettle->index, ret);
 	}
 
-	/* Sample current temperature (channel 1) using burst sampling
+	/* Current temperature (water channel) comes from the burst capture
 	 * The temperature signal is pulsed at ~50Hz, so we take many rapid samples
 	 * and use the 10th percentile to get the true value when the pulse is low.
 	 */
-	int16_t burst_adc = burst_sample_adc(&adc_current_temp);
-
 	if (burst_adc >= 0) {
-		/* Calculate voltage from burst-sampled ADC value */
-		int32_t burst_adc_mv = (int32_t)burst_adc * 3600 / ADC_MAX_VALUE;
-		int32_t burst_orig_mv = burst_adc_mv * ADC_DIVIDER_RATIO;
-
-		/* Check if kettle is off base */
-		if (burst_orig_mv < KETTLE_OFF_BASE_MV) {
-			/* Kettle off base - reset filter and report invalid */
-			adc_current_filtered = -1;
-			current_temp = TEMP_INVALID_ZB;
-
-			LOG_INF("Current: burst_p10=%d, %dmV, OFF BASE (kettle lifted)", burst_adc, burst_orig_mv);
-
-			/* Report invalid temperature to Zigbee if it changed */
-			if (dev_ctx.temp_measurement_attr.measured_value != TEMP_INVALID_ZB) {
-				dev_ctx.temp_measurement_attr.measured_value = TEMP_INVALID_ZB;
-				dev_ctx.thermostat_attr.local_temperature = TEMP_INVALID_ZB;
-
-				ZB_ZCL_SET_ATTRIBUTE(
-					KETTLE_ENDPOINT,
-					ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT,
-					ZB_ZCL_CLUSTER_SERVER_ROLE,
-					ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_ID,
-					(zb_uint8_t *)&current_temp,
-					ZB_FALSE);
-
-				ZB_ZCL_SET_ATTRIBUTE(
-					KETTLE_ENDPOINT,
-					ZB_ZCL_CLUSTER_ID_THERMOSTAT,
-					ZB_ZCL_CLUSTER_SERVER_ROLE,
-					ZB_ZCL_ATTR_THERMOSTAT_LOCAL_TEMPERATURE_ID,
-					(zb_uint8_t *)&current_temp,
-					ZB_FALSE);
-
-				/* Mark attributes for reporting */
-				mark_attribute_changed(KETTLE_ENDPOINT, ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT,
-					ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_ID);
-				mark_attribute_changed(KETTLE_ENDPOINT, ZB_ZCL_CLUSTER_ID_THERMOSTAT,
-					ZB_ZCL_ATTR_THERMOSTAT_LOCAL_TEMPERATURE_ID);
-
-				LOG_INF("Kettle off base - marked for reporting");
-			}
+		int16_t filtered_adc;
+		enum water_status status = water_channel_update(&kettle->water,
+								&kettle->temp_tables, burst_adc,
+								k_uptime_get(), &filtered_adc,
+								&current_temp);
+
+		if (status == WATER_OFF_BASE) {
+			/* Filter restarted; report invalid */
+			sample.flags |= SENSOR_OFF_BASE;
+
+			LOG_SAMPLE("Current %u: burst_p10=%d, %dmV, OFF BASE (kettle lifted)",
+				kettle->index, burst_adc, ADC_CODE_TO_MV(burst_adc));
+		} else if (status == WATER_VALID) {
+			int16_t current_zb = kettle->dev_ctx.temp_measurement_attr.measured_value;
+
+			LOG_SAMPLE("Current %u: burst_p10=%d, filt=%d, %dmV, measured=%d.%02d°C, zigbee=%d.%02d°C",
+				kettle->index, burst_adc, filtered_adc, ADC_CODE_TO_MV(filtered_adc),
+				current_temp / 100, current_temp % 100,
+				current_zb / 100, current_zb % 100);
+
+			sample.flags |= SENSOR_WATER;
+			sample.current_temp = current_temp;
 		} else {
-			/* Apply EMA filter to burst-sampled ADC value */
-			if (adc_current_filtered < 0) {
-				adc_current_filtered = burst_adc;  /* First sample */
-			} else {
-				adc_current_filtered += (burst_adc - adc_current_filtered) / ADC_FILTER_COEFF;
-			}
-			int16_t filtered_adc = (int16_t)adc_current_filtered;
+			LOG_SAMPLE("Current %u: burst_p10=%d, filt=%d, %dmV, INVALID",
+				kettle->index, burst_adc, filtered_adc, ADC_CODE_TO_MV(filtered_adc));
+		}
+	} else {
+		sensor_stats.read_errors++;
+		LOG_WRN_HOT("Kettle %u: current temp burst sampling failed", kettle->index);
+	}
 
-			/* Calculate filtered voltage */
-			int32_t adc_mv_cur = (int32_t)filtered_adc * 3600 / ADC_MAX_VALUE;
-			int32_t orig_mv_cur = adc_mv_cur * ADC_DIVIDER_RATIO;
+	if (sample.flags) {
+		sensor_post(&sample);
+	}
 
-			current_temp = adc_to_current_temp(filtered_adc);
-			int16_t current_zb = dev_ctx.temp_measurement_attr.measured_value;
+	diag_record(DIAG_UPDATE_TEMPS, diag_since_us(start_cyc));
+}
 
-			if (current_temp != TEMP_INVALID_ZB) {
-				LOG_INF("Current: burst_p10=%d, filt=%d, %dmV, measured=%d.%02d°C, zigbee=%d.%02d°C",
-					burst_adc, filtered_adc, orig_mv_cur,
-					current_temp / 100, current_temp % 100,
-					current_zb / 100, current_zb % 100);
-			} else {
-				LOG_INF("Current: burst_p10=%d, filt=%d, %dmV, INVALID", burst_adc, filtered_adc, orig_mv_cur);
-			}
+/* ZBOSS context: apply one sample to the attributes and their consumers */
+static void apply_temperatures(const struct sensor_sample *sample)
+{
+	struct kettle_ctx *kettle = &kettles[sample->kettle];
 
-			if (current_temp != TEMP_INVALID_ZB) {
-				/* Check if temperature changed significantly (>0.5°C) */
-				int16_t diff = current_temp - dev_ctx.temp_measurement_attr.measured_value;
-				if (diff < 0) diff = -diff;
-
-				if (diff > 50 || dev_ctx.temp_measurement_attr.measured_value == TEMP_INVALID_ZB) {
-					/* Update both temperature measurement and thermostat local temp */
-					dev_ctx.temp_measurement_attr.measured_value = current_temp;
-					dev_ctx.thermostat_attr.local_temperature = current_temp;
-
-					ZB_ZCL_SET_ATTRIBUTE(
-						KETTLE_ENDPOINT,
-						ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT,
-						ZB_ZCL_CLUSTER_SERVER_ROLE,
-						ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_ID,
-						(zb_uint8_t *)&current_temp,
-						ZB_FALSE);
-
-					ZB_ZCL_SET_ATTRIBUTE(
-						KETTLE_ENDPOINT,
-						ZB_ZCL_CLUSTER_ID_THERMOSTAT,
-						ZB_ZCL_CLUSTER_SERVER_ROLE,
-						ZB_ZCL_ATTR_THERMOSTAT_LOCAL_TEMPERATURE_ID,
-						(zb_uint8_t *)&current_temp,
-						ZB_FALSE);
-
-					/* Mark attributes for reporting - stack manages timing */
-					mark_attribute_changed(KETTLE_ENDPOINT, ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT,
-						ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_ID);
-					mark_attribute_changed(KETTLE_ENDPOINT, ZB_ZCL_CLUSTER_ID_THERMOSTAT,
-						ZB_ZCL_ATTR_THERMOSTAT_LOCAL_TEMPERATURE_ID);
-
-					LOG_INF("Current temp: %d.%02d°C", current_temp / 100, current_temp % 100);
-				}
-			}
-		}  /* end of else (kettle on base) */
-	} else {
-		LOG_WRN("Current temp burst sampling failed");
+	if (sample->flags & SENSOR_SETPOINT) {
+		int16_t target_temp = sample->target_temp;
+
+		kettle->dev_ctx.thermostat_attr.occupied_heating_setpoint = target_temp;
+
+		/* Report promptly for responsive UI */
+		report_changed(kettle, BIT(REPORT_HEATING_SETPOINT));
+
+		persist_mark(kettle, PERSIST_TARGET_TEMP);
+		LOG_INF("Kettle %u: target temp updated to %d.%02d°C",
+			kettle->index, target_temp / 100, target_temp % 100);
+	}
+
+	if (sample->flags & SENSOR_OFF_BASE) {
+		tts_invalidate(kettle);
+		ready_invalidate(kettle);
+		history_record(kettle, TEMP_INVALID_ZB, false);
+
+		/* Report invalid temperature to Zigbee if it changed */
+		if (kettle->dev_ctx.temp_measurement_attr.measured_value != TEMP_INVALID_ZB) {
+			set_water_temperature(kettle, TEMP_INVALID_ZB);
+
+			LOG_INF("Kettle %u off base - marked for reporting", kettle->index);
+		}
+	} else if (sample->flags & SENSOR_WATER) {
+		int16_t current_temp = sample->current_temp;
+
+		tts_update(kettle, current_temp);
+		ready_update(kettle, current_temp);
+		history_record(kettle, current_temp, false);
+		stream_sample(kettle, current_temp);
+
+		/* Check if temperature changed significantly (>0.5°C) */
+		int16_t diff = current_temp - kettle->dev_ctx.temp_measurement_attr.measured_value;
+		if (diff < 0) diff = -diff;
+
+		if (diff > 50 || kettle->dev_ctx.temp_measurement_attr.measured_value == TEMP_INVALID_ZB) {
+			/* Update both temperature measurement and thermostat local temp */
+			set_water_temperature(kettle, current_temp);
+
+			LOG_SAMPLE("Kettle %u: current temp %d.%02d°C",
+				   kettle->index, current_temp / 100, current_temp % 100);
+		}
+	}
+}
+
+/* ZBOSS callback: drain the sensor mailbox */
+static void sensor_drain_cb(zb_uint8_t param)
+{
+	struct sensor_sample *sample;
+
+	ARG_UNUSED(param);
+
+	/* Clear first: a sample posted while draining schedules another pass */
+	atomic_clear_bit(&sensor_flags, SENSOR_DRAIN_SCHEDULED);
+
+	while ((sample = spsc_consume(&sensor_mailbox)) != NULL) {
+		apply_temperatures(sample);
+		spsc_release(&sensor_mailbox);
+	}
+}
+
+/* ==========================================================================
+ * Sampling Cycle
+ *
+ * Runs on the sensor workqueue, paced by the ADC policy. A cycle takes one
+ * water reading per kettle: the kettles without a phase lock share a full
+ * burst that scans all their channels at once, then each locked kettle
+ * gets a short capture inside its own predicted low window. Once every
+ * kettle has its reading the samples are filtered and posted.
+ * ========================================================================== */
+
+static void adc_cycle_next(void);
+
+/**
+ * Start a current temperature capture; burst_done_work_handler() evaluates
+ * it once it completes.
+ *
+ * @param scan BIT(kettle index) of the kettles to capture
+ * @param locked true for a short capture inside the predicted low window of
+ *               the single kettle in scan, false for a full burst
+ */
+static void burst_capture(uint32_t scan, bool locked)
+{
+	uint32_t channels = 0;
+
+	ARRAY_FOR_EACH_PTR(kettles, kettle) {
+		if (scan & BIT(kettle->index)) {
+			channels |= BIT(kettle->hw->adc_current.channel_id);
+		}
+	}
+
+	burst_scan = scan;
+	burst_locked = locked;
+	diag_burst_cyc = k_cycle_get_32();
+
+	if (burst_sample_start(&kettles[__builtin_ctz(scan)].hw->adc_current, channels,
+			       locked ? PHASE_LOCKED_SAMPLE_COUNT : BURST_SAMPLE_COUNT) != 0) {
+		/* Their readings stay failed for this cycle */
+		adc_cycle_todo &= ~scan;
+		adc_cycle_next();
+	}
+}
+
+/**
+ * Capture the next kettle still waiting for its reading, or end the cycle
+ * once every kettle has one.
+ */
+static void adc_cycle_next(void)
+{
+	if (adc_cycle_todo == 0) {
+		ARRAY_FOR_EACH_PTR(kettles, kettle) {
+			update_temperatures(kettle, kettle->burst_adc);
+		}
+		if (++sensor_stats.cycles == 1) {
+			k_sem_give(&sensor_first_sem);
+		}
+		adc_cycle_finish();
+		return;
+	}
+
+	struct kettle_ctx *kettle = &kettles[__builtin_ctz(adc_cycle_todo)];
+
+	/* While locked, wait for the next low window instead of bursting */
+	if (kettle->burst_phase.locked) {
+		int32_t delay_us = burst_phase_schedule(&kettle->burst_phase, burst_clock_us());
+
+		if (delay_us >= 0) {
+			k_work_schedule_for_queue(&sensor_wq, &burst_start_work, K_USEC(delay_us));
+			return;
+		}
+		kettle->burst_phase.locked = false;
 	}
+
+	burst_capture(BIT(kettle->index), false);
 }
 
 static void adc_sample_work_handler(struct k_work *work)
 {
 	ARG_UNUSED(work);
 
-	update_temperatures();
+	int32_t late_cyc = (int32_t)(k_cycle_get_32() - diag_adc_due_cyc);
+	uint32_t full = 0;
+
+	diag_record(DIAG_WORKQUEUE_LATENCY, late_cyc > 0 ? k_cyc_to_us_floor32(late_cyc) : 0);
+
+	/* A request raced with a cycle already in flight; it will follow it */
+	if (atomic_test_and_set_bit(&adc_cycle_flags, ADC_CYCLE_BUSY)) {
+		return;
+	}
+	atomic_clear_bit(&adc_cycle_flags, ADC_CYCLE_REQUESTED);
+
+	/* Kettles without a usable lock share one full burst */
+	ARRAY_FOR_EACH_PTR(kettles, kettle) {
+		kettle->burst_adc = -1;
+		if (kettle->burst_phase.locked &&
+		    burst_phase_schedule(&kettle->burst_phase, burst_clock_us()) < 0) {
+			kettle->burst_phase.locked = false;
+		}
+		if (!kettle->burst_phase.locked) {
+			full |= BIT(kettle->index);
+		}
+	}
+	adc_cycle_todo = BIT_MASK(KETTLE_INSTANCE_COUNT);
+
+	if (full) {
+		burst_capture(full, false);
+	} else {
+		adc_cycle_next();
+	}
+}
+
+static void burst_start_work_handler(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	burst_capture(BIT(__builtin_ctz(adc_cycle_todo)), true);
+}
+
+static void burst_done_work_handler(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	uint32_t relearn = 0;
+
+	if (burst_sample_finish() == 0) {
+		diag_record(DIAG_BURST, diag_since_us(diag_burst_cyc));
+
+		ARRAY_FOR_EACH_PTR(kettles, kettle) {
+			if ((burst_scan & BIT(kettle->index)) &&
+			    burst_sample_eval(kettle, &kettle->burst_adc) == -EAGAIN) {
+				relearn |= BIT(kettle->index);
+			}
+		}
+	}
+	adc_cycle_todo &= ~(burst_scan & ~relearn);
+
+	if (relearn) {
+		/* Lock lost: take this cycle's reading from a full burst */
+		burst_capture(relearn, false);
+		return;
+	}
 
-	/* Schedule next sample */
-	k_work_schedule(&adc_sample_work, K_MSEC(ADC_SAMPLE_INTERVAL_MS));
+	adc_cycle_next();
 }
 
 /* ==========================================================================
@@ -758,6 +2684,43 @@ static void adc_sample_work_handler(struct k_work *work)
 static uint32_t health_uptime_hours = 0;
 static uint32_t health_report_count = 0;
 
+#ifdef CONFIG_KETTLE_RUNTIME_FOOTPRINT
+#if CONFIG_HEAP_MEM_POOL_SIZE > 0
+extern struct k_heap _system_heap;
+#endif
+
+/* Log one thread's stack high-water mark (stacks are painted at creation) */
+static void health_stack_cb(const struct k_thread *thread, void *user_data)
+{
+	const char *name = k_thread_name_get((k_tid_t)thread);
+	size_t unused;
+
+	ARG_UNUSED(user_data);
+
+	if (k_thread_stack_space_get(thread, &unused) == 0) {
+		LOG_INF("  Stack %s: %zu of %zu bytes used",
+			(name && name[0]) ? name : "?",
+			thread->stack_info.size - unused, thread->stack_info.size);
+	}
+}
+
+/* Peak stack use of every thread and of the system heap */
+static void health_footprint_log(void)
+{
+	k_thread_foreach_unlocked(health_stack_cb, NULL);
+
+#if CONFIG_HEAP_MEM_POOL_SIZE > 0
+	struct sys_memory_stats heap;
+
+	if (sys_heap_runtime_stats_get(&_system_heap.heap, &heap) == 0) {
+		LOG_INF("  Heap: %zu of %d bytes used (max %zu)",
+			heap.allocated_bytes, CONFIG_HEAP_MEM_POOL_SIZE,
+			heap.max_allocated_bytes);
+	}
+#endif
+}
+#endif
+
 static void health_monitor_work_handler(struct k_work *work)
 {
 	ARG_UNUSED(work);
@@ -769,16 +2732,44 @@ static void health_monitor_work_handler(struct k_work *work)
 	/* Log system health stats */
 	LOG_INF("=== Health Report #%u (uptime: %u hours) ===",
 		health_report_count, uptime_hours);
-	LOG_INF("  Kettle state: %s, system_mode: %d",
-		dev_ctx.on_off_attr.on_off ? "ON" : "OFF",
-		dev_ctx.thermostat_attr.system_mode);
-	LOG_INF("  Current temp: %d.%02d C, Target: %d.%02d C",
-		dev_ctx.temp_measurement_attr.measured_value / 100,
-		dev_ctx.temp_measurement_attr.measured_value % 100,
-		dev_ctx.thermostat_attr.occupied_heating_setpoint / 100,
-		dev_ctx.thermostat_attr.occupied_heating_setpoint % 100);
-	LOG_INF("  Report retries - state: %d, sys_mode: %d",
-		state_report_retry_count, system_mode_retry_count);
+	ARRAY_FOR_EACH_PTR(kettles, kettle) {
+		LOG_INF("  Kettle %u (ep %u): %s, system_mode %d, current %d.%02d C, target %d.%02d C, "
+			"stream %u s",
+			kettle->index, kettle->hw->endpoint,
+			kettle->dev_ctx.on_off_attr.on_off ? "ON" : "OFF",
+			kettle->dev_ctx.thermostat_attr.system_mode,
+			kettle->dev_ctx.temp_measurement_attr.measured_value / 100,
+			kettle->dev_ctx.temp_measurement_attr.measured_value % 100,
+			kettle->dev_ctx.thermostat_attr.occupied_heating_setpoint / 100,
+			kettle->dev_ctx.thermostat_attr.occupied_heating_setpoint % 100,
+			kettle->dev_ctx.kettle_attr.stream_interval);
+	}
+	LOG_INF("  Reports: pressure %d, alloc failures %u, retried %u, deferred %u, dropped %u",
+		report_stats.pressure, report_stats.alloc_failures, report_stats.retried,
+		report_stats.deferred, report_stats.dropped);
+	LOG_INF("  Buffers: pool low %u, OOM %u, in flight %u (max %u), APS failures %u, RTT max %u us",
+		report_stats.pool_low, report_stats.pool_oom, report_stats.in_flight,
+		report_stats.in_flight_max, report_stats.aps_failures,
+		diag_attr.hist[DIAG_APS_RTT].max_us);
+	LOG_INF("  Sensor: cycles %u, samples %u, read errors %u, mailbox drops %u",
+		sensor_stats.cycles, sensor_stats.samples, sensor_stats.read_errors,
+		sensor_dropped);
+	LOG_INF("  Stream: frames %u, dropped samples %u",
+		stream_stats.frames, stream_stats.dropped);
+#ifdef CONFIG_ZIGBEE_FOTA
+	LOG_INF("  OTA: %u%%, offset %u, %u B/s, block period %u ms",
+		ota_stats.progress, ota_stats.offset, ota_stats.throughput,
+		ota_stats.block_period);
+#endif
+	LOG_INF("  Timing max (us): burst %u, update %u, wq late %u, edge->report %u, buffer %u",
+		diag_attr.hist[DIAG_BURST].max_us,
+		diag_attr.hist[DIAG_UPDATE_TEMPS].max_us,
+		diag_attr.hist[DIAG_WORKQUEUE_LATENCY].max_us,
+		diag_attr.hist[DIAG_EDGE_TO_REPORT].max_us,
+		diag_attr.hist[DIAG_BUFFER_ACQUIRE].max_us);
+#ifdef CONFIG_KETTLE_RUNTIME_FOOTPRINT
+	health_footprint_log();
+#endif
 	LOG_INF("  ZB joined: %s", ZB_JOINED() ? "yes" : "no");
 
 	/* Track uptime milestones */
@@ -889,204 +2880,324 @@ static void set_tx_power(void)
  * Kettle State Machine and GPIO Handling
  * ========================================================================== */
 
-static const char *kettle_state_name(kettle_state_t state)
+static void report_kettle_on_off(struct kettle_ctx *kettle, zb_bool_t on)
+{
+	kettle->dev_ctx.on_off_attr.on_off = on;
+
+	/* Update thermostat system mode based on kettle state */
+	zb_uint8_t system_mode = on ?
+		ZB_ZCL_THERMOSTAT_SYSTEM_MODE_HEAT : ZB_ZCL_THERMOSTAT_SYSTEM_MODE_OFF;
+	kettle->dev_ctx.thermostat_attr.system_mode = system_mode;
+
+	/* Report immediately - one frame per cluster */
+	report_changed(kettle, BIT(REPORT_ON_OFF) | BIT(REPORT_SYSTEM_MODE));
+
+	LOG_INF("Kettle %u state changed: %s (system_mode=%d)",
+		kettle->index, on ? "ON" : "OFF", system_mode);
+}
+
+/**
+ * Move the state machine and publish it on the Kettle cluster heating
+ * state. Pending states are only published with CONFIG_KETTLE_OPTIMISTIC_STATE;
+ * the settled ON/OFF that follows (GPIO edge or transition timeout) always
+ * overwrites them, so a declined command shows starting -> off.
+ */
+static void kettle_state_set(struct kettle_ctx *kettle, kettle_state_t state)
 {
-	switch (state) {
-	case KETTLE_STATE_OFF: return "OFF";
-	case KETTLE_STATE_TURNING_ON: return "TURNING_ON";
-	case KETTLE_STATE_ON: return "ON";
-	case KETTLE_STATE_TURNING_OFF: return "TURNING_OFF";
-	default: return "UNKNOWN";
+	static const zb_uint8_t heating_state[] = {
+		[KETTLE_STATE_OFF] = ZB_KETTLE_HEATING_OFF,
+		[KETTLE_STATE_TURNING_ON] = ZB_KETTLE_HEATING_STARTING,
+		[KETTLE_STATE_ON] = ZB_KETTLE_HEATING_ON,
+		[KETTLE_STATE_TURNING_OFF] = ZB_KETTLE_HEATING_STOPPING,
+	};
+	bool pending = (state == KETTLE_STATE_TURNING_ON ||
+			state == KETTLE_STATE_TURNING_OFF);
+
+	kettle->heating_state = state;
+
+	if (pending && !IS_ENABLED(CONFIG_KETTLE_OPTIMISTIC_STATE)) {
+		return;
+	}
+	if (kettle->dev_ctx.kettle_attr.heating_state != heating_state[state]) {
+		kettle->dev_ctx.kettle_attr.heating_state = heating_state[state];
+		report_changed(kettle, BIT(REPORT_HEATING_STATE));
 	}
 }
 
-static void report_kettle_on_off(zb_bool_t on)
+/* Transition timeout expired (ZBOSS context) */
+static void kettle_transition_timeout(struct kettle_ctx *kettle)
 {
-	dev_ctx.on_off_attr.on_off = on;
+	bool gpio_heating = gpio_pin_get_dt(&kettle->hw->state_gpio) ? true : false;
+	kettle_state_t next = kettle_state_timeout(kettle->heating_state, gpio_heating);
 
-	ZB_ZCL_SET_ATTRIBUTE(
-		KETTLE_ENDPOINT,
-		ZB_ZCL_CLUSTER_ID_ON_OFF,
-		ZB_ZCL_CLUSTER_SERVER_ROLE,
-		ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID,
-		(zb_uint8_t *)&on,
-		ZB_FALSE);
+	if (k_work_delayable_is_pending(&kettle->transition_timeout_work)) {
+		/* Expired for an earlier command; a newer one has its own timeout */
+		return;
+	}
 
-	/* Update thermostat system mode based on kettle state */
-	zb_uint8_t system_mode = on ?
-		ZB_ZCL_THERMOSTAT_SYSTEM_MODE_HEAT : ZB_ZCL_THERMOSTAT_SYSTEM_MODE_OFF;
-	dev_ctx.thermostat_attr.system_mode = system_mode;
-
-	ZB_ZCL_SET_ATTRIBUTE(
-		KETTLE_ENDPOINT,
-		ZB_ZCL_CLUSTER_ID_THERMOSTAT,
-		ZB_ZCL_CLUSTER_SERVER_ROLE,
-		ZB_ZCL_ATTR_THERMOSTAT_SYSTEM_MODE_ID,
-		&system_mode,
-		ZB_FALSE);
+	if (kettle->heating_state == KETTLE_STATE_TURNING_ON) {
+		LOG_WRN("Kettle %u declined to heat (timeout) - no water?", kettle->index);
+	} else if (kettle->heating_state == KETTLE_STATE_TURNING_OFF) {
+		/* Unusual, just report current state */
+		LOG_WRN("Kettle %u turn-off timeout", kettle->index);
+	} else {
+		return;
+	}
+
+	kettle_state_set(kettle, next);
+	report_kettle_on_off(kettle, next == KETTLE_STATE_ON ? ZB_TRUE : ZB_FALSE);
+}
+
+static void update_kettle_state(struct kettle_ctx *kettle)
+{
+	bool gpio_heating = gpio_pin_get_dt(&kettle->hw->state_gpio) ? true : false;
+	kettle_state_t prev_state = kettle->heating_state;
+	kettle_state_t next = kettle_state_next(prev_state, gpio_heating);
+	bool commanded = (prev_state == KETTLE_STATE_TURNING_ON ||
+			  prev_state == KETTLE_STATE_TURNING_OFF);
+
+	if (next != prev_state) {
+		if (commanded) {
+			/* Transition complete - kettle accepted the command */
+			k_work_cancel_delayable(&kettle->transition_timeout_work);
+		}
+		kettle_state_set(kettle, next);
+		report_kettle_on_off(kettle, next == KETTLE_STATE_ON ? ZB_TRUE : ZB_FALSE);
+		LOG_INF("Kettle %u heating %s%s", kettle->index,
+			next == KETTLE_STATE_ON ? "started" : "stopped",
+			commanded ? " (command accepted)" : "");
+
+		LOG_INF("Kettle %u state: %s -> %s", kettle->index,
+			kettle_state_name(prev_state),
+			kettle_state_name(kettle->heating_state));
 
-	/* Schedule immediate report via ZBOSS callback */
-	schedule_state_report();
+		history_note_state(kettle);
+		if (kettle->heating_state != KETTLE_STATE_ON) {
+			stream_flush_now(kettle);
+		}
 
-	LOG_INF("Kettle state changed: %s (system_mode=%d)", on ? "ON" : "OFF", system_mode);
+		/* Pick up the new sampling rate without waiting out an idle interval */
+		request_adc_sample_now();
+	} else if (kettle->heating_state == KETTLE_STATE_ON ||
+		   kettle->heating_state == KETTLE_STATE_OFF) {
+		/* Edge without a state change: nothing will be reported for it */
+		atomic_clear_bit(&kettle->diag_flags, DIAG_EDGE_PENDING);
+	}
 }
 
-static void kettle_transition_timeout_handler(struct k_work *work)
+/*
+ * The state machine and the attributes it writes belong to ZBOSS context,
+ * like zcl_device_cb(), which moves the state on a command. The state GPIO
+ * edge (ISR or poll) and the transition timeout only set an event bit; the
+ * system workqueue hands the events over with zigbee_schedule_callback(),
+ * retrying while the scheduler queue is full so an edge is never lost.
+ */
+#define KETTLE_EVENT_EDGE       0       /* state GPIO changed */
+#define KETTLE_EVENT_TIMEOUT    1       /* transition timeout expired */
+#define KETTLE_EVENT_SCHEDULED  2       /* kettle_state_cb() queued */
+#define KETTLE_EVENT_RETRY_MS   10
+
+static void kettle_state_cb(zb_uint8_t param)
 {
-	ARG_UNUSED(work);
+	struct kettle_ctx *kettle = &kettles[param];
+	/* Clear first: an event racing with this one schedules another call */
+	atomic_val_t events = atomic_clear(&kettle->state_events);
 
-	if (kettle_heating_state == KETTLE_STATE_TURNING_ON) {
-		/* Timeout waiting for kettle to start heating - kettle declined */
-		LOG_WRN("Kettle declined to heat (timeout) - no water?");
-		kettle_heating_state = KETTLE_STATE_OFF;
-		report_kettle_on_off(ZB_FALSE);
-	} else if (kettle_heating_state == KETTLE_STATE_TURNING_OFF) {
-		/* Timeout waiting for kettle to stop - unusual, just report current state */
-		LOG_WRN("Kettle turn-off timeout");
-		bool actual_state = gpio_pin_get_dt(&kettle_state_gpio);
-		kettle_heating_state = actual_state ? KETTLE_STATE_ON : KETTLE_STATE_OFF;
-		report_kettle_on_off(actual_state ? ZB_TRUE : ZB_FALSE);
+	if (events & BIT(KETTLE_EVENT_EDGE)) {
+		update_kettle_state(kettle);
+	}
+	if (events & BIT(KETTLE_EVENT_TIMEOUT)) {
+		kettle_transition_timeout(kettle);
 	}
 }
 
-static void update_kettle_state(void)
+static void kettle_state_work_handler(struct k_work *work)
 {
-	bool gpio_heating = gpio_pin_get_dt(&kettle_state_gpio) ? true : false;
-	kettle_state_t prev_state = kettle_heating_state;
-
-	switch (kettle_heating_state) {
-	case KETTLE_STATE_OFF:
-		if (gpio_heating) {
-			/* Kettle started heating (physical button or external) */
-			kettle_heating_state = KETTLE_STATE_ON;
-			report_kettle_on_off(ZB_TRUE);
-			LOG_INF("Kettle heating started");
-		}
-		break;
+	struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+	struct kettle_ctx *kettle = CONTAINER_OF(dwork, struct kettle_ctx, state_work);
 
-	case KETTLE_STATE_TURNING_ON:
-		if (gpio_heating) {
-			/* Transition complete - kettle accepted the command */
-			k_work_cancel_delayable(&kettle_transition_timeout_work);
-			kettle_heating_state = KETTLE_STATE_ON;
-			report_kettle_on_off(ZB_TRUE);
-			LOG_INF("Kettle heating started (command accepted)");
-		}
-		/* If not heating yet, wait for timeout */
-		break;
+	if (atomic_test_and_set_bit(&kettle->state_events, KETTLE_EVENT_SCHEDULED)) {
+		return;
+	}
+	if (zigbee_schedule_callback(kettle_state_cb, kettle->index) != RET_OK) {
+		atomic_clear_bit(&kettle->state_events, KETTLE_EVENT_SCHEDULED);
+		k_work_schedule(&kettle->state_work, K_MSEC(KETTLE_EVENT_RETRY_MS));
+	}
+}
 
-	case KETTLE_STATE_ON:
-		if (!gpio_heating) {
-			/* Kettle stopped heating (reached temp, manual off, or lifted) */
-			kettle_heating_state = KETTLE_STATE_OFF;
-			report_kettle_on_off(ZB_FALSE);
-			LOG_INF("Kettle heating stopped");
-		}
-		break;
+/* Any context: queue a state event for kettle_state_cb() */
+static void kettle_state_post(struct kettle_ctx *kettle, int event)
+{
+	atomic_set_bit(&kettle->state_events, event);
+	k_work_reschedule(&kettle->state_work, K_NO_WAIT);
+}
 
-	case KETTLE_STATE_TURNING_OFF:
-		if (!gpio_heating) {
-			/* Transition complete - kettle turned off */
-			k_work_cancel_delayable(&kettle_transition_timeout_work);
-			kettle_heating_state = KETTLE_STATE_OFF;
-			report_kettle_on_off(ZB_FALSE);
-			LOG_INF("Kettle heating stopped (command accepted)");
-		}
-		/* If still heating, wait for timeout */
-		break;
-	}
+static void kettle_transition_timeout_handler(struct k_work *work)
+{
+	struct k_work_delayable *dwork = k_work_delayable_from_work(work);
 
-	if (prev_state != kettle_heating_state) {
-		LOG_INF("Kettle state: %s -> %s",
-			kettle_state_name(prev_state),
-			kettle_state_name(kettle_heating_state));
-	}
+	kettle_state_post(CONTAINER_OF(dwork, struct kettle_ctx, transition_timeout_work),
+			  KETTLE_EVENT_TIMEOUT);
 }
 
 static void kettle_state_gpio_handler(const struct device *dev,
 				      struct gpio_callback *cb,
 				      uint32_t pins)
 {
+	struct kettle_ctx *kettle = CONTAINER_OF(cb, struct kettle_ctx, state_cb_data);
+
 	ARG_UNUSED(dev);
-	ARG_UNUSED(cb);
 	ARG_UNUSED(pins);
 
-	update_kettle_state();
+	kettle->diag_edge_cyc = k_cycle_get_32();
+	atomic_set_bit(&kettle->diag_flags, DIAG_EDGE_PENDING);
+
+	/* Attribute updates and reports are not ISR-safe; defer to ZBOSS context */
+	kettle_state_post(kettle, KETTLE_EVENT_EDGE);
 }
 
 /* ==========================================================================
  * Kettle Button Simulation - Pulse GPIO to simulate physical button press
  * ========================================================================== */
 
-static void kettle_button_release_handler(struct k_work *work)
+/*
+ * Pulse edges are driven from a k_timer expiry (system clock ISR) rather
+ * than workqueue items, so a busy workqueue can no longer stretch a press
+ * into a long press. The button output sits on P2, which has no GPIOTE,
+ * so a TIMER/DPPI-driven pin task is not available on this board; the
+ * GRTC tick (~30 us) bounds width jitter instead. Each kettle has its
+ * own timer, so kettles can be pressed at the same time.
+ */
+static void kettle_pulse_timer_handler(struct k_timer *timer)
 {
-	ARG_UNUSED(work);
+	struct kettle_ctx *kettle = CONTAINER_OF(timer, struct kettle_ctx, pulse_timer);
+	bool pressed;
+	uint32_t hold_ms;
+
+	if (!button_seq_step(&kettle->pulse_seq, &pressed, &hold_ms)) {
+		/* Sequences end on a press; release the line */
+		gpio_pin_set_dt(&kettle->hw->button_gpio, 0);
+		atomic_clear(&kettle->pulse_busy);
+		return;
+	}
 
-	/* Release the simulated button press */
-	gpio_pin_set_dt(&kettle_button_gpio, 0);
-	LOG_DBG("Kettle button released");
+	gpio_pin_set_dt(&kettle->hw->button_gpio, pressed);
+	k_timer_start(timer, K_MSEC(hold_ms), K_NO_WAIT);
 }
 
 /**
- * Simulate a button press on the kettle by pulsing the GPIO output.
- * This pulls the kettle's 5V button line low via the MOSFET for a short duration.
+ * Play a press sequence on a kettle's button line.
+ *
+ * @param steps Durations in ms alternating press/gap, starting and ending
+ *              with a press (odd count), e.g. {200, 200, 200} for a
+ *              double press
+ * @param count Number of steps, at most KETTLE_BUTTON_SEQ_MAX
+ * @return 0 once the sequence has started, -ENODEV if the output is not
+ *         ready, -EBUSY while a sequence is still playing, -EINVAL on a
+ *         malformed sequence
  */
-static void simulate_kettle_button_press(void)
+static int kettle_button_sequence(struct kettle_ctx *kettle, const uint16_t *steps,
+				  uint8_t count)
 {
-	if (!device_is_ready(kettle_button_gpio.port)) {
-		LOG_WRN("Kettle button GPIO not ready");
-		return;
+	int err;
+
+	if (!device_is_ready(kettle->hw->button_gpio.port)) {
+		LOG_WRN("Kettle %u button GPIO not ready", kettle->index);
+		return -ENODEV;
+	}
+
+	if (!atomic_cas(&kettle->pulse_busy, 0, 1)) {
+		/* A second press mid-pulse would just toggle the kettle back */
+		LOG_WRN("Kettle %u button busy, sequence dropped", kettle->index);
+		return -EBUSY;
+	}
+
+	err = button_seq_load(&kettle->pulse_seq, steps, count);
+	if (err) {
+		atomic_clear(&kettle->pulse_busy);
+		return err;
 	}
 
-	LOG_INF("Simulating kettle button press");
+	/* First edge from the timer ISR too, so all edges share one clock */
+	k_timer_start(&kettle->pulse_timer, K_NO_WAIT, K_NO_WAIT);
+	return 0;
+}
+
+/**
+ * Simulate a button press on the kettle by pulsing the GPIO output.
+ * This pulls the kettle's 5V button line low via the MOSFET for a short duration.
+ *
+ * @return 0 once the press has started, -ENODEV if the output is not
+ *         ready, -EBUSY while the previous press is still held
+ */
+static int simulate_kettle_button_press(struct kettle_ctx *kettle)
+{
+	static const uint16_t single[] = { KETTLE_BUTTON_PULSE_MS };
 
-	/* Press the button (pull line low via MOSFET) */
-	gpio_pin_set_dt(&kettle_button_gpio, 1);
+	LOG_INF("Simulating kettle %u button press", kettle->index);
 
-	/* Schedule release after pulse duration */
-	k_work_schedule(&kettle_button_release_work, K_MSEC(KETTLE_BUTTON_PULSE_MS));
+	return kettle_button_sequence(kettle, single, ARRAY_SIZE(single));
 }
 
 /**
  * Request kettle to turn on via Zigbee command.
  * Simulates button press and starts transition timeout.
+ *
+ * @return 0 if pressed or already on, negative error if the press was
+ *         refused (state and timeout are left alone)
  */
-static void request_kettle_on(void)
+static int request_kettle_on(struct kettle_ctx *kettle)
 {
-	if (kettle_heating_state == KETTLE_STATE_ON ||
-	    kettle_heating_state == KETTLE_STATE_TURNING_ON) {
-		LOG_INF("Kettle already on or turning on");
-		return;
+	kettle_state_t next = kettle_state_command(kettle->heating_state, true);
+	int err;
+
+	if (next == kettle->heating_state) {
+		LOG_INF("Kettle %u already on or turning on", kettle->index);
+		return 0;
 	}
 
-	LOG_INF("Requesting kettle ON");
-	kettle_heating_state = KETTLE_STATE_TURNING_ON;
-	simulate_kettle_button_press();
+	LOG_INF("Requesting kettle %u ON", kettle->index);
+	err = simulate_kettle_button_press(kettle);
+	if (err) {
+		/* Nothing pressed: stay in the current state, no timeout */
+		return err;
+	}
+	kettle_state_set(kettle, next);
 
 	/* Start timeout - if kettle doesn't respond, it declined */
-	k_work_schedule(&kettle_transition_timeout_work,
+	k_work_schedule(&kettle->transition_timeout_work,
 			K_MSEC(KETTLE_TRANSITION_TIMEOUT_MS));
+	return 0;
 }
 
 /**
  * Request kettle to turn off via Zigbee command.
  * Simulates button press and starts transition timeout.
+ *
+ * @return 0 if pressed or already off, negative error if the press was
+ *         refused (state and timeout are left alone)
  */
-static void request_kettle_off(void)
+static int request_kettle_off(struct kettle_ctx *kettle)
 {
-	if (kettle_heating_state == KETTLE_STATE_OFF ||
-	    kettle_heating_state == KETTLE_STATE_TURNING_OFF) {
-		LOG_INF("Kettle already off or turning off");
-		return;
+	kettle_state_t next = kettle_state_command(kettle->heating_state, false);
+	int err;
+
+	if (next == kettle->heating_state) {
+		LOG_INF("Kettle %u already off or turning off", kettle->index);
+		return 0;
 	}
 
-	LOG_INF("Requesting kettle OFF");
-	kettle_heating_state = KETTLE_STATE_TURNING_OFF;
-	simulate_kettle_button_press();
+	LOG_INF("Requesting kettle %u OFF", kettle->index);
+	err = simulate_kettle_button_press(kettle);
+	if (err) {
+		return err;
+	}
+	kettle_state_set(kettle, next);
 
 	/* Start timeout */
-	k_work_schedule(&kettle_transition_timeout_work,
+	k_work_schedule(&kettle->transition_timeout_work,
 			K_MSEC(KETTLE_TRANSITION_TIMEOUT_MS));
+	return 0;
 }
 
 /* ==========================================================================
@@ -1152,10 +3263,28 @@ static void button_work_handler(struct k_work *work)
 		button_state.pressed = false;
 		k_work_cancel_delayable(&long_press_work);
 
-		int64_t duration = k_uptime_get() - button_state.press_time;
+		int64_t now = k_uptime_get();
+		int64_t duration = now - button_state.press_time;
 		if (duration < BUTTON_LONG_PRESS_MS) {
-			/* Short press - just log, no action */
-			LOG_INF("Pairing button short press (%lld ms) - ignored", duration);
+			LOG_INF("Pairing button short press (%lld ms)", duration);
+
+			/* In calibration mode each press captures the next point
+			 * (the button calibrates the first kettle only)
+			 */
+			if (kettles[0].cal_session.active) {
+				calibration_button_press(&kettles[0]);
+				return;
+			}
+
+			/* A quick series of short presses enters calibration mode */
+			if (now - button_state.first_short_ms > BUTTON_CAL_WINDOW_MS) {
+				button_state.first_short_ms = now;
+				button_state.short_presses = 0;
+			}
+			if (++button_state.short_presses >= BUTTON_CAL_PRESSES) {
+				button_state.short_presses = 0;
+				calibration_start(&kettles[0]);
+			}
 		}
 	}
 }
@@ -1174,6 +3303,7 @@ static void long_press_work_handler(struct k_work *work)
 		}
 
 		/* Leave network and restart steering */
+		persist_flush_now();
 		if (ZB_JOINED()) {
 			zb_bdb_reset_via_local_action(0);
 		}
@@ -1215,50 +3345,86 @@ static int button_init(void)
 		return ret;
 	}
 
-	/* Note: GPIO interrupts not working on nRF54L15, using polling instead */
+	k_work_init(&button_work, button_work_handler);
+	k_work_init_delayable(&long_press_work, long_press_work_handler);
+
+	/* Edge interrupts need a GPIOTE instance on the pin's port; nRF54L15
+	 * has none on P2, so pins there fall back to polling from main().
+	 */
 	gpio_init_callback(&button_cb_data, button_gpio_handler, BIT(button.pin));
 	ret = gpio_add_callback(button.port, &button_cb_data);
+	if (ret == 0) {
+		ret = gpio_pin_interrupt_configure_dt(&button, GPIO_INT_EDGE_BOTH);
+	}
 	if (ret < 0) {
-		LOG_WRN("Pairing button callback add failed: %d (using polling)", ret);
+		LOG_WRN("Pairing button has no edge interrupt: %d (using polling)", ret);
+		gpio_polled_inputs |= GPIO_POLL_BUTTON;
 	}
 
-	k_work_init(&button_work, button_work_handler);
-	k_work_init_delayable(&long_press_work, long_press_work_handler);
-
-	LOG_INF("Pairing button initialized (P2.%d)", button.pin);
+	LOG_INF("Pairing button initialized (pin %d, %s)", button.pin,
+		(gpio_polled_inputs & GPIO_POLL_BUTTON) ? "polled" : "interrupt");
 	return 0;
 }
 
-static int kettle_state_init(void)
+static int kettle_state_init(struct kettle_ctx *kettle)
 {
+	const struct gpio_dt_spec *state_gpio = &kettle->hw->state_gpio;
 	int ret;
 
-	if (!device_is_ready(kettle_state_gpio.port)) {
-		LOG_ERR("Kettle state GPIO device not ready");
+	if (!device_is_ready(state_gpio->port)) {
+		LOG_ERR("Kettle %u state GPIO device not ready", kettle->index);
 		return -ENODEV;
 	}
 
-	ret = gpio_pin_configure_dt(&kettle_state_gpio, GPIO_INPUT);
+	ret = gpio_pin_configure_dt(state_gpio, GPIO_INPUT);
 	if (ret < 0) {
-		LOG_ERR("Kettle state GPIO config failed: %d", ret);
+		LOG_ERR("Kettle %u state GPIO config failed: %d", kettle->index, ret);
 		return ret;
 	}
 
-	/* Note: GPIO interrupts not working on nRF54L15, using polling instead */
-	gpio_init_callback(&kettle_state_cb_data, kettle_state_gpio_handler,
-			   BIT(kettle_state_gpio.pin));
-	ret = gpio_add_callback(kettle_state_gpio.port, &kettle_state_cb_data);
+	gpio_init_callback(&kettle->state_cb_data, kettle_state_gpio_handler,
+			   BIT(state_gpio->pin));
+	ret = gpio_add_callback(state_gpio->port, &kettle->state_cb_data);
+	if (ret == 0) {
+		ret = gpio_pin_interrupt_configure_dt(state_gpio, GPIO_INT_EDGE_BOTH);
+	}
 	if (ret < 0) {
-		LOG_WRN("Kettle state callback add failed: %d (using polling)", ret);
+		LOG_WRN("Kettle %u state has no edge interrupt: %d (using polling)",
+			kettle->index, ret);
+		kettle->state_polled = true;
+		gpio_polled_inputs |= GPIO_POLL_KETTLE_STATE;
 	}
 
 	/* Initialize state machine from current GPIO state */
-	bool initial_heating = gpio_pin_get_dt(&kettle_state_gpio) ? true : false;
-	kettle_heating_state = initial_heating ? KETTLE_STATE_ON : KETTLE_STATE_OFF;
-	report_kettle_on_off(initial_heating ? ZB_TRUE : ZB_FALSE);
+	bool initial_heating = gpio_pin_get_dt(state_gpio) ? true : false;
+	kettle_state_set(kettle, initial_heating ? KETTLE_STATE_ON : KETTLE_STATE_OFF);
+	report_kettle_on_off(kettle, initial_heating ? ZB_TRUE : ZB_FALSE);
+
+	LOG_INF("Kettle %u state GPIO initialized (heating=%s, %s)", kettle->index,
+		initial_heating ? "ON" : "OFF", kettle->state_polled ? "polled" : "interrupt");
+	return 0;
+}
+
+/**
+ * Check that the water channels can share one scan: the SAADC scans
+ * channels of one device at one resolution, and only without oversampling.
+ */
+static int adc_scan_check(void)
+{
+	const struct adc_dt_spec *first = &kettles[0].hw->adc_current;
+	uint32_t channels = 0;
 
-	LOG_INF("Kettle state GPIO initialized (heating=%s)",
-		initial_heating ? "ON" : "OFF");
+	ARRAY_FOR_EACH_PTR(kettles, kettle) {
+		const struct adc_dt_spec *spec = &kettle->hw->adc_current;
+
+		if (spec->dev != first->dev || spec->resolution != first->resolution ||
+		    spec->oversampling != 0 || (channels & BIT(spec->channel_id))) {
+			LOG_ERR("Kettle %u water channel %u cannot join the scan",
+				kettle->index, spec->channel_id);
+			return -EINVAL;
+		}
+		channels |= BIT(spec->channel_id);
+	}
 	return 0;
 }
 
@@ -1266,50 +3432,95 @@ static int adc_init(void)
 {
 	int ret;
 
-	/* Check if ADC channels are ready */
-	if (!adc_is_ready_dt(&adc_target_temp)) {
-		LOG_ERR("ADC target temp channel not ready");
-		return -ENODEV;
-	}
+	ARRAY_FOR_EACH_PTR(kettles, kettle) {
+		const struct kettle_hw *hw = kettle->hw;
 
-	if (!adc_is_ready_dt(&adc_current_temp)) {
-		LOG_ERR("ADC current temp channel not ready");
-		return -ENODEV;
-	}
+		/* Check if ADC channels are ready */
+		if (!adc_is_ready_dt(&hw->adc_target)) {
+			LOG_ERR("Kettle %u ADC target temp channel not ready", kettle->index);
+			return -ENODEV;
+		}
 
-	/* Configure channel 0 (target temperature) */
-	ret = adc_channel_setup_dt(&adc_target_temp);
-	if (ret < 0) {
-		LOG_ERR("ADC channel 0 setup failed: %d", ret);
-		return ret;
+		if (!adc_is_ready_dt(&hw->adc_current)) {
+			LOG_ERR("Kettle %u ADC current temp channel not ready", kettle->index);
+			return -ENODEV;
+		}
+
+		/* Configure the dial (target temperature) channel */
+		ret = adc_channel_setup_dt(&hw->adc_target);
+		if (ret < 0) {
+			LOG_ERR("ADC channel %u setup failed: %d", hw->adc_target.channel_id, ret);
+			return ret;
+		}
+
+		/* Configure the water (current temperature) channel */
+		ret = adc_channel_setup_dt(&hw->adc_current);
+		if (ret < 0) {
+			LOG_ERR("ADC channel %u setup failed: %d", hw->adc_current.channel_id, ret);
+			return ret;
+		}
 	}
 
-	/* Configure channel 1 (current temperature) */
-	ret = adc_channel_setup_dt(&adc_current_temp);
+	ret = adc_scan_check();
 	if (ret < 0) {
-		LOG_ERR("ADC channel 1 setup failed: %d", ret);
 		return ret;
 	}
 
 	k_work_init_delayable(&adc_sample_work, adc_sample_work_handler);
+	k_work_init_delayable(&adc_dial_watch_work, adc_dial_watch_work_handler);
 
-	LOG_INF("ADC initialized");
+	/* Burst completion is delivered by the driver raising burst_signal */
+	k_poll_signal_init(&burst_signal);
+	k_poll_event_init(&burst_event, K_POLL_TYPE_SIGNAL, K_POLL_MODE_NOTIFY_ONLY,
+			  &burst_signal);
+	k_work_poll_init(&burst_done_work, burst_done_work_handler);
+	k_work_init_delayable(&burst_start_work, burst_start_work_handler);
+
+	LOG_INF("ADC initialized (%u kettles)", (unsigned int)KETTLE_INSTANCE_COUNT);
 	return 0;
 }
 
 /* ==========================================================================
  * Zigbee Reporting
  *
- * Hybrid approach:
- * - Temperature: Uses stack's automatic reporting (frequent, benefits from
- *   stack-managed timing and buffering)
- * - On/Off + System Mode: Manual report via ZBOSS callback (infrequent state
- *   changes need immediate feedback to coordinator)
+ * Report coalescer:
+ * - Attribute changes only set a dirty bit via report_changed(). A short
+ *   coalescing window later, report_flush_cb() runs in ZBOSS context and
+ *   emits one Report Attributes frame per cluster carrying every dirty
+ *   attribute that is due.
+ * - Each attribute has a minimum interval, so fast-moving temperatures are
+ *   rate limited while state changes go out immediately.
+ * - The stack's automatic reporting stays configured as heartbeat/backup
+ *   (see configure_reporting()); coalesced attributes are written directly
+ *   to the kettle's dev_ctx so they don't also trigger a stack report.
+ * - Every kettle has its own dirty bits, rate limits and queue slots, but
+ *   they share one flush pass, buffer pressure and in-flight table. A ZCL
+ *   frame carries a single source endpoint, so kettles cannot share a
+ *   frame; the pass serves all kettles' state frames before any of their
+ *   temperatures.
+ *
+ * Report queue:
+ * - Each cluster frame is a queue slot with the priority of its most
+ *   important dirty attribute: state, then setpoint, then temperature.
+ * - Slots back off individually after failed allocations; only lower
+ *   priority changes are ever dropped.
+ * - Failed allocations raise a buffer pressure level that defers
+ *   temperature (then setpoint) frames while the mesh is busy forwarding.
+ *
+ * Addressing:
+ * - Frames go through the APS binding table, so bound devices and groups
+ *   (wall displays, Zigbee2MQTT once it binds at configure) get them
+ *   directly at mesh latency. On/Off commands from bound switches reach
+ *   zcl_device_cb() like any other On/Off command.
+ * - A bound frame the stack could not send for lack of a binding on the
+ *   cluster is resent straight to the coordinator. Any other failure (a
+ *   sleepy display missing its APS ACK) is only counted: resending it
+ *   would repeat the frame to every working destination, and the stack's
+ *   backup reporting covers the device that missed it.
  *
  * Buffer Management (per Nordic best practices):
  * - Use callbacks on ZB_ZCL_SEND_COMMAND_SHORT to track buffer lifecycle
- * - Implement retry backoff with limits to prevent runaway loops
- * - Combine multiple attributes in single report when possible
+ * - One buffer per cluster frame, however many attributes changed
  * ========================================================================== */
 
 /* Retry management for report sending */
@@ -1317,67 +3528,269 @@ static int adc_init(void)
 #define REPORT_INITIAL_DELAY_MS 100
 #define REPORT_MAX_DELAY_MS     10000
 
-static bool state_report_pending = false;
+/* Window over which attribute changes are gathered into one frame */
+#define REPORT_COALESCE_MS      20
+
+/* Buffer pressure: raised by each failed allocation, decays while none fail */
+#define REPORT_PRESSURE_MAX      4
+#define REPORT_PRESSURE_DECAY_MS 2000
+
+/* Report priorities, highest first */
+enum report_prio {
+	REPORT_PRIO_STATE,          /* on/off, system mode - never dropped */
+	REPORT_PRIO_SETPOINT,
+	REPORT_PRIO_TEMP,
+	REPORT_PRIO_COUNT
+};
+
+/* Attribute reported by the coalescer */
+struct report_attr_desc {
+	zb_uint16_t cluster_id;
+	zb_uint16_t attr_id;
+	zb_uint8_t  type;
+	zb_uint8_t  size;           /* value size in bytes (1 or 2) */
+	size_t      offset;         /* value in kettle_device_ctx_t */
+	uint16_t    min_interval_ms;
+	uint8_t     prio;           /* enum report_prio */
+};
+
+#define REPORT_VALUE(member)						\
+	sizeof(((kettle_device_ctx_t *)0)->member), offsetof(kettle_device_ctx_t, member)
+
+static const struct report_attr_desc report_attrs[REPORT_ATTR_COUNT] = {
+	[REPORT_ON_OFF] = {
+		ZB_ZCL_CLUSTER_ID_ON_OFF, ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID,
+		ZB_ZCL_ATTR_TYPE_BOOL, REPORT_VALUE(on_off_attr.on_off), 0, REPORT_PRIO_STATE,
+	},
+	[REPORT_SYSTEM_MODE] = {
+		ZB_ZCL_CLUSTER_ID_THERMOSTAT, ZB_ZCL_ATTR_THERMOSTAT_SYSTEM_MODE_ID,
+		ZB_ZCL_ATTR_TYPE_8BIT_ENUM, REPORT_VALUE(thermostat_attr.system_mode), 0, REPORT_PRIO_STATE,
+	},
+	[REPORT_HEATING_SETPOINT] = {
+		ZB_ZCL_CLUSTER_ID_THERMOSTAT, ZB_ZCL_ATTR_THERMOSTAT_OCCUPIED_HEATING_SETPOINT_ID,
+		ZB_ZCL_ATTR_TYPE_S16, REPORT_VALUE(thermostat_attr.occupied_heating_setpoint), 500, REPORT_PRIO_SETPOINT,
+	},
+#ifndef CONFIG_KETTLE_LOCAL_TEMP_ALIAS
+	[REPORT_LOCAL_TEMP] = {
+		ZB_ZCL_CLUSTER_ID_THERMOSTAT, ZB_ZCL_ATTR_THERMOSTAT_LOCAL_TEMPERATURE_ID,
+		ZB_ZCL_ATTR_TYPE_S16, REPORT_VALUE(thermostat_attr.local_temperature), 5000, REPORT_PRIO_TEMP,
+	},
+#endif
+	[REPORT_MEASURED_VALUE] = {
+		ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT, ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_ID,
+		ZB_ZCL_ATTR_TYPE_S16, REPORT_VALUE(temp_measurement_attr.measured_value), 5000, REPORT_PRIO_TEMP,
+	},
+	[REPORT_WATER_READY] = {
+		ZB_ZCL_CLUSTER_ID_KETTLE, ZB_ZCL_ATTR_KETTLE_WATER_READY_ID,
+		ZB_ZCL_ATTR_TYPE_8BIT_ENUM, REPORT_VALUE(kettle_attr.water_ready), 0, REPORT_PRIO_STATE,
+	},
+	[REPORT_HEATING_STATE] = {
+		ZB_ZCL_CLUSTER_ID_KETTLE, ZB_ZCL_ATTR_KETTLE_HEATING_STATE_ID,
+		ZB_ZCL_ATTR_TYPE_8BIT_ENUM, REPORT_VALUE(kettle_attr.heating_state), 0, REPORT_PRIO_STATE,
+	},
+};
+
+/* Clusters with a report queue slot each (REPORT_CLUSTER_COUNT) */
+static const struct report_cluster_desc {
+	zb_uint16_t cluster_id;
+	zb_uint16_t manuf_code;     /* ZB_ZCL_MANUF_CODE_INVALID for standard frames */
+} report_clusters[] = {
+	{ ZB_ZCL_CLUSTER_ID_ON_OFF, ZB_ZCL_MANUF_CODE_INVALID },
+	{ ZB_ZCL_CLUSTER_ID_THERMOSTAT, ZB_ZCL_MANUF_CODE_INVALID },
+	{ ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT, ZB_ZCL_MANUF_CODE_INVALID },
+	{ ZB_ZCL_CLUSTER_ID_KETTLE, ZB_KETTLE_MANUF_CODE },
+};
+
+BUILD_ASSERT(ARRAY_SIZE(report_clusters) == REPORT_CLUSTER_COUNT,
+	     "REPORT_CLUSTER_COUNT out of step with report_clusters[]");
+
+/* Value of a coalesced attribute of a kettle */
+static inline const void *report_value(const struct kettle_ctx *kettle,
+				       const struct report_attr_desc *desc)
+{
+	return (const uint8_t *)&kettle->dev_ctx + desc->offset;
+}
+
+/* Own frames awaiting report_sent_cb(), for APS round trip times. If a
+ * callback never comes the oldest slot is reused.
+ */
+#define REPORT_IN_FLIGHT_SLOTS  8
+static struct {
+	zb_bufid_t bufid;           /* 0 = free */
+	uint32_t   sent_cyc;
+	uint32_t   bound_mask;      /* attributes sent via bindings, resent direct if unbound */
+	uint8_t    kettle;          /* index into kettles[] */
+	uint8_t    cluster;         /* index into report_clusters[] */
+} report_in_flight[REPORT_IN_FLIGHT_SLOTS];
+
+static atomic_t report_flags;
+#define REPORT_FLUSH_SCHEDULED  0                   /* report_flush_cb() alarm queued */
+static int64_t report_pressure_ms;                  /* uptime of last pressure change */
 static bool buffer_request_pending = false;  /* Guards zb_buf_get_out_delayed accumulation */
 static bool reporting_configured = false;    /* Prevents duplicate reporting setup on rejoin */
-static bool target_temp_report_pending = false;  /* For target temperature reports */
 
-/* Forward declarations for ZBOSS callbacks */
-static void send_state_report_cb(zb_uint8_t param);
-static void send_system_mode_report_cb(zb_uint8_t param);
-static void send_target_temp_report_cb(zb_uint8_t param);
-static void report_sent_cb(zb_uint8_t param);
-static void system_mode_sent_cb(zb_uint8_t param);
-static void target_temp_sent_cb(zb_uint8_t param);
-static void get_buffer_for_report_cb(zb_uint8_t param);
+/* Everything the coordinator shows, sent in one frame per cluster once joined */
+#define REPORT_HELLO_MASK       (BIT(REPORT_ON_OFF) | BIT(REPORT_SYSTEM_MODE) | \
+				 BIT(REPORT_HEATING_SETPOINT) | REPORT_TEMP_MASK | \
+				 BIT(REPORT_WATER_READY) | BIT(REPORT_HEATING_STATE))
+
+static void report_flush_cb(zb_uint8_t param);
+
+/* ZBOSS callback: start the coalescing window for report_changed() */
+static void report_flush_arm_cb(zb_uint8_t param)
+{
+	ARG_UNUSED(param);
+
+	ZB_SCHEDULE_APP_ALARM(report_flush_cb, 0,
+		ZB_MILLISECONDS_TO_BEACON_INTERVAL(REPORT_COALESCE_MS));
+}
 
 /**
- * Mark an attribute as changed to trigger the stack's automatic reporting.
- * Used for temperature attributes where timing isn't critical.
+ * Queue attributes of a kettle for the next coalesced report.
+ *
+ * Safe to call from application threads; the frames are built and sent
+ * from ZBOSS context.
+ *
+ * @param kettle Kettle whose attributes changed
+ * @param mask BIT() of each changed enum report_attr
+ */
+static void report_changed(struct kettle_ctx *kettle, uint32_t mask)
+{
+	atomic_or(&kettle->report_dirty, mask);
+
+	if (!ZB_JOINED()) {
+		return;
+	}
+
+	/* Armed on the ZBOSS thread; its scheduler is not thread-safe */
+	if (!atomic_test_and_set_bit(&report_flags, REPORT_FLUSH_SCHEDULED)) {
+		if (zigbee_schedule_callback(report_flush_arm_cb, 0) != RET_OK) {
+			/* Callback queue full: armed by the next change */
+			atomic_clear_bit(&report_flags, REPORT_FLUSH_SCHEDULED);
+		}
+	}
+}
+
+/* Re-arm the flush alarm for attributes that are dirty but not yet due
+ * (ZBOSS context only)
  */
-static void mark_attribute_changed(zb_uint8_t endpoint, zb_uint16_t cluster_id,
-				   zb_uint16_t attr_id)
+static void report_flush_later(uint32_t delay_ms)
 {
-	zb_zcl_mark_attr_for_reporting(endpoint, cluster_id, ZB_ZCL_CLUSTER_SERVER_ROLE, attr_id);
+	if (!atomic_test_and_set_bit(&report_flags, REPORT_FLUSH_SCHEDULED)) {
+		ZB_SCHEDULE_APP_ALARM(report_flush_cb, 0,
+			ZB_MILLISECONDS_TO_BEACON_INTERVAL(delay_ms));
+	}
+}
+
+/* Let buffer pressure decay by one level per quiet REPORT_PRESSURE_DECAY_MS */
+static void report_pressure_decay(int64_t now)
+{
+	while (report_stats.pressure > 0 &&
+	       now - report_pressure_ms >= REPORT_PRESSURE_DECAY_MS) {
+		report_stats.pressure--;
+		report_pressure_ms += REPORT_PRESSURE_DECAY_MS;
+	}
 }
 
 /**
- * Callback invoked when on_off report packet is sent (APS ACK received or expired).
- * Per Nordic docs: callback is called on APS ACK or command expiry.
- * Buffer is automatically freed by the stack after this callback returns.
+ * Lowest priority that may allocate a buffer at the current pressure.
+ *
+ * Temperatures are the first to yield to mesh forwarding, then the
+ * setpoint; state frames are always attempted.
  */
-static void report_sent_cb(zb_uint8_t param)
+static enum report_prio report_prio_allowed(void)
 {
-	/* Buffer is freed by stack after callback - just log success */
-	if (param) {
-		LOG_DBG("On/off report sent callback, buf=%d", param);
+	if (report_stats.pressure >= REPORT_PRESSURE_MAX - 1) {
+		return REPORT_PRIO_STATE;
 	}
-	/* Reset retry count on delivery confirmation */
-	state_report_retry_count = 0;
+	if (report_stats.pressure > 0) {
+		return REPORT_PRIO_SETPOINT;
+	}
+	return REPORT_PRIO_TEMP;
 }
 
 /**
- * Callback invoked when system_mode report packet is sent.
- * Separate from report_sent_cb to correctly track system_mode retries.
+ * Note a frame handed to the stack with report_sent_cb() as its callback.
+ *
+ * @param bufid Frame buffer
+ * @param kettle Kettle the frame reports (unused when bound_mask is 0)
+ * @param c Index into report_clusters[] (unused when bound_mask is 0)
+ * @param bound_mask Attributes carried by a frame sent via bindings, 0 for
+ *                   frames addressed directly
  */
-static void system_mode_sent_cb(zb_uint8_t param)
+static void report_track(zb_bufid_t bufid, const struct kettle_ctx *kettle, size_t c,
+			 uint32_t bound_mask)
 {
-	if (param) {
-		LOG_DBG("System_mode report sent callback, buf=%d", param);
+	size_t slot = 0;
+
+	for (size_t i = 0; i < ARRAY_SIZE(report_in_flight); i++) {
+		if (report_in_flight[i].bufid == 0) {
+			slot = i;
+			break;
+		}
+		if ((int32_t)(report_in_flight[i].sent_cyc - report_in_flight[slot].sent_cyc) < 0) {
+			slot = i;
+		}
+	}
+
+	if (report_in_flight[slot].bufid == 0) {
+		report_stats.in_flight++;
+		report_stats.in_flight_max = MAX(report_stats.in_flight_max, report_stats.in_flight);
 	}
-	/* Reset retry count on delivery confirmation */
-	system_mode_retry_count = 0;
+	report_in_flight[slot].bufid = bufid;
+	report_in_flight[slot].sent_cyc = k_cycle_get_32();
+	report_in_flight[slot].bound_mask = bound_mask;
+	report_in_flight[slot].kettle = kettle ? kettle->index : 0;
+	report_in_flight[slot].cluster = c;
+}
+
+/* Send status of a bound frame the APS layer found no binding for */
+static bool report_no_binding(zb_ret_t status)
+{
+	return status == ZB_APS_STATUS_NO_BOUND_DEVICE ||
+	       status == ERROR_CODE(ERROR_CATEGORY_APS, ZB_APS_STATUS_NO_BOUND_DEVICE);
 }
 
 /**
- * Callback invoked when target_temp report packet is sent.
+ * Callback invoked when a report frame is sent (APS ACK received or expired).
+ * Per Nordic docs: callback is called on APS ACK or command expiry.
+ * Buffer is automatically freed by the stack after this callback returns.
  */
-static void target_temp_sent_cb(zb_uint8_t param)
+static void report_sent_cb(zb_uint8_t param)
 {
-	if (param) {
-		LOG_DBG("Target temp report sent callback, buf=%d", param);
+	/* Buffer is freed by stack after callback - just record the outcome */
+	if (!param) {
+		return;
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(report_in_flight); i++) {
+		if (report_in_flight[i].bufid != param) {
+			continue;
+		}
+
+		report_in_flight[i].bufid = 0;
+		report_stats.in_flight--;
+		if (zb_buf_get_status(param) == RET_OK) {
+			diag_record(DIAG_APS_RTT, diag_since_us(report_in_flight[i].sent_cyc));
+		} else if (report_in_flight[i].bound_mask &&
+			   report_no_binding(zb_buf_get_status(param))) {
+			struct kettle_ctx *kettle = &kettles[report_in_flight[i].kettle];
+
+			/* Nothing left the radio; the coordinator gets the current values */
+			kettle->report_queue[report_in_flight[i].cluster].direct = true;
+			atomic_or(&kettle->report_dirty, report_in_flight[i].bound_mask);
+			report_flush_later(REPORT_COALESCE_MS);
+			LOG_DBG("No binding for kettle %u cluster 0x%04x, report direct to coordinator",
+				kettle->index,
+				report_clusters[report_in_flight[i].cluster].cluster_id);
+		} else {
+			/* Left to the stack's backup reporting, see Addressing */
+			report_stats.aps_failures++;
+		}
+		break;
 	}
-	target_temp_report_pending = false;
+
+	LOG_DBG("Report sent callback, buf=%d, status=%d", param, zb_buf_get_status(param));
 }
 
 /**
@@ -1389,276 +3802,569 @@ static void get_buffer_for_report_cb(zb_uint8_t param)
 	buffer_request_pending = false;  /* Clear guard - we got our callback */
 
 	if (param) {
-		/* Got a buffer, send the report */
-		send_state_report_cb(param);
+		/* Got a buffer, send the highest priority report with it */
+		diag_record(DIAG_BUFFER_ACQUIRE, diag_since_us(diag_buf_request_cyc));
+		report_flush_cb(param);
 	} else {
 		/* Still no buffer - should not happen with delayed alloc */
 		LOG_ERR("Async buffer alloc returned NULL");
-		state_report_pending = false;
 	}
 }
 
-/**
- * ZBOSS callback to send combined on/off and system_mode report.
- * Combines both attributes in a single ZCL report frame to:
- * - Reduce buffer usage (one buffer instead of two)
- * - Ensure atomic state reporting
- * - Reduce network traffic
- */
-static void send_state_report_cb(zb_uint8_t param)
-{
-	zb_bufid_t bufid;
-	zb_uint8_t *cmd_ptr;
-	zb_uint16_t dst_addr = 0x0000;  /* Coordinator */
-	zb_ret_t ret;
+/**
+ * Back off a queue slot after a failed buffer allocation.
+ *
+ * Its dirty bits are kept, so the retry sends whatever is due by then.
+ * After REPORT_MAX_RETRIES the lower priority changes are dropped and left
+ * to the stack's backup reporting; state changes are retried until sent.
+ *
+ * @param kettle Kettle the slot belongs to
+ * @param c Index into report_clusters[]
+ * @param mask Attributes the slot failed to send
+ * @param now Current uptime
+ * @return Delay until the slot's next attempt, in ms
+ */
+static uint32_t report_backoff(struct kettle_ctx *kettle, size_t c, uint32_t mask, int64_t now)
+{
+	struct report_slot *slot = &kettle->report_queue[c];
+	uint32_t delay_ms = MIN(REPORT_INITIAL_DELAY_MS << MIN(slot->retries, 7),
+				REPORT_MAX_DELAY_MS);
+	zb_ret_t ret;
+
+	report_stats.alloc_failures++;
+	report_stats.pressure = MIN(report_stats.pressure + 1, REPORT_PRESSURE_MAX);
+	report_pressure_ms = now;
+
+	if (slot->retries < UINT8_MAX) {
+		slot->retries++;
+	}
+	slot->not_before_ms = now + delay_ms;
+
+	if (slot->retries > REPORT_MAX_RETRIES) {
+		uint32_t drop = 0;
+
+		for (int i = 0; i < REPORT_ATTR_COUNT; i++) {
+			if ((mask & BIT(i)) && report_attrs[i].prio != REPORT_PRIO_STATE) {
+				drop |= BIT(i);
+			}
+		}
+		if (drop) {
+			LOG_ERR("Report on kettle %u cluster 0x%04x dropped after %d retries - "
+				"buffer exhaustion",
+				kettle->index, report_clusters[c].cluster_id, REPORT_MAX_RETRIES);
+			atomic_and(&kettle->report_dirty, ~drop);
+			report_stats.dropped++;
+		}
+		if (!(mask & ~drop)) {
+			slot->retries = 0;
+			slot->not_before_ms = 0;
+			return REPORT_MAX_DELAY_MS;
+		}
+	}
+
+	LOG_WRN("No buffer for kettle %u cluster 0x%04x report, retry %d in %dms (pressure %d)",
+		kettle->index, report_clusters[c].cluster_id, slot->retries, delay_ms,
+		report_stats.pressure);
+
+	/* Use delayed buffer allocation - guard against accumulation */
+	if (!buffer_request_pending) {
+		buffer_request_pending = true;
+		diag_buf_request_cyc = k_cycle_get_32();
+		ret = zb_buf_get_out_delayed(get_buffer_for_report_cb);
+		if (ret != RET_OK) {
+			/* Alarm-based retry only, re-armed by the caller */
+			buffer_request_pending = false;
+		}
+	}
+
+	return delay_ms;
+}
+
+/**
+ * Build and send one Report Attributes frame for a cluster of a kettle.
+ *
+ * @param kettle Kettle whose endpoint the frame is sent from
+ * @param bufid Buffer to build the frame in (consumed)
+ * @param c Index into report_clusters[] of the cluster the frame is sent on
+ * @param mask Attributes to include, all belonging to the cluster
+ */
+static void report_send_cluster(struct kettle_ctx *kettle, zb_bufid_t bufid, size_t c,
+				uint32_t mask)
+{
+	const struct report_cluster_desc *cluster = &report_clusters[c];
+	bool bound = !kettle->report_queue[c].direct;
+	zb_uint8_t *cmd_ptr;
+
+	/* One frame to the coordinator, then bindings again */
+	kettle->report_queue[c].direct = false;
+
+	cmd_ptr = ZB_ZCL_START_PACKET(bufid);
+	if (cluster->manuf_code != ZB_ZCL_MANUF_CODE_INVALID) {
+		/* Frame ctrl: manuf-specific | srv->cli | disable default resp */
+		ZB_ZCL_PACKET_PUT_DATA8(cmd_ptr, 0x1C);
+		ZB_ZCL_PACKET_PUT_DATA16_VAL(cmd_ptr, cluster->manuf_code);
+	} else {
+		ZB_ZCL_PACKET_PUT_DATA8(cmd_ptr, 0x18);  /* Frame ctrl: srv->cli | disable default resp */
+	}
+	ZB_ZCL_PACKET_PUT_DATA8(cmd_ptr, ZB_ZCL_GET_SEQ_NUM());
+	ZB_ZCL_PACKET_PUT_DATA8(cmd_ptr, ZB_ZCL_CMD_REPORT_ATTRIB);
+
+	for (int i = 0; i < REPORT_ATTR_COUNT; i++) {
+		const struct report_attr_desc *desc = &report_attrs[i];
+
+		if (!(mask & BIT(i))) {
+			continue;
+		}
+
+		ZB_ZCL_PACKET_PUT_DATA16_VAL(cmd_ptr, desc->attr_id);
+		ZB_ZCL_PACKET_PUT_DATA8(cmd_ptr, desc->type);
+		if (desc->size == 2) {
+			ZB_ZCL_PACKET_PUT_DATA16_VAL(cmd_ptr,
+				*(const zb_uint16_t *)report_value(kettle, desc));
+		} else {
+			ZB_ZCL_PACKET_PUT_DATA8(cmd_ptr, *(const zb_uint8_t *)report_value(kettle, desc));
+		}
+	}
+
+	ZB_ZCL_FINISH_PACKET(bufid, cmd_ptr)
+
+	if ((mask & BIT(REPORT_ON_OFF)) &&
+	    atomic_test_and_clear_bit(&kettle->diag_flags, DIAG_EDGE_PENDING)) {
+		diag_record(DIAG_EDGE_TO_REPORT, diag_since_us(kettle->diag_edge_cyc));
+	}
+
+	/* Send with callback to track completion and ensure buffer is freed */
+	report_track(bufid, kettle, c, bound ? mask : 0);
+	if (bound) {
+		/* Every bound device and group for the cluster */
+		ZB_ZCL_SEND_COMMAND_SHORT(bufid, 0, ZB_APS_ADDR_MODE_DST_ADDR_ENDP_NOT_PRESENT,
+					  0, kettle->hw->endpoint, ZB_AF_HA_PROFILE_ID,
+					  cluster->cluster_id, report_sent_cb);
+	} else {
+		ZB_ZCL_SEND_COMMAND_SHORT(bufid, 0x0000, ZB_APS_ADDR_MODE_16_ENDP_PRESENT,
+					  1, kettle->hw->endpoint, ZB_AF_HA_PROFILE_ID,
+					  cluster->cluster_id, report_sent_cb);
+	}
+
+	LOG_DBG("Sent report: kettle=%u, cluster=0x%04x, attrs=0x%02x, %s", kettle->index,
+		cluster->cluster_id, mask, bound ? "bound" : "direct");
+}
+
+/**
+ * ZBOSS callback that flushes the report queues of all kettles.
+ *
+ * Sends one frame per kettle and cluster with its due dirty attributes,
+ * highest priority first across all kettles. A frame takes the priority
+ * of its most important attribute; lower priority attributes of the same
+ * cluster ride along for free. Under buffer pressure low priority frames
+ * are deferred, and the first failed allocation ends the pass so
+ * temperatures never burn buffers ahead of a pending state change.
+ * Re-arms itself for whatever is still queued.
+ *
+ * @param param Buffer from delayed allocation, or 0
+ */
+static void report_flush_cb(zb_uint8_t param)
+{
+	zb_bufid_t bufid = param;
+	int64_t now = k_uptime_get();
+	uint32_t next_ms = UINT32_MAX;
+	uint32_t masks[KETTLE_INSTANCE_COUNT][REPORT_CLUSTER_COUNT] = {0};
+	uint8_t prios[KETTLE_INSTANCE_COUNT][REPORT_CLUSTER_COUNT];
+	bool starved = false;
+	bool pending = false;
+
+	atomic_clear_bit(&report_flags, REPORT_FLUSH_SCHEDULED);
+
+	if (!ZB_JOINED()) {
+		if (bufid) {
+			zb_buf_free(bufid);
+		}
+		LOG_DBG("Not joined, skipping reports");
+		return;
+	}
+
+	report_pressure_decay(now);
+
+	/* Sample the stack's pool; flush passes follow traffic, so this tracks load */
+	if (zb_buf_is_oom_state()) {
+		report_stats.pool_oom++;
+	} else if (zb_buf_memory_low()) {
+		report_stats.pool_low++;
+	}
+
+	ARRAY_FOR_EACH_PTR(kettles, kettle) {
+		/* Split dirty attributes into due now and due later */
+		uint32_t dirty = atomic_get(&kettle->report_dirty);
+		uint32_t due = 0;
+
+		for (int i = 0; i < REPORT_ATTR_COUNT; i++) {
+			if (!(dirty & BIT(i))) {
+				continue;
+			}
+
+			int64_t wait_ms = kettle->report_last_ms[i] + report_attrs[i].min_interval_ms -
+					  now;
 
-	/* Note: Don't clear state_report_pending here - only after buffer acquired */
+			if (kettle->report_last_ms[i] == 0 || wait_ms <= 0) {
+				due |= BIT(i);
+			} else {
+				next_ms = MIN(next_ms, (uint32_t)wait_ms);
+			}
+		}
 
-	if (!ZB_JOINED()) {
-		if (param) {
-			zb_buf_free(param);
+		/* Group due attributes into queue slots */
+		for (size_t c = 0; c < REPORT_CLUSTER_COUNT; c++) {
+			prios[kettle->index][c] = REPORT_PRIO_COUNT;
+			for (int i = 0; i < REPORT_ATTR_COUNT; i++) {
+				if ((due & BIT(i)) &&
+				    report_attrs[i].cluster_id == report_clusters[c].cluster_id) {
+					masks[kettle->index][c] |= BIT(i);
+					prios[kettle->index][c] = MIN(prios[kettle->index][c],
+								      report_attrs[i].prio);
+				}
+			}
 		}
-		state_report_pending = false;
-		buffer_request_pending = false;
-		LOG_DBG("Not joined, skipping state report");
-		return;
 	}
 
-	/* Get a buffer for the report */
-	if (param) {
-		bufid = param;
-	} else {
-		bufid = zb_buf_get_out();
-		if (!bufid) {
-			/* No buffer available - use async allocation with backoff */
-			if (state_report_retry_count < REPORT_MAX_RETRIES) {
-				uint32_t delay_ms = REPORT_INITIAL_DELAY_MS *
-					(1 << state_report_retry_count);
-				if (delay_ms > REPORT_MAX_DELAY_MS) {
-					delay_ms = REPORT_MAX_DELAY_MS;
+	for (int prio = REPORT_PRIO_STATE; prio < REPORT_PRIO_COUNT; prio++) {
+		ARRAY_FOR_EACH_PTR(kettles, kettle) {
+			for (size_t c = 0; c < REPORT_CLUSTER_COUNT; c++) {
+				struct report_slot *slot = &kettle->report_queue[c];
+				uint32_t mask = masks[kettle->index][c];
+
+				if (prios[kettle->index][c] != prio) {
+					continue;
+				}
+
+				if (starved) {
+					continue;  /* retried with the slot that failed */
+				}
+
+				/* Held back by its own backoff, unless a buffer is in hand */
+				if (!bufid && slot->not_before_ms > now) {
+					next_ms = MIN(next_ms, (uint32_t)(slot->not_before_ms - now));
+					continue;
+				}
+
+				if (prio > report_prio_allowed()) {
+					report_stats.deferred++;
+					next_ms = MIN(next_ms, REPORT_PRESSURE_DECAY_MS);
+					continue;
 				}
 
-				state_report_retry_count++;
-				/* state_report_pending stays true during retry */
-				LOG_WRN("No buffer for state report, retry %d/%d in %dms",
-					state_report_retry_count, REPORT_MAX_RETRIES, delay_ms);
-
-				/* Use delayed buffer allocation - guard against accumulation */
-				if (!buffer_request_pending) {
-					buffer_request_pending = true;
-					ret = zb_buf_get_out_delayed(get_buffer_for_report_cb);
-					if (ret != RET_OK) {
-						buffer_request_pending = false;
-						/* Fallback to alarm-based retry */
-						ZB_SCHEDULE_APP_ALARM(send_state_report_cb, 0,
-							ZB_MILLISECONDS_TO_BEACON_INTERVAL(delay_ms));
+				if (!bufid) {
+					uint32_t buf_cyc = k_cycle_get_32();
+
+					bufid = zb_buf_get_out();
+					if (bufid) {
+						diag_record(DIAG_BUFFER_ACQUIRE, diag_since_us(buf_cyc));
+					} else {
+						next_ms = MIN(next_ms,
+							      report_backoff(kettle, c, mask, now));
+						starved = true;
+						continue;
 					}
 				}
-				/* else: delayed request already pending, it will call us back */
-			} else {
-				LOG_ERR("State report failed after %d retries - buffer exhaustion",
-					REPORT_MAX_RETRIES);
-				state_report_retry_count = 0;
-				state_report_pending = false;
-				buffer_request_pending = false;
+
+				/* Clear before reading the values: a change racing with the
+				 * send sets the bit again and is reported next time.
+				 */
+				atomic_and(&kettle->report_dirty, ~mask);
+				for (int i = 0; i < REPORT_ATTR_COUNT; i++) {
+					if (mask & BIT(i)) {
+						kettle->report_last_ms[i] = now;
+					}
+				}
+				if (slot->retries) {
+					report_stats.retried++;
+				}
+				slot->retries = 0;
+				slot->not_before_ms = 0;
+
+				report_send_cluster(kettle, bufid, c, mask);
+				bufid = 0;
 			}
-			return;
 		}
 	}
 
-	/* Successfully acquired buffer - now safe to clear pending flag */
-	state_report_pending = false;
-	buffer_request_pending = false;
+	if (bufid) {
+		zb_buf_free(bufid);
+	}
+
+	/* Changes that arrived meanwhile, are rate limited, backed off or deferred */
+	ARRAY_FOR_EACH_PTR(kettles, kettle) {
+		pending |= atomic_get(&kettle->report_dirty) != 0;
+	}
+	if (pending) {
+		report_flush_later(CLAMP(next_ms, REPORT_COALESCE_MS, REPORT_MAX_DELAY_MS));
+	}
+}
 
-	/* Build combined report with BOTH on_off and system_mode attributes
-	 * This is more efficient than two separate reports:
-	 * - Single buffer allocation
-	 * - Single network transaction
-	 * - Atomic state update on receiver
-	 *
-	 * Note: We send to On/Off cluster but include cross-cluster data.
-	 * For strict ZCL compliance, we send on_off first, then system_mode
-	 * in a second packet. But combined is more reliable.
-	 */
+/* ==========================================================================
+ * Telemetry Stream
+ *
+ * Opt-in high rate water temperature for heating curve analysis. While the
+ * kettle heats and StreamInterval is non-zero, every filtered sample is
+ * buffered and a Stream Data command carries the batch to the coordinator
+ * every StreamInterval seconds, or as soon as a frame's worth is waiting.
+ * The batch is flushed when heating stops.
+ *
+ * Stream Data payload: sample count (U8), age of the newest sample in ms
+ * (U16), data (octet string). Per sample, oldest first:
+ *   zigzag varint temperature delta (0.01°C; the first is against 0)
+ *   varint time since the previous sample (STREAM_TICK_MS; 0 for the first)
+ * At 500ms heating samples this is ~2 bytes per sample against a 9 byte
+ * attribute report. Stream frames yield to reports under buffer pressure;
+ * the oldest samples are dropped if they back up. Each kettle streams from
+ * its own endpoint and buffer (kettle_ctx.stream).
+ * ========================================================================== */
 
-	/* === First Report: On/Off cluster === */
-	cmd_ptr = ZB_ZCL_START_PACKET(bufid);
-	ZB_ZCL_PACKET_PUT_DATA8(cmd_ptr, 0x18);  /* Frame ctrl: srv->cli | disable default resp */
-	ZB_ZCL_PACKET_PUT_DATA8(cmd_ptr, ZB_ZCL_GET_SEQ_NUM());
-	ZB_ZCL_PACKET_PUT_DATA8(cmd_ptr, ZB_ZCL_CMD_REPORT_ATTRIB);
+#define STREAM_MAX_DATA         64      /* Encoded bytes per frame, fits one APS frame */
+#define STREAM_VARINT_MAX       5       /* Bytes in a 32-bit varint */
+#define STREAM_TICK_MS          10
+#define STREAM_RETRY_MS         REPORT_PRESSURE_DECAY_MS
 
-	/* On/Off attribute */
-	ZB_ZCL_PACKET_PUT_DATA16_VAL(cmd_ptr, ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID);
-	ZB_ZCL_PACKET_PUT_DATA8(cmd_ptr, ZB_ZCL_ATTR_TYPE_BOOL);
-	ZB_ZCL_PACKET_PUT_DATA8(cmd_ptr, dev_ctx.on_off_attr.on_off);
+static K_MUTEX_DEFINE(stream_lock);
 
-	ZB_ZCL_FINISH_PACKET(bufid, cmd_ptr)
+static void stream_send_cb(zb_uint8_t param);
 
-	/* Send with callback to track completion and ensure buffer is freed */
-	ZB_ZCL_SEND_COMMAND_SHORT(bufid, dst_addr, ZB_APS_ADDR_MODE_16_ENDP_PRESENT,
-				  1, KETTLE_ENDPOINT, ZB_AF_HA_PROFILE_ID,
-				  ZB_ZCL_CLUSTER_ID_ON_OFF, report_sent_cb);
+static void stream_work_handler(struct k_work *work)
+{
+	struct kettle_ctx *kettle = CONTAINER_OF(k_work_delayable_from_work(work),
+						 struct kettle_ctx, stream_work);
 
-	LOG_INF("Sent on_off report: %s", dev_ctx.on_off_attr.on_off ? "ON" : "OFF");
+	if (!ZB_JOINED()) {
+		k_mutex_lock(&stream_lock, K_FOREVER);
+		kettle->stream.count = 0;
+		k_mutex_unlock(&stream_lock);
+		return;
+	}
 
-	/* === Second Report: Thermostat system_mode (separate packet for ZCL compliance) === */
-	/* Schedule with small delay to avoid buffer contention */
-	ZB_SCHEDULE_APP_ALARM(send_system_mode_report_cb, 0,
-		ZB_MILLISECONDS_TO_BEACON_INTERVAL(50));
+	/* Handed to the ZBOSS thread; its scheduler is not thread-safe */
+	if (zigbee_schedule_callback(stream_send_cb, kettle->index) != RET_OK) {
+		k_work_reschedule(&kettle->stream_work, K_MSEC(STREAM_RETRY_MS));
+	}
 }
 
 /**
- * ZBOSS callback to send system_mode report.
- * Separate from on_off because they're different clusters.
+ * Queue a filtered water sample of a kettle for streaming.
+ *
+ * Does nothing unless streaming is enabled and the kettle is heating.
  */
-static void send_system_mode_report_cb(zb_uint8_t param)
+static void stream_sample(struct kettle_ctx *kettle, int16_t temp)
 {
-	zb_bufid_t bufid;
-	zb_uint8_t *cmd_ptr;
-	zb_uint16_t dst_addr = 0x0000;  /* Coordinator */
+	struct stream_buf *stream = &kettle->stream;
+	uint16_t interval_s = kettle->dev_ctx.kettle_attr.stream_interval;
 
-	if (!ZB_JOINED()) {
-		if (param) {
-			zb_buf_free(param);
-		}
+	if (interval_s == 0 || kettle->heating_state != KETTLE_STATE_ON) {
 		return;
 	}
 
-	bufid = param ? param : zb_buf_get_out();
-	if (!bufid) {
-		if (system_mode_retry_count < REPORT_MAX_RETRIES) {
-			uint32_t delay_ms = REPORT_INITIAL_DELAY_MS *
-				(1 << system_mode_retry_count);
-			if (delay_ms > REPORT_MAX_DELAY_MS) {
-				delay_ms = REPORT_MAX_DELAY_MS;
-			}
+	k_mutex_lock(&stream_lock, K_FOREVER);
 
-			system_mode_retry_count++;
-			LOG_WRN("No buffer for system_mode report, retry %d/%d",
-				system_mode_retry_count, REPORT_MAX_RETRIES);
-			ZB_SCHEDULE_APP_ALARM(send_system_mode_report_cb, 0,
-				ZB_MILLISECONDS_TO_BEACON_INTERVAL(delay_ms));
-		} else {
-			LOG_ERR("System_mode report failed after %d retries", REPORT_MAX_RETRIES);
-			system_mode_retry_count = 0;
-		}
-		return;
+	if (stream->count == STREAM_MAX_SAMPLES) {
+		memmove(&stream->temp[0], &stream->temp[1],
+			sizeof(stream->temp[0]) * (stream->count - 1));
+		memmove(&stream->ms[0], &stream->ms[1], sizeof(stream->ms[0]) * (stream->count - 1));
+		stream->count--;
+		stream_stats.dropped++;
 	}
 
-	/* Build system_mode report */
-	cmd_ptr = ZB_ZCL_START_PACKET(bufid);
-	ZB_ZCL_PACKET_PUT_DATA8(cmd_ptr, 0x18);  /* Frame ctrl: srv->cli | disable default resp */
-	ZB_ZCL_PACKET_PUT_DATA8(cmd_ptr, ZB_ZCL_GET_SEQ_NUM());
-	ZB_ZCL_PACKET_PUT_DATA8(cmd_ptr, ZB_ZCL_CMD_REPORT_ATTRIB);
+	stream->temp[stream->count] = temp;
+	stream->ms[stream->count] = k_uptime_get();
+	stream->count++;
 
-	/* System mode attribute */
-	ZB_ZCL_PACKET_PUT_DATA16_VAL(cmd_ptr, ZB_ZCL_ATTR_THERMOSTAT_SYSTEM_MODE_ID);
-	ZB_ZCL_PACKET_PUT_DATA8(cmd_ptr, ZB_ZCL_ATTR_TYPE_8BIT_ENUM);
-	ZB_ZCL_PACKET_PUT_DATA8(cmd_ptr, dev_ctx.thermostat_attr.system_mode);
+	if (stream->count == 1) {
+		k_work_schedule(&kettle->stream_work, K_SECONDS(interval_s));
+	} else if (stream->count == STREAM_MAX_SAMPLES) {
+		k_work_reschedule(&kettle->stream_work, K_NO_WAIT);
+	}
 
-	ZB_ZCL_FINISH_PACKET(bufid, cmd_ptr)
+	k_mutex_unlock(&stream_lock);
+}
+
+/* Send whatever is buffered now (heating stopped or streaming turned off) */
+static void stream_flush_now(struct kettle_ctx *kettle)
+{
+	if (kettle->stream.count > 0) {
+		k_work_reschedule(&kettle->stream_work, K_NO_WAIT);
+	}
+}
 
-	/* Send with callback for proper buffer management and retry tracking */
-	ZB_ZCL_SEND_COMMAND_SHORT(bufid, dst_addr, ZB_APS_ADDR_MODE_16_ENDP_PRESENT,
-				  1, KETTLE_ENDPOINT, ZB_AF_HA_PROFILE_ID,
-				  ZB_ZCL_CLUSTER_ID_THERMOSTAT, system_mode_sent_cb);
+static size_t stream_put_varint(uint8_t *out, uint32_t v)
+{
+	size_t n = 0;
+
+	do {
+		out[n] = v & 0x7F;
+		v >>= 7;
+		out[n++] |= v ? 0x80 : 0;
+	} while (v);
 
-	LOG_INF("Sent system_mode report: %d", dev_ctx.thermostat_attr.system_mode);
-	/* Note: retry count reset moved to system_mode_sent_cb callback */
+	return n;
 }
 
 /**
- * Schedule state reports via ZBOSS callback (proper context for buffer ops).
- * Includes debouncing to prevent report flooding on rapid state changes.
+ * Encode buffered samples, oldest first, and remove them from the buffer.
+ *
+ * @param stream Buffer of the kettle being streamed
+ * @param out Buffer of STREAM_MAX_DATA bytes
+ * @param count Number of samples encoded
+ * @param newest_age_ms Age of the newest encoded sample
+ * @return Encoded length
  */
-static void schedule_state_report(void)
+static size_t stream_encode(struct stream_buf *stream, uint8_t *out, uint8_t *count, uint16_t *newest_age_ms)
 {
-	if (!ZB_JOINED()) {
-		return;
-	}
+	int64_t now = k_uptime_get();
+	int16_t prev_temp = 0;
+	int64_t prev_ms = 0;
+	size_t len = 0;
+	uint8_t n;
+
+	for (n = 0; n < stream->count; n++) {
+		uint8_t tmp[2 * STREAM_VARINT_MAX];
+		int32_t delta = stream->temp[n] - prev_temp;
+		uint32_t ticks = (n == 0) ? 0 : (stream->ms[n] - prev_ms) / STREAM_TICK_MS;
+		size_t tlen;
+
+		tlen = stream_put_varint(tmp, ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31));
+		tlen += stream_put_varint(&tmp[tlen], ticks);
+		if (len + tlen > STREAM_MAX_DATA) {
+			break;
+		}
 
-	/* Debounce: don't queue another report if one is already pending */
-	if (state_report_pending) {
-		LOG_DBG("State report already pending, skipping duplicate");
-		return;
+		memcpy(&out[len], tmp, tlen);
+		len += tlen;
+		prev_temp = stream->temp[n];
+		prev_ms = stream->ms[n];
 	}
 
-	state_report_pending = true;
-	state_report_retry_count = 0;
-	ZB_SCHEDULE_APP_CALLBACK(send_state_report_cb, 0);
+	*count = n;
+	*newest_age_ms = (n == 0) ? 0 : MIN(now - prev_ms, UINT16_MAX);
+
+	stream->count -= n;
+	memmove(&stream->temp[0], &stream->temp[n], sizeof(stream->temp[0]) * stream->count);
+	memmove(&stream->ms[0], &stream->ms[n], sizeof(stream->ms[0]) * stream->count);
+
+	return len;
 }
 
 /**
- * ZBOSS callback to send target temperature (setpoint) report.
- * Provides immediate feedback when user adjusts the dial.
+ * ZBOSS callback that sends one Stream Data frame.
+ *
+ * Waits out buffer pressure instead of competing with reports, and comes
+ * back for any samples that did not fit the frame.
+ *
+ * @param param Index of the kettle into kettles[]
  */
-static void send_target_temp_report_cb(zb_uint8_t param)
+static void stream_send_cb(zb_uint8_t param)
 {
+	struct kettle_ctx *kettle = &kettles[param];
+	uint8_t data[STREAM_MAX_DATA];
+	uint16_t newest_age_ms;
+	uint8_t count;
+	size_t len;
+	uint32_t buf_cyc;
 	zb_bufid_t bufid;
 	zb_uint8_t *cmd_ptr;
-	zb_uint16_t dst_addr = 0x0000;  /* Coordinator */
 
-	if (!ZB_JOINED()) {
-		if (param) {
-			zb_buf_free(param);
-		}
-		target_temp_report_pending = false;
+	report_pressure_decay(k_uptime_get());
+	if (report_prio_allowed() != REPORT_PRIO_TEMP) {
+		k_work_reschedule(&kettle->stream_work, K_MSEC(STREAM_RETRY_MS));
 		return;
 	}
 
-	bufid = param ? param : zb_buf_get_out();
+	buf_cyc = k_cycle_get_32();
+	bufid = zb_buf_get_out();
 	if (!bufid) {
-		/* No buffer - skip this report, automatic reporting will catch it later */
-		LOG_WRN("No buffer for target temp report, relying on auto-report");
-		target_temp_report_pending = false;
+		k_work_reschedule(&kettle->stream_work, K_MSEC(STREAM_RETRY_MS));
 		return;
 	}
+	diag_record(DIAG_BUFFER_ACQUIRE, diag_since_us(buf_cyc));
 
-	/* Build setpoint report */
-	cmd_ptr = ZB_ZCL_START_PACKET(bufid);
-	ZB_ZCL_PACKET_PUT_DATA8(cmd_ptr, 0x18);  /* Frame ctrl: srv->cli | disable default resp */
-	ZB_ZCL_PACKET_PUT_DATA8(cmd_ptr, ZB_ZCL_GET_SEQ_NUM());
-	ZB_ZCL_PACKET_PUT_DATA8(cmd_ptr, ZB_ZCL_CMD_REPORT_ATTRIB);
+	k_mutex_lock(&stream_lock, K_FOREVER);
+	len = stream_encode(&kettle->stream, data, &count, &newest_age_ms);
+	if (kettle->stream.count > 0) {
+		k_work_reschedule(&kettle->stream_work, K_NO_WAIT);
+	}
+	k_mutex_unlock(&stream_lock);
 
-	/* Occupied heating setpoint attribute */
-	ZB_ZCL_PACKET_PUT_DATA16_VAL(cmd_ptr, ZB_ZCL_ATTR_THERMOSTAT_OCCUPIED_HEATING_SETPOINT_ID);
-	ZB_ZCL_PACKET_PUT_DATA8(cmd_ptr, ZB_ZCL_ATTR_TYPE_S16);
-	ZB_ZCL_PACKET_PUT_DATA16_VAL(cmd_ptr, dev_ctx.thermostat_attr.occupied_heating_setpoint);
+	if (count == 0) {
+		zb_buf_free(bufid);
+		return;
+	}
 
+	cmd_ptr = ZB_ZCL_START_PACKET(bufid);
+	ZB_ZCL_PACKET_PUT_DATA8(cmd_ptr, 0x1D);  /* Frame ctrl: cluster cmd | manuf | srv->cli | no default resp */
+	ZB_ZCL_PACKET_PUT_DATA16_VAL(cmd_ptr, ZB_KETTLE_MANUF_CODE);
+	ZB_ZCL_PACKET_PUT_DATA8(cmd_ptr, ZB_ZCL_GET_SEQ_NUM());
+	ZB_ZCL_PACKET_PUT_DATA8(cmd_ptr, ZB_ZCL_CMD_KETTLE_STREAM_DATA);
+	ZB_ZCL_PACKET_PUT_DATA8(cmd_ptr, count);
+	ZB_ZCL_PACKET_PUT_DATA16_VAL(cmd_ptr, newest_age_ms);
+	ZB_ZCL_PACKET_PUT_DATA8(cmd_ptr, len);
+	ZB_ZCL_PACKET_PUT_DATA_N(cmd_ptr, data, len);
 	ZB_ZCL_FINISH_PACKET(bufid, cmd_ptr)
 
-	ZB_ZCL_SEND_COMMAND_SHORT(bufid, dst_addr, ZB_APS_ADDR_MODE_16_ENDP_PRESENT,
-				  1, KETTLE_ENDPOINT, ZB_AF_HA_PROFILE_ID,
-				  ZB_ZCL_CLUSTER_ID_THERMOSTAT, target_temp_sent_cb);
+	report_track(bufid, NULL, 0, 0);
+	ZB_ZCL_SEND_COMMAND_SHORT(bufid, 0x0000, ZB_APS_ADDR_MODE_16_ENDP_PRESENT,
+				  1, kettle->hw->endpoint, ZB_AF_HA_PROFILE_ID,
+				  ZB_ZCL_CLUSTER_ID_KETTLE, report_sent_cb);
 
-	LOG_INF("Sent target temp report: %d.%02d C",
-		dev_ctx.thermostat_attr.occupied_heating_setpoint / 100,
-		dev_ctx.thermostat_attr.occupied_heating_setpoint % 100);
+	stream_stats.frames++;
+	LOG_DBG("Stream frame: kettle %u, %d samples, %zu bytes", kettle->index, count, len);
 }
 
-/**
- * Schedule immediate target temperature report.
- */
-static void schedule_target_temp_report(void)
-{
-	if (!ZB_JOINED()) {
-		return;
-	}
-
-	/* Debounce: don't queue another report if one is already pending */
-	if (target_temp_report_pending) {
-		LOG_DBG("Target temp report already pending, skipping duplicate");
-		return;
-	}
+/* ==========================================================================
+ * Reporting Configuration
+ * ========================================================================== */
 
-	target_temp_report_pending = true;
-	ZB_SCHEDULE_APP_CALLBACK(send_target_temp_report_cb, 0);
-}
+/*
+ * Stack (heartbeat/backup) reporting, see Zigbee Reporting. ZBOSS keeps
+ * reporting slots in NVRAM, so after a reboot on the same network they are
+ * already restored and only missing ones are written. Rejoins within one
+ * boot skip this entirely (slots are limited).
+ */
+static const struct reporting_default {
+	zb_uint16_t cluster_id;
+	zb_uint16_t attr_id;
+	zb_uint16_t manuf_code;     /* ZB_ZCL_MANUF_CODE_INVALID for standard attributes */
+	zb_uint8_t  type;           /* selects the delta union member */
+	zb_uint16_t min_interval;   /* s */
+	zb_uint16_t max_interval;   /* s */
+	zb_int16_t  delta;
+	const char *name;
+} reporting_defaults[] = {
+	/* On/Off: backup for the coalesced reports, 60s heartbeat to confirm state */
+	{ ZB_ZCL_CLUSTER_ID_ON_OFF, ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID, ZB_ZCL_MANUF_CODE_INVALID,
+	  ZB_ZCL_ATTR_TYPE_BOOL, 1, 60, 1, "On/Off" },
+	/* System mode: same rationale as On/Off */
+	{ ZB_ZCL_CLUSTER_ID_THERMOSTAT, ZB_ZCL_ATTR_THERMOSTAT_SYSTEM_MODE_ID, ZB_ZCL_MANUF_CODE_INVALID,
+	  ZB_ZCL_ATTR_TYPE_8BIT_ENUM, 1, 60, 1, "System mode" },
+	/* Water temperature: 0.5°C steps, reports every 5-10s while boiling
+	 * (~0.3°C/sec rise), heartbeat every 5 min when idle
+	 */
+	{ ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT, ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_ID, ZB_ZCL_MANUF_CODE_INVALID,
+	  ZB_ZCL_ATTR_TYPE_S16, 5, 300, 50, "Temp measurement" },
+#ifndef CONFIG_KETTLE_LOCAL_TEMP_ALIAS
+	/* Thermostat local temperature mirrors the temperature measurement */
+	{ ZB_ZCL_CLUSTER_ID_THERMOSTAT, ZB_ZCL_ATTR_THERMOSTAT_LOCAL_TEMPERATURE_ID, ZB_ZCL_MANUF_CODE_INVALID,
+	  ZB_ZCL_ATTR_TYPE_S16, 5, 300, 50, "Thermostat local temp" },
+#endif
+	/* Setpoint: 1.0°C steps, rarely changes */
+	{ ZB_ZCL_CLUSTER_ID_THERMOSTAT, ZB_ZCL_ATTR_THERMOSTAT_OCCUPIED_HEATING_SETPOINT_ID, ZB_ZCL_MANUF_CODE_INVALID,
+	  ZB_ZCL_ATTR_TYPE_S16, 10, 3600, 100, "Thermostat setpoint" },
+	/* Time to setpoint: 5s steps */
+	{ ZB_ZCL_CLUSTER_ID_THERMOSTAT, ZB_ZCL_ATTR_THERMOSTAT_KETTLE_TIME_TO_SETPOINT_ID, ZB_KETTLE_MANUF_CODE,
+	  ZB_ZCL_ATTR_TYPE_U16, 5, 300, 5, "Time-to-setpoint" },
+};
 
+/* Default reporting of every kettle endpoint */
 static void configure_reporting(void)
 {
 	zb_zcl_reporting_info_t rep_info;
 	zb_ret_t ret;
+	int slots = 0;
+	int restored = 0;
 
 	/* Guard against reconfiguration on network rejoin - slots are limited */
 	if (reporting_configured) {
@@ -1668,164 +4374,154 @@ static void configure_reporting(void)
 
 	LOG_INF("Configuring attribute reporting...");
 
-	/* Configure On/Off reporting (backup for manual reports)
-	 * Primary state changes trigger immediate manual reports via schedule_state_report().
-	 * This automatic reporting serves as backup to ensure state eventually syncs
-	 * even if manual reports fail due to buffer exhaustion.
-	 * min_interval: 1s (allow immediate manual reports)
-	 * max_interval: 60s (heartbeat to confirm state)
-	 */
-	memset(&rep_info, 0, sizeof(rep_info));
-	rep_info.direction = ZB_ZCL_CONFIGURE_REPORTING_SEND_REPORT;
-	rep_info.ep = KETTLE_ENDPOINT;
-	rep_info.cluster_id = ZB_ZCL_CLUSTER_ID_ON_OFF;
-	rep_info.cluster_role = ZB_ZCL_CLUSTER_SERVER_ROLE;
-	rep_info.attr_id = ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID;
-	rep_info.dst.profile_id = ZB_AF_HA_PROFILE_ID;
-	rep_info.dst.endpoint = 1;
-	rep_info.dst.short_addr = 0x0000;
-	rep_info.u.send_info.min_interval = 1;
-	rep_info.u.send_info.max_interval = 60;
-	rep_info.u.send_info.delta.u8 = 1;  /* Any change */
-	rep_info.flags = ZB_ZCL_REPORTING_SLOT_BUSY;
-
-	ret = zb_zcl_put_reporting_info(&rep_info, ZB_TRUE);
-	LOG_INF("On/Off reporting: %s", ret == RET_OK ? "OK" : "FAILED");
-
-	/* Configure System Mode reporting (backup for manual reports)
-	 * Same rationale as On/Off - manual reports are primary, this is backup.
-	 */
-	memset(&rep_info, 0, sizeof(rep_info));
-	rep_info.direction = ZB_ZCL_CONFIGURE_REPORTING_SEND_REPORT;
-	rep_info.ep = KETTLE_ENDPOINT;
-	rep_info.cluster_id = ZB_ZCL_CLUSTER_ID_THERMOSTAT;
-	rep_info.cluster_role = ZB_ZCL_CLUSTER_SERVER_ROLE;
-	rep_info.attr_id = ZB_ZCL_ATTR_THERMOSTAT_SYSTEM_MODE_ID;
-	rep_info.dst.profile_id = ZB_AF_HA_PROFILE_ID;
-	rep_info.dst.endpoint = 1;
-	rep_info.dst.short_addr = 0x0000;
-	rep_info.u.send_info.min_interval = 1;
-	rep_info.u.send_info.max_interval = 60;
-	rep_info.u.send_info.delta.u8 = 1;  /* Any change */
-	rep_info.flags = ZB_ZCL_REPORTING_SLOT_BUSY;
-
-	ret = zb_zcl_put_reporting_info(&rep_info, ZB_TRUE);
-	LOG_INF("System mode reporting: %s", ret == RET_OK ? "OK" : "FAILED");
-
-	/* Configure Temperature Measurement reporting
-	 * min_interval: 5s (responsive during active heating)
-	 * max_interval: 300s (heartbeat when idle)
-	 * delta: 50 = 0.5°C change threshold
-	 *
-	 * During boiling: ~0.3°C/sec rise, so reports every 5-10s
-	 * When idle: only heartbeat every 5 min
-	 */
-	memset(&rep_info, 0, sizeof(rep_info));
-	rep_info.direction = ZB_ZCL_CONFIGURE_REPORTING_SEND_REPORT;
-	rep_info.ep = KETTLE_ENDPOINT;
-	rep_info.cluster_id = ZB_ZCL_CLUSTER_ID_TEMP_MEASUREMENT;
-	rep_info.cluster_role = ZB_ZCL_CLUSTER_SERVER_ROLE;
-	rep_info.attr_id = ZB_ZCL_ATTR_TEMP_MEASUREMENT_VALUE_ID;
-	rep_info.dst.profile_id = ZB_AF_HA_PROFILE_ID;
-	rep_info.dst.endpoint = 1;
-	rep_info.dst.short_addr = 0x0000;
-	rep_info.u.send_info.min_interval = 5;
-	rep_info.u.send_info.max_interval = 300;
-	rep_info.u.send_info.delta.s16 = 50;  /* 0.5°C change */
-	rep_info.flags = ZB_ZCL_REPORTING_SLOT_BUSY;
-
-	ret = zb_zcl_put_reporting_info(&rep_info, ZB_TRUE);
-	LOG_INF("Temp measurement reporting: %s", ret == RET_OK ? "OK" : "FAILED");
-
-	/* Configure Thermostat local temperature reporting (mirrors temp measurement) */
-	memset(&rep_info, 0, sizeof(rep_info));
-	rep_info.direction = ZB_ZCL_CONFIGURE_REPORTING_SEND_REPORT;
-	rep_info.ep = KETTLE_ENDPOINT;
-	rep_info.cluster_id = ZB_ZCL_CLUSTER_ID_THERMOSTAT;
-	rep_info.cluster_role = ZB_ZCL_CLUSTER_SERVER_ROLE;
-	rep_info.attr_id = ZB_ZCL_ATTR_THERMOSTAT_LOCAL_TEMPERATURE_ID;
-	rep_info.dst.profile_id = ZB_AF_HA_PROFILE_ID;
-	rep_info.dst.endpoint = 1;
-	rep_info.dst.short_addr = 0x0000;
-	rep_info.u.send_info.min_interval = 5;
-	rep_info.u.send_info.max_interval = 300;
-	rep_info.u.send_info.delta.s16 = 50;  /* 0.5°C change */
-	rep_info.flags = ZB_ZCL_REPORTING_SLOT_BUSY;
-
-	ret = zb_zcl_put_reporting_info(&rep_info, ZB_TRUE);
-	LOG_INF("Thermostat local temp reporting: %s", ret == RET_OK ? "OK" : "FAILED");
-
-	/* Configure Thermostat setpoint reporting */
-	memset(&rep_info, 0, sizeof(rep_info));
-	rep_info.direction = ZB_ZCL_CONFIGURE_REPORTING_SEND_REPORT;
-	rep_info.ep = KETTLE_ENDPOINT;
-	rep_info.cluster_id = ZB_ZCL_CLUSTER_ID_THERMOSTAT;
-	rep_info.cluster_role = ZB_ZCL_CLUSTER_SERVER_ROLE;
-	rep_info.attr_id = ZB_ZCL_ATTR_THERMOSTAT_OCCUPIED_HEATING_SETPOINT_ID;
-	rep_info.dst.profile_id = ZB_AF_HA_PROFILE_ID;
-	rep_info.dst.endpoint = 1;
-	rep_info.dst.short_addr = 0x0000;
-	rep_info.u.send_info.min_interval = 10;
-	rep_info.u.send_info.max_interval = 3600;  /* Setpoint rarely changes */
-	rep_info.u.send_info.delta.s16 = 100;  /* 1.0°C change */
-	rep_info.flags = ZB_ZCL_REPORTING_SLOT_BUSY;
-
-	ret = zb_zcl_put_reporting_info(&rep_info, ZB_TRUE);
-	LOG_INF("Thermostat setpoint reporting: %s", ret == RET_OK ? "OK" : "FAILED");
+	ARRAY_FOR_EACH_PTR(kettles, kettle) {
+		for (size_t i = 0; i < ARRAY_SIZE(reporting_defaults); i++) {
+			const struct reporting_default *def = &reporting_defaults[i];
+
+			if (zb_zcl_find_reporting_info_manuf(kettle->hw->endpoint, def->cluster_id,
+							     ZB_ZCL_CLUSTER_SERVER_ROLE,
+							     def->attr_id, def->manuf_code)) {
+				/* Restored from NVRAM, possibly reconfigured by the coordinator */
+				restored++;
+				continue;
+			}
+
+			memset(&rep_info, 0, sizeof(rep_info));
+			rep_info.direction = ZB_ZCL_CONFIGURE_REPORTING_SEND_REPORT;
+			rep_info.ep = kettle->hw->endpoint;
+			rep_info.cluster_id = def->cluster_id;
+			rep_info.cluster_role = ZB_ZCL_CLUSTER_SERVER_ROLE;
+			rep_info.attr_id = def->attr_id;
+			rep_info.manuf_code = def->manuf_code;
+			rep_info.dst.profile_id = ZB_AF_HA_PROFILE_ID;
+			rep_info.dst.endpoint = 1;
+			rep_info.dst.short_addr = 0x0000;
+			rep_info.u.send_info.min_interval = def->min_interval;
+			rep_info.u.send_info.max_interval = def->max_interval;
+			switch (def->type) {
+			case ZB_ZCL_ATTR_TYPE_S16:
+				rep_info.u.send_info.delta.s16 = def->delta;
+				break;
+			case ZB_ZCL_ATTR_TYPE_U16:
+				rep_info.u.send_info.delta.u16 = def->delta;
+				break;
+			default:
+				rep_info.u.send_info.delta.u8 = def->delta;
+				break;
+			}
+			rep_info.flags = ZB_ZCL_REPORTING_SLOT_BUSY;
+
+			ret = zb_zcl_put_reporting_info(&rep_info, ZB_TRUE);
+			slots += (ret == RET_OK);
+			LOG_INF("Kettle %u %s reporting: %s", kettle->index, def->name,
+				ret == RET_OK ? "OK" : "FAILED");
+		}
+	}
 
 	reporting_configured = true;
-	LOG_INF("Attribute reporting configured (5 slots used)");
+	LOG_INF("Attribute reporting configured (%d slots written, %d restored)", slots, restored);
 }
 
-static void clusters_attr_init(void)
+/* Attribute defaults of one kettle endpoint */
+static void kettle_attr_init(struct kettle_ctx *kettle)
 {
 	/* Basic cluster */
-	dev_ctx.basic_attr.zcl_version = ZB_ZCL_VERSION;
-	dev_ctx.basic_attr.app_version = KETTLE_INIT_BASIC_APP_VERSION;
-	dev_ctx.basic_attr.stack_version = KETTLE_INIT_BASIC_STACK_VERSION;
-	dev_ctx.basic_attr.hw_version = KETTLE_INIT_BASIC_HW_VERSION;
-	dev_ctx.basic_attr.power_source = ZB_ZCL_BASIC_POWER_SOURCE_MAINS_SINGLE_PHASE;
-	dev_ctx.basic_attr.ph_env = KETTLE_INIT_BASIC_PH_ENV;
+	kettle->dev_ctx.basic_attr.zcl_version = ZB_ZCL_VERSION;
+	kettle->dev_ctx.basic_attr.app_version = KETTLE_INIT_BASIC_APP_VERSION;
+	kettle->dev_ctx.basic_attr.stack_version = KETTLE_INIT_BASIC_STACK_VERSION;
+	kettle->dev_ctx.basic_attr.hw_version = KETTLE_INIT_BASIC_HW_VERSION;
+	kettle->dev_ctx.basic_attr.power_source = ZB_ZCL_BASIC_POWER_SOURCE_MAINS_SINGLE_PHASE;
+	kettle->dev_ctx.basic_attr.ph_env = KETTLE_INIT_BASIC_PH_ENV;
 
 	ZB_ZCL_SET_STRING_VAL(
-		dev_ctx.basic_attr.mf_name,
+		kettle->dev_ctx.basic_attr.mf_name,
 		KETTLE_INIT_BASIC_MANUF_NAME,
 		ZB_ZCL_STRING_CONST_SIZE(KETTLE_INIT_BASIC_MANUF_NAME));
 
 	ZB_ZCL_SET_STRING_VAL(
-		dev_ctx.basic_attr.model_id,
+		kettle->dev_ctx.basic_attr.model_id,
 		KETTLE_INIT_BASIC_MODEL_ID,
 		ZB_ZCL_STRING_CONST_SIZE(KETTLE_INIT_BASIC_MODEL_ID));
 
 	ZB_ZCL_SET_STRING_VAL(
-		dev_ctx.basic_attr.date_code,
+		kettle->dev_ctx.basic_attr.date_code,
 		KETTLE_INIT_BASIC_DATE_CODE,
 		ZB_ZCL_STRING_CONST_SIZE(KETTLE_INIT_BASIC_DATE_CODE));
 
 	ZB_ZCL_SET_STRING_VAL(
-		dev_ctx.basic_attr.location_id,
+		kettle->dev_ctx.basic_attr.location_id,
 		KETTLE_INIT_BASIC_LOCATION_DESC,
 		ZB_ZCL_STRING_CONST_SIZE(KETTLE_INIT_BASIC_LOCATION_DESC));
 
 	/* Identify cluster */
-	dev_ctx.identify_attr.identify_time = ZB_ZCL_IDENTIFY_IDENTIFY_TIME_DEFAULT_VALUE;
+	kettle->dev_ctx.identify_attr.identify_time = ZB_ZCL_IDENTIFY_IDENTIFY_TIME_DEFAULT_VALUE;
 
 	/* On/Off cluster (read-only, reports kettle state) */
-	dev_ctx.on_off_attr.on_off = ZB_ZCL_ON_OFF_IS_OFF;
+	kettle->dev_ctx.on_off_attr.on_off = ZB_ZCL_ON_OFF_IS_OFF;
 
 	/* Thermostat cluster */
-	dev_ctx.thermostat_attr.local_temperature = TEMP_INVALID_ZB;
-	dev_ctx.thermostat_attr.occupied_cooling_setpoint = TEMP_MAX_ZB;  /* Not used */
-	dev_ctx.thermostat_attr.occupied_heating_setpoint = 8000;  /* Default 80°C */
-	dev_ctx.thermostat_attr.min_heat_setpoint_limit = TEMP_MIN_ZB;
-	dev_ctx.thermostat_attr.max_heat_setpoint_limit = TEMP_MAX_ZB;
-	dev_ctx.thermostat_attr.control_sequence = ZB_ZCL_THERMOSTAT_CONTROL_SEQ_OF_OPERATION_HEATING_ONLY;
-	dev_ctx.thermostat_attr.system_mode = ZB_ZCL_THERMOSTAT_SYSTEM_MODE_OFF;
+	kettle->dev_ctx.thermostat_attr.local_temperature = TEMP_INVALID_ZB;
+	kettle->dev_ctx.thermostat_attr.occupied_cooling_setpoint = TEMP_MAX_ZB;  /* Not used */
+	kettle->dev_ctx.thermostat_attr.occupied_heating_setpoint = 8000;  /* Default 80°C */
+	kettle->dev_ctx.thermostat_attr.min_heat_setpoint_limit = TEMP_MIN_ZB;
+	kettle->dev_ctx.thermostat_attr.max_heat_setpoint_limit = TEMP_MAX_ZB;
+	kettle->dev_ctx.thermostat_attr.control_sequence = ZB_ZCL_THERMOSTAT_CONTROL_SEQ_OF_OPERATION_HEATING_ONLY;
+	kettle->dev_ctx.thermostat_attr.system_mode = ZB_ZCL_THERMOSTAT_SYSTEM_MODE_OFF;
+	kettle->dev_ctx.thermostat_attr.time_to_setpoint = TTS_UNKNOWN;
 
 	/* Temperature measurement cluster */
-	dev_ctx.temp_measurement_attr.measured_value = TEMP_INVALID_ZB;
-	dev_ctx.temp_measurement_attr.min_measured_value = TEMP_MIN_ZB;
-	dev_ctx.temp_measurement_attr.max_measured_value = TEMP_MAX_ZB;
+	kettle->dev_ctx.temp_measurement_attr.measured_value = TEMP_INVALID_ZB;
+	kettle->dev_ctx.temp_measurement_attr.min_measured_value = TEMP_MIN_ZB;
+	kettle->dev_ctx.temp_measurement_attr.max_measured_value = TEMP_MAX_ZB;
+
+	/* Kettle cluster: references overridden by persisted values */
+	kettle->dev_ctx.kettle_attr.calibration_state = ZB_KETTLE_CAL_STATE_IDLE;
+	kettle->dev_ctx.kettle_attr.calibration_points = 0;
+	kettle->dev_ctx.kettle_attr.ambient_reference = CAL_AMBIENT_REF_ZB;
+	kettle->dev_ctx.kettle_attr.boil_reference = CAL_BOIL_REF_ZB;
+	kettle->dev_ctx.kettle_attr.water_ready = ZB_KETTLE_READY_NONE;
+	kettle->dev_ctx.kettle_attr.stream_interval = 0;
+	kettle->dev_ctx.kettle_attr.heating_state = ZB_KETTLE_HEATING_OFF;
+}
+
+#ifdef CONFIG_ZIGBEE_FOTA
+/* OTA Upgrade client attribute on the FOTA endpoint, or NULL */
+static zb_zcl_attr_t *ota_client_attr(zb_uint16_t attr_id)
+{
+	return zb_zcl_get_attr_desc_a(CONFIG_ZIGBEE_FOTA_ENDPOINT,
+		ZB_ZCL_CLUSTER_ID_OTA_UPGRADE,
+		ZB_ZCL_CLUSTER_CLIENT_ROLE,
+		attr_id);
+}
+#endif
+
+static void clusters_attr_init(void)
+{
+	ARRAY_FOR_EACH_PTR(kettles, kettle) {
+		kettle_attr_init(kettle);
+	}
+
+	/* Diagnostics cluster: empty histograms */
+	diag_reset();
+
+#ifdef CONFIG_ZIGBEE_FOTA
+	/* OTA client: quiet-mesh block pacing until the first progress event */
+	ota_stats.block_period = CONFIG_KETTLE_OTA_BLOCK_PERIOD_MS;
+	zb_zcl_set_attr_val(CONFIG_ZIGBEE_FOTA_ENDPOINT,
+		ZB_ZCL_CLUSTER_ID_OTA_UPGRADE,
+		ZB_ZCL_CLUSTER_CLIENT_ROLE,
+		ZB_ZCL_ATTR_OTA_UPGRADE_MIN_BLOCK_REQUE_ID,
+		(zb_uint8_t *)&ota_stats.block_period,
+		ZB_FALSE);
+
+	/* ...and the image bytes it asks for per Image Block Request */
+	zb_zcl_attr_t *client = ota_client_attr(ZB_ZCL_ATTR_OTA_UPGRADE_CLIENT_DATA_ID);
+
+	if (client) {
+		((zb_zcl_ota_upgrade_client_variable_t *)client->data_p)->max_data_size =
+			CONFIG_KETTLE_OTA_MAX_DATA_SIZE;
+	}
+#endif
 }
 
 /* ==========================================================================
@@ -1833,11 +4529,193 @@ static void clusters_attr_init(void)
  * ========================================================================== */
 
 #ifdef CONFIG_ZIGBEE_FOTA
+/* Uptime and image offset the throughput is measured from */
+static int64_t ota_start_ms;
+static uint32_t ota_start_offset;
+
+/**
+ * Pace Image Block Requests by the router's buffer pressure.
+ *
+ * The block size stays at CONFIG_KETTLE_OTA_MAX_DATA_SIZE, so the knob is
+ * the client's Minimum Block Period: CONFIG_KETTLE_OTA_BLOCK_PERIOD_MS
+ * while the mesh is quiet, doubled per pressure level up to
+ * CONFIG_KETTLE_OTA_BACKOFF_MAX_MS. Called from ZBOSS context.
+ */
+static void ota_pace(int64_t now)
+{
+	report_pressure_decay(now);
+
+	uint16_t period = MIN((uint32_t)CONFIG_KETTLE_OTA_BLOCK_PERIOD_MS << report_stats.pressure,
+			      CONFIG_KETTLE_OTA_BACKOFF_MAX_MS);
+
+	if (period == ota_stats.block_period) {
+		return;
+	}
+	ota_stats.block_period = period;
+	zb_zcl_set_attr_val(CONFIG_ZIGBEE_FOTA_ENDPOINT,
+		ZB_ZCL_CLUSTER_ID_OTA_UPGRADE,
+		ZB_ZCL_CLUSTER_CLIENT_ROLE,
+		ZB_ZCL_ATTR_OTA_UPGRADE_MIN_BLOCK_REQUE_ID,
+		(zb_uint8_t *)&period,
+		ZB_FALSE);
+}
+
+#ifdef CONFIG_KETTLE_OTA_RESUME
+/**
+ * Record the block just received so a reboot can continue after it.
+ *
+ * The DFU target saves its own write offset on every write
+ * (CONFIG_DFU_TARGET_STREAM_SAVE_PROGRESS); this pairs it with the client's
+ * File Offset and the image identity. Goes through persist_mark(), so a
+ * running download costs one flash write per PERSIST_MAX_DELAY_MS.
+ * Called from ZBOSS context.
+ */
+static void ota_resume_save(uint32_t file_offset)
+{
+	zb_zcl_attr_t *version = ota_client_attr(ZB_ZCL_ATTR_OTA_UPGRADE_DOWNLOADED_FILE_VERSION_ID);
+	zb_zcl_attr_t *manufacturer = ota_client_attr(ZB_ZCL_ATTR_OTA_UPGRADE_MANUFACTURE_ID);
+	zb_zcl_attr_t *image_type = ota_client_attr(ZB_ZCL_ATTR_OTA_UPGRADE_IMAGE_TYPE_ID);
+	size_t image_offset;
+
+	if (!version || !manufacturer || !image_type || dfu_target_offset_get(&image_offset)) {
+		return;
+	}
+
+	k_mutex_lock(&ota_resume_lock, K_FOREVER);
+	ota_resume.file_version = ZB_ZCL_GET_ATTRIBUTE_VAL_32(version);
+	ota_resume.manufacturer = ZB_ZCL_GET_ATTRIBUTE_VAL_16(manufacturer);
+	ota_resume.image_type = ZB_ZCL_GET_ATTRIBUTE_VAL_16(image_type);
+	ota_resume.file_offset = file_offset;
+	ota_resume.image_offset = image_offset;
+	k_mutex_unlock(&ota_resume_lock);
+
+	persist_mark(&kettles[0], PERSIST_OTA_OFFSET);
+}
+
+/* Nothing left to resume: the image finished, failed or was discarded */
+static void ota_resume_clear(void)
+{
+	k_mutex_lock(&ota_resume_lock, K_FOREVER);
+	memset(&ota_resume, 0, sizeof(ota_resume));
+	k_mutex_unlock(&ota_resume_lock);
+
+	persist_mark(&kettles[0], PERSIST_OTA_OFFSET);
+}
+
+/**
+ * Pick up a download interrupted by a reboot.
+ *
+ * Re-opens the MCUboot DFU target, which restores its write offset from
+ * settings, and maps that offset back to the OTA file through the saved
+ * record. The client's File Offset, Downloaded File Version and Image Status
+ * are seeded from it, so its next Image Block Request continues there
+ * instead of at 0; zigbee_fota's own dfu_target_init() for the same target
+ * is then a no-op and keeps the offset. A record that no longer matches the
+ * image identity or the DFU target is dropped along with the partial image.
+ *
+ * Runs after settings_load() and before the stack starts.
+ */
+static void ota_resume_restore(void)
+{
+	zb_zcl_attr_t *manufacturer = ota_client_attr(ZB_ZCL_ATTR_OTA_UPGRADE_MANUFACTURE_ID);
+	zb_zcl_attr_t *image_type = ota_client_attr(ZB_ZCL_ATTR_OTA_UPGRADE_IMAGE_TYPE_ID);
+	size_t written = 0;
+	int err;
+
+	if (ota_resume.file_version == 0) {
+		return;
+	}
+
+	if (!manufacturer || !image_type ||
+	    ZB_ZCL_GET_ATTRIBUTE_VAL_16(manufacturer) != ota_resume.manufacturer ||
+	    ZB_ZCL_GET_ATTRIBUTE_VAL_16(image_type) != ota_resume.image_type) {
+		LOG_WRN("OTA resume dropped: image 0x%04x/0x%04x no longer ours",
+			ota_resume.manufacturer, ota_resume.image_type);
+		ota_resume_clear();
+		return;
+	}
+
+	/* The file size is only bounds-checked; the image is at least this long */
+	err = dfu_target_init(DFU_TARGET_IMAGE_TYPE_MCUBOOT, 0, ota_resume.image_offset, NULL);
+	if (err == 0) {
+		err = dfu_target_offset_get(&written);
+		if (err == 0 && written < ota_resume.image_offset) {
+			err = -ESPIPE;  /* DFU progress older than the record */
+		}
+		if (err) {
+			(void)dfu_target_reset();
+		}
+	}
+	if (err) {
+		LOG_WRN("OTA resume dropped: DFU offset %zu, saved %u (err %d)",
+			written, ota_resume.image_offset, err);
+		ota_resume_clear();
+		return;
+	}
+
+	/* Blocks written after the record was saved count too */
+	uint32_t offset = ota_resume.file_offset + (written - ota_resume.image_offset);
+	zb_uint8_t status = ZB_ZCL_OTA_UPGRADE_IMAGE_STATUS_DOWNLOADING;
+
+	zb_zcl_set_attr_val(CONFIG_ZIGBEE_FOTA_ENDPOINT,
+		ZB_ZCL_CLUSTER_ID_OTA_UPGRADE,
+		ZB_ZCL_CLUSTER_CLIENT_ROLE,
+		ZB_ZCL_ATTR_OTA_UPGRADE_FILE_OFFSET_ID,
+		(zb_uint8_t *)&offset,
+		ZB_FALSE);
+	zb_zcl_set_attr_val(CONFIG_ZIGBEE_FOTA_ENDPOINT,
+		ZB_ZCL_CLUSTER_ID_OTA_UPGRADE,
+		ZB_ZCL_CLUSTER_CLIENT_ROLE,
+		ZB_ZCL_ATTR_OTA_UPGRADE_DOWNLOADED_FILE_VERSION_ID,
+		(zb_uint8_t *)&ota_resume.file_version,
+		ZB_FALSE);
+	zb_zcl_set_attr_val(CONFIG_ZIGBEE_FOTA_ENDPOINT,
+		ZB_ZCL_CLUSTER_ID_OTA_UPGRADE,
+		ZB_ZCL_CLUSTER_CLIENT_ROLE,
+		ZB_ZCL_ATTR_OTA_UPGRADE_IMAGE_STATUS_ID,
+		&status,
+		ZB_FALSE);
+
+	ota_stats.offset = offset;
+	LOG_INF("Resuming OTA image 0x%08x at %u bytes", ota_resume.file_version, offset);
+}
+#endif
+
+/* Update the OTA Diagnostics attributes from the client's File Offset */
+static void ota_progress(int progress)
+{
+	int64_t now = k_uptime_get();
+	zb_zcl_attr_t *attr = ota_client_attr(ZB_ZCL_ATTR_OTA_UPGRADE_FILE_OFFSET_ID);
+	uint32_t offset = attr ? ZB_ZCL_GET_ATTRIBUTE_VAL_32(attr) : ota_stats.offset;
+
+	/* First block, or the server started the image over */
+	if (ota_start_ms == 0 || offset < ota_stats.offset) {
+		ota_start_ms = now;
+		ota_start_offset = offset;
+	}
+
+	int64_t elapsed = now - ota_start_ms;
+
+	ota_stats.progress = CLAMP(progress, 0, 100);
+	ota_stats.offset = offset;
+	if (elapsed > 0) {
+		ota_stats.throughput = MIN((offset - ota_start_offset) * 1000LL / elapsed,
+					   UINT16_MAX);
+	}
+
+	ota_pace(now);
+#ifdef CONFIG_KETTLE_OTA_RESUME
+	ota_resume_save(offset);
+#endif
+}
+
 static void fota_evt_handler(const struct zigbee_fota_evt *evt)
 {
 	switch (evt->id) {
 	case ZIGBEE_FOTA_EVT_PROGRESS:
-		LOG_INF("OTA progress: %d%%", evt->dl.progress);
+		ota_progress(evt->dl.progress);
+		LOG_INF("OTA progress: %d%%, %u B/s, block period %u ms", evt->dl.progress,
+			ota_stats.throughput, ota_stats.block_period);
 		/* Blink status LED during download */
 		if (device_is_ready(status_led.port)) {
 			gpio_pin_toggle_dt(&status_led);
@@ -1846,11 +4724,20 @@ static void fota_evt_handler(const struct zigbee_fota_evt *evt)
 
 	case ZIGBEE_FOTA_EVT_FINISHED:
 		LOG_INF("OTA download complete, rebooting...");
+		ota_start_ms = 0;
+#ifdef CONFIG_KETTLE_OTA_RESUME
+		ota_resume_clear();
+#endif
+		persist_flush_now();
 		sys_reboot(SYS_REBOOT_COLD);
 		break;
 
 	case ZIGBEE_FOTA_EVT_ERROR:
-		LOG_ERR("OTA transfer failed");
+		LOG_ERR("OTA transfer failed at %u bytes", ota_stats.offset);
+		ota_start_ms = 0;
+#ifdef CONFIG_KETTLE_OTA_RESUME
+		ota_resume_clear();
+#endif
 		break;
 
 	default:
@@ -1867,25 +4754,31 @@ static void zcl_device_cb(zb_bufid_t bufid)
 {
 	zb_zcl_device_callback_param_t *param =
 		ZB_BUF_GET_PARAM(bufid, zb_zcl_device_callback_param_t);
+	struct kettle_ctx *kettle = kettle_by_endpoint(param->endpoint);
 
 	param->status = RET_OK;
 
 	switch (param->device_cb_id) {
 	case ZB_ZCL_SET_ATTR_VALUE_CB_ID:
+		if (!kettle) {
+			break;  /* not a kettle endpoint */
+		}
 		/* Handle On/Off commands */
 		if (param->cb_param.set_attr_value_param.cluster_id ==
 		    ZB_ZCL_CLUSTER_ID_ON_OFF) {
 			if (param->cb_param.set_attr_value_param.attr_id ==
 			    ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID) {
 				zb_bool_t requested_state = param->cb_param.set_attr_value_param.values.data8;
-				LOG_INF("On/Off command: %s", requested_state ? "ON" : "OFF");
+				LOG_INF("Kettle %u On/Off command: %s", kettle->index,
+					requested_state ? "ON" : "OFF");
+
+				int err = requested_state ? request_kettle_on(kettle) : request_kettle_off(kettle);
 
-				if (requested_state) {
-					request_kettle_on();
-				} else {
-					request_kettle_off();
+				if (err) {
+					/* Nothing pressed: keep the attribute, fail the command */
+					param->status = RET_ERROR;
 				}
-				/* Note: The actual state will be updated by kettle_state_gpio
+				/* Note: The actual state will be updated by kettle->hw->state_gpio
 				 * when the kettle responds, or by timeout if it declines */
 			}
 		}
@@ -1895,9 +4788,26 @@ static void zcl_device_cb(zb_bufid_t bufid)
 			if (param->cb_param.set_attr_value_param.attr_id ==
 			    ZB_ZCL_ATTR_THERMOSTAT_OCCUPIED_HEATING_SETPOINT_ID) {
 				int16_t new_setpoint = param->cb_param.set_attr_value_param.values.data16;
-				LOG_INF("Thermostat setpoint changed: %d.%02d°C",
-					new_setpoint / 100, new_setpoint % 100);
-				save_kettle_state();
+				LOG_INF("Kettle %u thermostat setpoint changed: %d.%02d°C",
+					kettle->index, new_setpoint / 100, new_setpoint % 100);
+				persist_mark(kettle, PERSIST_TARGET_TEMP);
+			}
+		}
+		/* Calibration references and stream interval written from Zigbee */
+		else if (param->cb_param.set_attr_value_param.cluster_id ==
+		    ZB_ZCL_CLUSTER_ID_KETTLE) {
+			if (param->cb_param.set_attr_value_param.attr_id ==
+			    ZB_ZCL_ATTR_KETTLE_AMBIENT_REFERENCE_ID) {
+				persist_mark(kettle, PERSIST_AMBIENT_REF);
+			} else if (param->cb_param.set_attr_value_param.attr_id ==
+				   ZB_ZCL_ATTR_KETTLE_BOIL_REFERENCE_ID) {
+				persist_mark(kettle, PERSIST_BOIL_REF);
+			} else if (param->cb_param.set_attr_value_param.attr_id ==
+				   ZB_ZCL_ATTR_KETTLE_STREAM_INTERVAL_ID) {
+				LOG_INF("Kettle %u telemetry stream interval: %u s", kettle->index,
+					param->cb_param.set_attr_value_param.values.data16);
+				persist_mark(kettle, PERSIST_STREAM_INTERVAL);
+				stream_flush_now(kettle);
 			}
 		}
 		break;
@@ -1953,9 +4863,10 @@ void zboss_signal_handler(zb_bufid_t bufid)
 			set_tx_power();
 #endif
 			configure_reporting();
-			/* Report initial values so coordinator has current state */
-			schedule_state_report();
-			schedule_target_temp_report();
+			/* Hello: dev_ctx already holds the boot sample, send it all now */
+			ARRAY_FOR_EACH_PTR(kettles, kettle) {
+				report_changed(kettle, REPORT_HELLO_MASK);
+			}
 		} else {
 			LOG_INF("Not joined, starting network steering...");
 			bdb_start_top_level_commissioning(ZB_BDB_NETWORK_STEERING);
@@ -1970,8 +4881,9 @@ void zboss_signal_handler(zb_bufid_t bufid)
 #endif
 			configure_reporting();
 			/* Report initial values so coordinator has current state */
-			schedule_state_report();
-			schedule_target_temp_report();
+			ARRAY_FOR_EACH_PTR(kettles, kettle) {
+				report_changed(kettle, REPORT_HELLO_MASK);
+			}
 		} else {
 			LOG_WRN("Network steering failed (status=%d), retrying...", status);
 			bdb_start_top_level_commissioning(ZB_BDB_NETWORK_STEERING);
@@ -1998,6 +4910,53 @@ void zboss_signal_handler(zb_bufid_t bufid)
  * Main
  * ========================================================================== */
 
+/**
+ * Set up the kettle contexts from the devicetree instances.
+ *
+ * Runtime rather than static initialization: each context holds two
+ * calibration tables, which a static initializer would place in flash.
+ */
+static int kettles_init(void)
+{
+	ARRAY_FOR_EACH_PTR(kettles, kettle) {
+		size_t i = ARRAY_INDEX(kettles, kettle);
+
+		for (size_t j = 0; j < i; j++) {
+			if (kettle_instances[j].endpoint == kettle_instances[i].endpoint) {
+				LOG_ERR("Kettles %zu and %zu share endpoint %u", j, i,
+					kettle_instances[i].endpoint);
+				return -EINVAL;
+			}
+		}
+
+		kettle->hw = &kettle_instances[i];
+		kettle->index = i;
+		kettle->heating_state = KETTLE_STATE_OFF;
+		kettle->state_gpio_last = -1;
+		kettle->burst_adc = -1;
+		kettle->adc_policy.dial_code = -1;
+		kettle->adc_target_filter.kind = ADC_TARGET_FILTER_KIND;
+		kettle->water.off_base_code = KETTLE_OFF_BASE_CODE;
+		kettle->water.filter.kind = ADC_CURRENT_FILTER_KIND;
+		kettle->temp_tables.target = kettle_target_temp_lut;
+		kettle->temp_tables.current = kettle_current_temp_lut;
+		kettle->history.base = TEMP_INVALID_ZB;
+		kettle->history.last = TEMP_INVALID_ZB;
+
+		k_work_init_delayable(&kettle->state_work, kettle_state_work_handler);
+		k_work_init_delayable(&kettle->transition_timeout_work,
+				      kettle_transition_timeout_handler);
+		k_timer_init(&kettle->pulse_timer, kettle_pulse_timer_handler, NULL);
+		k_work_init(&kettle->cal_apply_work, cal_apply_work_handler);
+		k_work_init_delayable(&kettle->cal_timeout_work, cal_timeout_work_handler);
+		k_work_init_delayable(&kettle->stream_work, stream_work_handler);
+	}
+
+	LOG_INF("%d kettle(s) on endpoint(s) %u..%u", KETTLE_INSTANCE_COUNT,
+		kettles[0].hw->endpoint, kettles[KETTLE_INSTANCE_COUNT - 1].hw->endpoint);
+	return 0;
+}
+
 int main(void)
 {
 	int err;
@@ -2009,6 +4968,11 @@ int main(void)
 	LOG_INF("Fixes: Race conditions, buffer exhaustion");
 	LOG_INF("========================================");
 
+	err = kettles_init();
+	if (err) {
+		return err;
+	}
+
 	/* Initialize status LED */
 	if (device_is_ready(status_led.port)) {
 		err = gpio_pin_configure_dt(&status_led, GPIO_OUTPUT_INACTIVE);
@@ -2025,25 +4989,25 @@ int main(void)
 		return err;
 	}
 
-	/* Initialize kettle state GPIO */
-	err = kettle_state_init();
-	if (err) {
-		LOG_ERR("Kettle state init failed: %d", err);
-		return err;
-	}
-
-	/* Initialize kettle button output (for simulating button press) */
-	if (device_is_ready(kettle_button_gpio.port)) {
-		err = gpio_pin_configure_dt(&kettle_button_gpio, GPIO_OUTPUT_INACTIVE);
-		if (err < 0) {
-			LOG_ERR("Kettle button GPIO config failed: %d", err);
+	ARRAY_FOR_EACH_PTR(kettles, kettle) {
+		/* Initialize kettle state GPIO */
+		err = kettle_state_init(kettle);
+		if (err) {
+			LOG_ERR("Kettle %u state init failed: %d", kettle->index, err);
 			return err;
 		}
-		k_work_init_delayable(&kettle_button_release_work, kettle_button_release_handler);
-		k_work_init_delayable(&kettle_transition_timeout_work, kettle_transition_timeout_handler);
-		LOG_INF("Kettle button output initialized");
-	} else {
-		LOG_WRN("Kettle button GPIO not ready");
+
+		/* Initialize kettle button output (for simulating button press) */
+		if (device_is_ready(kettle->hw->button_gpio.port)) {
+			err = gpio_pin_configure_dt(&kettle->hw->button_gpio, GPIO_OUTPUT_INACTIVE);
+			if (err < 0) {
+				LOG_ERR("Kettle %u button GPIO config failed: %d", kettle->index, err);
+				return err;
+			}
+			LOG_INF("Kettle %u button output initialized", kettle->index);
+		} else {
+			LOG_WRN("Kettle %u button GPIO not ready", kettle->index);
+		}
 	}
 
 	/* Initialize ADC for temperature sensing */
@@ -2054,6 +5018,7 @@ int main(void)
 	}
 
 	/* Initialize settings subsystem */
+	k_work_init_delayable(&persist_work, persist_work_handler);
 	err = settings_subsys_init();
 	if (err) {
 		LOG_ERR("Settings init failed: %d", err);
@@ -2084,19 +5049,43 @@ int main(void)
 	ZB_ZCL_REGISTER_DEVICE_CB(zcl_device_cb);
 
 	/* Register device context */
-	ZB_AF_REGISTER_DEVICE_CTX(&kettle_ctx);
+	ZB_AF_REGISTER_DEVICE_CTX(&kettle_zb_ctx);
 
 	/* Initialize cluster attributes */
 	clusters_attr_init();
 
-	/* Load settings (restores previous target temperature) */
+	/* Load settings (restores previous target temperature and calibration) */
 	err = settings_load();
 	if (err) {
 		LOG_ERR("Settings load failed: %d", err);
 	}
+	ARRAY_FOR_EACH_PTR(kettles, kettle) {
+		calibration_apply(kettle);
+	}
+#ifdef CONFIG_KETTLE_OTA_RESUME
+	/* Needs the saved record, so after settings_load(); zigbee_fota_init()
+	 * above has already reset the client attributes this seeds
+	 */
+	ota_resume_restore();
+#endif
 
-	/* Start ADC sampling */
-	k_work_schedule(&adc_sample_work, K_NO_WAIT);
+	/* Start ADC sampling on its own workqueue */
+	k_work_queue_init(&sensor_wq);
+	k_work_queue_start(&sensor_wq, sensor_wq_stack, K_THREAD_STACK_SIZEOF(sensor_wq_stack),
+			   CONFIG_KETTLE_SENSOR_PRIORITY, &(struct k_work_queue_config){ .name = "sensor" });
+	adc_sample_due(0);
+	k_work_schedule_for_queue(&sensor_wq, &adc_sample_work, K_NO_WAIT);
+
+	/* Fast start: hold the stack for the first cycle (GPIO state is read in
+	 * kettle_state_init()). Its samples are queued for ZBOSS context, which
+	 * applies them to each dev_ctx before the reboot signal, so the hello report
+	 * carries real values instead of TEMP_INVALID_ZB.
+	 */
+	if (k_sem_take(&sensor_first_sem, K_MSEC(ADC_FIRST_SAMPLE_WAIT_MS)) == 0) {
+		LOG_INF("First sample ready at %u ms", k_uptime_get_32());
+	} else {
+		LOG_WRN("No sample before Zigbee start");
+	}
 
 	/* Start health monitoring (logs every 5 minutes for diagnostics) */
 	k_work_init_delayable(&health_monitor_work, health_monitor_work_handler);
@@ -2109,28 +5098,43 @@ int main(void)
 	/* Start Zigbee stack (Router mode - always on) */
 	zigbee_enable();
 
-	/* Main loop - poll GPIOs since interrupts aren't working on nRF54L15 */
+	/* Poll only the inputs that have no edge interrupt */
 	static int last_button_state = -1;
-	static int last_kettle_gpio_state = -1;
 
-	while (1) {
-		/* Poll pairing button */
-		int btn = gpio_pin_get_dt(&button);
-		if (btn != last_button_state) {
-			last_button_state = btn;
-			k_work_submit(&button_work);
+	while (gpio_polled_inputs != 0) {
+		if (gpio_polled_inputs & GPIO_POLL_BUTTON) {
+			int btn = gpio_pin_get_dt(&button);
+			if (btn != last_button_state) {
+				last_button_state = btn;
+				k_work_submit(&button_work);
+			}
 		}
 
-		/* Poll kettle state GPIO */
-		int kettle_gpio = gpio_pin_get_dt(&kettle_state_gpio);
-		if (kettle_gpio != last_kettle_gpio_state) {
-			LOG_INF("Kettle GPIO: %d -> %d", last_kettle_gpio_state, kettle_gpio);
-			last_kettle_gpio_state = kettle_gpio;
-			update_kettle_state();
+		if (gpio_polled_inputs & GPIO_POLL_KETTLE_STATE) {
+			ARRAY_FOR_EACH_PTR(kettles, kettle) {
+				if (!kettle->state_polled) {
+					continue;
+				}
+
+				int kettle_gpio = gpio_pin_get_dt(&kettle->hw->state_gpio);
+				if (kettle_gpio != kettle->state_gpio_last) {
+					LOG_INF("Kettle %u GPIO: %d -> %d", kettle->index,
+						kettle->state_gpio_last, kettle_gpio);
+					kettle->state_gpio_last = kettle_gpio;
+					/* Timed from detection: up to GPIO_POLL_INTERVAL_MS after the edge */
+					kettle->diag_edge_cyc = k_cycle_get_32();
+					atomic_set_bit(&kettle->diag_flags, DIAG_EDGE_PENDING);
+					kettle_state_post(kettle, KETTLE_EVENT_EDGE);
+				}
+			}
 		}
 
-		k_sleep(K_MSEC(50));
+		k_sleep(K_MSEC(GPIO_POLL_INTERVAL_MS));
 	}
 
+	/* All inputs are interrupt driven - nothing left for this thread */
+	LOG_INF("GPIO inputs interrupt driven, main thread idle");
+	k_sleep(K_FOREVER);
+
 	return 0;
 }
@@ -0,0 +1,306 @@
+/*
+ * Copyright (c) 2025
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Benchmarks: cycles per sample, conversion error against the calibration
+ * points, and end-to-end detection latency on the sampling schedule
+ *
+ * Figures are printed with TC_PRINT and bounded loosely, so a regression
+ * fails the run while the numbers themselves are read from the log. Cycle
+ * counts are only meaningful on hardware (kettle.sense.bench on the DK);
+ * the native_sim cycle counter is simulated time.
+ */
+
+#include <string.h>
+
+#include <zephyr/ztest.h>
+#include <zephyr/kernel.h>
+
+#include "trace.h"
+#include "kettle_temp_lut.h"
+
+/* ==========================================================================
+ * Cycles per Sample
+ * ========================================================================== */
+
+#define BENCH_BURSTS            16
+#define BENCH_ROUNDS            64
+
+static int16_t bench_bursts[BENCH_BURSTS][BURST_SAMPLE_COUNT];
+
+static void bench_make_bursts(void)
+{
+	trace_seed(16);
+
+	for (int i = 0; i < BENCH_BURSTS; i++) {
+		struct ntc_wave w = {
+			.level = trace_code_for_temp(2000 + i * 500),
+			.amplitude = TRACE_PULSE_AMPLITUDE,
+			.period_us = TRACE_PULSE_PERIOD_US,
+			.high_us = TRACE_PULSE_HIGH_US,
+			.phase_us = i * 1250,
+			.noise = TRACE_NOISE,
+		};
+
+		trace_burst(&w, 0, bench_bursts[i], BURST_SAMPLE_COUNT);
+	}
+}
+
+/* Sorting baseline, the burst evaluation this code replaced */
+static int16_t bench_sort_low(const int16_t *samples)
+{
+	int16_t v[BURST_SAMPLE_COUNT];
+
+	memcpy(v, samples, sizeof(v));
+	for (int i = 1; i < BURST_SAMPLE_COUNT; i++) {
+		int16_t x = v[i];
+		int j = i - 1;
+
+		while (j >= 0 && v[j] > x) {
+			v[j + 1] = v[j];
+			j--;
+		}
+		v[j + 1] = x;
+	}
+	return v[BURST_PERCENTILE_INDEX];
+}
+
+static void bench_report(const char *what, uint32_t cycles, uint32_t samples)
+{
+	uint32_t per_sample = cycles / samples;
+	uint32_t ns = (uint32_t)(((uint64_t)per_sample * NSEC_PER_SEC) /
+				 sys_clock_hw_cycles_per_sec());
+
+	if (cycles == 0) {
+		TC_PRINT("%s: cycle counter does not advance on this platform\n", what);
+		return;
+	}
+	TC_PRINT("%s: %u cycles/sample (%u ns)\n", what, per_sample, ns);
+}
+
+ZTEST(sense_bench, test_bench_cycles_per_sample)
+{
+	struct adc_filter filter = { .kind = ADC_FILTER_EMA };
+	struct burst_stats stats;
+	volatile int32_t sink = 0;
+	uint32_t start, pipeline, sorting;
+
+	bench_make_bursts();
+
+	/* burst_select + filter + conversion: one water channel cycle */
+	start = k_cycle_get_32();
+	for (int round = 0; round < BENCH_ROUNDS; round++) {
+		for (int i = 0; i < BENCH_BURSTS; i++) {
+			burst_select(bench_bursts[i], BURST_SAMPLE_COUNT,
+				     BURST_PERCENTILE_INDEX, &stats);
+			sink += adc_to_current_temp(&trace_tables,
+						    adc_filter_update(&filter, stats.low,
+								      round * BENCH_BURSTS + i));
+		}
+	}
+	pipeline = k_cycle_get_32() - start;
+
+	start = k_cycle_get_32();
+	for (int round = 0; round < BENCH_ROUNDS; round++) {
+		for (int i = 0; i < BENCH_BURSTS; i++) {
+			sink += bench_sort_low(bench_bursts[i]);
+		}
+	}
+	sorting = k_cycle_get_32() - start;
+
+	bench_report("select+filter+LUT", pipeline, BENCH_ROUNDS * BENCH_BURSTS);
+	bench_report("insertion sort baseline", sorting, BENCH_ROUNDS * BENCH_BURSTS);
+
+	/* Same answer as the baseline on every burst */
+	for (int i = 0; i < BENCH_BURSTS; i++) {
+		burst_select(bench_bursts[i], BURST_SAMPLE_COUNT, BURST_PERCENTILE_INDEX, &stats);
+		zassert_equal(stats.low, bench_sort_low(bench_bursts[i]), "burst %d", i);
+	}
+	ARG_UNUSED(sink);
+}
+
+/* ==========================================================================
+ * Conversion Error
+ *
+ * Every code inside the calibrated range against the piecewise linear
+ * curve through the points, evaluated at the code's exact voltage. The
+ * tables truncate to whole mV and whole 0.01°C, so the error stays within
+ * about two mV of the steepest segment (0.12°C on the NTC near 90°C).
+ * ========================================================================== */
+
+/* Reference points, as in calibration/5kek1522.json (mV before the divider, 0.01°C) */
+static const int32_t ref_target[][2] = {
+	{ 0, 10000 }, { 800, 9500 }, { 1700, 9000 }, { 2600, 8000 },
+	{ 3700, 7000 }, { 4500, 6000 }, { 5000, 5000 },
+};
+static const int32_t ref_current[][2] = {
+	{ 1060, 2000 }, { 1180, 2500 }, { 1440, 3500 }, { 1720, 4500 },
+	{ 2000, 5500 }, { 2260, 6500 }, { 2500, 7500 }, { 2720, 8500 },
+	{ 2900, 9500 }, { 3000, 9900 }, { 3260, 10000 },
+};
+
+#define CONV_MAX_ERROR          15      /* 0.01°C */
+
+/* Reference temperature at a code, in 0.00001°C to stay in integers */
+static int32_t ref_temp_milli(const int32_t (*pts)[2], int n, int16_t code)
+{
+	/* Exact voltage before the divider in uV */
+	int64_t uv = (int64_t)code * KETTLE_TEMP_LUT_FULL_SCALE_MV *
+		     KETTLE_TEMP_LUT_DIVIDER_RATIO * 1000 / ADC_MAX_VALUE;
+
+	for (int i = 0; i < n - 1; i++) {
+		if (uv <= pts[i + 1][0] * 1000) {
+			return pts[i][1] * 1000 +
+			       (int32_t)((int64_t)(pts[i + 1][1] - pts[i][1]) *
+					 (uv - pts[i][0] * 1000) /
+					 (pts[i + 1][0] - pts[i][0]));
+		}
+	}
+	return pts[n - 1][1] * 1000;
+}
+
+static int32_t bench_conversion(const char *what, const int32_t (*pts)[2], int n,
+				int16_t (*convert)(const struct kettle_temp_tables *, int16_t))
+{
+	int32_t max_err = 0;
+	int64_t sum = 0;
+	int count = 0;
+
+	for (int16_t code = 0; code <= ADC_MAX_VALUE; code++) {
+		int64_t mv = (int64_t)code * KETTLE_TEMP_LUT_FULL_SCALE_MV *
+			     KETTLE_TEMP_LUT_DIVIDER_RATIO / ADC_MAX_VALUE;
+		int16_t temp = convert(&trace_tables, code);
+
+		if (mv < pts[0][0] || mv >= pts[n - 1][0] || temp == TEMP_INVALID_ZB) {
+			continue;
+		}
+
+		int32_t err = temp * 1000 - ref_temp_milli(pts, n, code);
+
+		err = err < 0 ? -err : err;
+		max_err = MAX(max_err, err);
+		sum += err;
+		count++;
+	}
+
+	int32_t mean_err = (int32_t)(sum / count);
+
+	TC_PRINT("%s conversion: %d codes, error max %d.%03d mean %d.%03d (0.01°C)\n",
+		 what, count, max_err / 1000, max_err % 1000, mean_err / 1000, mean_err % 1000);
+	return max_err / 1000;
+}
+
+ZTEST(sense_bench, test_bench_conversion_error)
+{
+	int32_t target = bench_conversion("Dial", ref_target, ARRAY_SIZE(ref_target),
+					  adc_to_target_temp);
+	int32_t current = bench_conversion("Water", ref_current, ARRAY_SIZE(ref_current),
+					   adc_to_current_temp);
+
+	zassert_true(target <= CONV_MAX_ERROR, "dial error %d", target);
+	zassert_true(current <= CONV_MAX_ERROR, "water error %d", current);
+}
+
+/* ==========================================================================
+ * Detection Latency
+ *
+ * Ready detection: the kettle heats from 20°C at 0.3°C/s, sampled every
+ * ADC_INTERVAL_HEATING_MS; the latency is from the water reaching the
+ * setpoint to the first reading at or above it, per filter.
+ * Lift-off: the time from the water line dropping to the first invalid
+ * reading when only the sampling schedule notices it (no GPIO edge).
+ * ========================================================================== */
+
+#define LATENCY_SETPOINT        9000
+#define LATENCY_RATE            30      /* 0.01°C/s */
+#define LATENCY_MAX_MS          (6 * ADC_INTERVAL_HEATING_MS)
+
+static int32_t bench_ready_latency(enum adc_filter_kind kind)
+{
+	struct water_replay r;
+	/* Water reaches the setpoint at reach_ms */
+	int64_t reach_ms = 1000 + (int64_t)(LATENCY_SETPOINT - 2000) * 1000 / LATENCY_RATE;
+
+	trace_seed(90);
+	water_replay_init(&r, kind);
+
+	for (int64_t t_ms = 1000; t_ms < reach_ms + 60000; t_ms += ADC_INTERVAL_HEATING_MS) {
+		struct ntc_wave w = {
+			.level = trace_code_for_temp(2000 + (t_ms - 1000) * LATENCY_RATE / 1000),
+			.amplitude = TRACE_PULSE_AMPLITUDE,
+			.period_us = TRACE_PULSE_PERIOD_US,
+			.high_us = TRACE_PULSE_HIGH_US,
+			.noise = TRACE_NOISE,
+		};
+
+		if (water_replay_sample(&r, &w, t_ms) >= LATENCY_SETPOINT) {
+			return (int32_t)(t_ms - reach_ms);
+		}
+	}
+	return INT32_MAX;
+}
+
+ZTEST(sense_bench, test_bench_ready_latency)
+{
+	static const struct {
+		enum adc_filter_kind kind;
+		const char *name;
+	} filters[] = {
+		{ ADC_FILTER_EMA, "EMA" },
+		{ ADC_FILTER_MEDIAN_EMA, "median-EMA" },
+		{ ADC_FILTER_ALPHA_BETA, "alpha-beta" },
+	};
+
+	for (int i = 0; i < ARRAY_SIZE(filters); i++) {
+		int32_t latency = bench_ready_latency(filters[i].kind);
+
+		TC_PRINT("Ready latency, %s: %d ms\n", filters[i].name, latency);
+		zassert_true(latency <= LATENCY_MAX_MS, "%s: %d ms", filters[i].name, latency);
+	}
+}
+
+ZTEST(sense_bench, test_bench_lift_off_latency)
+{
+	static const uint32_t intervals_ms[] = {
+		ADC_INTERVAL_HEATING_MS, ADC_SAMPLE_INTERVAL_MS, ADC_INTERVAL_IDLE_MS,
+	};
+
+	trace_seed(3);
+
+	for (int i = 0; i < ARRAY_SIZE(intervals_ms); i++) {
+		uint32_t worst_ms = 0;
+
+		/* Lift at every 100ms offset into the interval */
+		for (uint32_t lift_ms = 0; lift_ms < intervals_ms[i]; lift_ms += 100) {
+			struct water_replay r;
+			int64_t lift_at = 10000 + lift_ms;
+			int64_t t_ms;
+
+			water_replay_init(&r, ADC_FILTER_EMA);
+			for (t_ms = 1000; ; t_ms += intervals_ms[i]) {
+				bool lifted = t_ms >= lift_at;
+				struct ntc_wave w = {
+					.level = lifted ? TRACE_OFF_BASE_LEVEL :
+						 trace_code_for_temp(8000),
+					.amplitude = lifted ? 0 : TRACE_PULSE_AMPLITUDE,
+					.period_us = lifted ? 0 : TRACE_PULSE_PERIOD_US,
+					.high_us = TRACE_PULSE_HIGH_US,
+					.noise = TRACE_NOISE,
+				};
+
+				if (water_replay_sample(&r, &w, t_ms) == TEMP_INVALID_ZB) {
+					break;
+				}
+			}
+			zassert_true(t_ms >= lift_at, "invalid reading before the lift");
+			worst_ms = MAX(worst_ms, (uint32_t)(t_ms - lift_at));
+		}
+
+		TC_PRINT("Lift-off latency at %u ms cycles: worst %u ms\n",
+			 intervals_ms[i], worst_ms);
+		zassert_true(worst_ms < intervals_ms[i], "worst %u ms", worst_ms);
+	}
+}
+
+ZTEST_SUITE(sense_bench, NULL, NULL, NULL, NULL, NULL);
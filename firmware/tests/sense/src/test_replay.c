@@ -0,0 +1,471 @@
+/*
+ * Copyright (c) 2025
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Trace replay: burst select, phase-locked capture, filters and conversion
+ * against synthetic pulsed NTC traces with lift-off events
+ */
+
+#include <zephyr/ztest.h>
+
+#include "trace.h"
+#include "kettle_temp_lut.h"
+
+/* Insertion sort, the reference for burst_select() */
+static void sort_codes(int16_t *v, uint8_t count)
+{
+	for (uint8_t i = 1; i < count; i++) {
+		int16_t x = v[i];
+		int j = i - 1;
+
+		while (j >= 0 && v[j] > x) {
+			v[j + 1] = v[j];
+			j--;
+		}
+		v[j + 1] = x;
+	}
+}
+
+ZTEST(sense_replay, test_burst_select_matches_sort)
+{
+	int16_t samples[BURST_SAMPLE_COUNT];
+	int16_t sorted[BURST_SAMPLE_COUNT];
+	struct burst_stats stats;
+
+	trace_seed(0x5eed);
+
+	for (int run = 0; run < 500; run++) {
+		uint8_t count = run % BURST_SAMPLE_COUNT + 1;
+		uint8_t low_rank = BURST_LOW_RANK(count);
+
+		for (uint8_t i = 0; i < count; i++) {
+			/* Include out of range codes: both ends clamp */
+			samples[i] = (int16_t)(trace_rand() % (ADC_MAX_VALUE + 201)) - 100;
+			sorted[i] = CLAMP(samples[i], 0, ADC_MAX_VALUE);
+		}
+		sort_codes(sorted, count);
+
+		burst_select(samples, count, low_rank, &stats);
+
+		zassert_equal(stats.min, sorted[0], "run %d: min", run);
+		zassert_equal(stats.max, sorted[count - 1], "run %d: max", run);
+		zassert_equal(stats.low, sorted[low_rank], "run %d: low", run);
+		zassert_equal(stats.median, sorted[count / 2], "run %d: median", run);
+	}
+}
+
+ZTEST(sense_replay, test_burst_select_flat)
+{
+	int16_t samples[BURST_SAMPLE_COUNT];
+	struct burst_stats stats;
+
+	for (uint8_t i = 0; i < BURST_SAMPLE_COUNT; i++) {
+		samples[i] = 1234;
+	}
+
+	burst_select(samples, BURST_SAMPLE_COUNT, BURST_PERCENTILE_INDEX, &stats);
+
+	zassert_equal(stats.min, 1234);
+	zassert_equal(stats.low, 1234);
+	zassert_equal(stats.median, 1234);
+	zassert_equal(stats.max, 1234);
+}
+
+/* The low percentile of a burst reads the level under the pulse, at any
+ * phase of a 50Hz or 60Hz pulse, across the water temperature range
+ */
+ZTEST(sense_replay, test_pulsed_ntc_low_percentile)
+{
+	static const uint32_t periods_us[] = { TRACE_PULSE_PERIOD_US, 16667 };
+	int16_t samples[BURST_SAMPLE_COUNT];
+	struct burst_stats stats;
+
+	trace_seed(50);
+
+	for (int p = 0; p < ARRAY_SIZE(periods_us); p++) {
+		for (int16_t temp = 2000; temp <= 10000; temp += 250) {
+			for (uint32_t phase = 0; phase < periods_us[p]; phase += 1000) {
+				struct ntc_wave w = {
+					.level = trace_code_for_temp(temp),
+					.amplitude = TRACE_PULSE_AMPLITUDE,
+					.period_us = periods_us[p],
+					.high_us = periods_us[p] * 3 / 5,
+					.phase_us = phase,
+					.noise = TRACE_NOISE,
+				};
+
+				trace_burst(&w, 0, samples, BURST_SAMPLE_COUNT);
+				burst_select(samples, BURST_SAMPLE_COUNT, BURST_PERCENTILE_INDEX, &stats);
+
+				zassert_within(stats.low, w.level, TRACE_NOISE,
+					       "%uus period, phase %uus: low %d, level %d",
+					       periods_us[p], phase, stats.low, w.level);
+				/* ...so the reading is off by no more than the noise */
+				int16_t reading = adc_to_current_temp(&trace_tables, stats.low);
+
+				zassert_true(reading >= adc_to_current_temp(&trace_tables,
+									    w.level - TRACE_NOISE) &&
+					     reading <= adc_to_current_temp(&trace_tables,
+									    w.level + TRACE_NOISE),
+					     "%uus period, phase %uus: %d.%02d°C",
+					     periods_us[p], phase, temp / 100, temp % 100);
+			}
+		}
+	}
+}
+
+/* Phase-locked capture: steady water at PHASE_TEMP, one cycle a second */
+#define PHASE_TEMP              8000
+#define PHASE_CYCLES            180
+#define PHASE_INTERVAL_MS       ADC_SAMPLE_INTERVAL_MS
+#define PHASE_MAINS_DRIFT_PPM   1000    /* 0.1%, well past a mains frequency excursion */
+
+static struct ntc_wave phase_wave(uint32_t period_us, uint32_t phase_us)
+{
+	return (struct ntc_wave){
+		.level = trace_code_for_temp(PHASE_TEMP),
+		.amplitude = TRACE_PULSE_AMPLITUDE,
+		.period_us = period_us,
+		.high_us = period_us * 3 / 5,
+		.phase_us = phase_us,
+		.noise = TRACE_NOISE,
+	};
+}
+
+/* Take a reading of @p w at @p t_ms and check it is off by no more than the noise */
+static void phase_check_sample(struct water_replay *r, const struct ntc_wave *w, int64_t t_ms)
+{
+	int16_t reading = water_replay_sample(r, w, t_ms);
+	int16_t lo = adc_to_current_temp(&trace_tables, w->level - 2 * TRACE_NOISE);
+	int16_t hi = adc_to_current_temp(&trace_tables, w->level + 2 * TRACE_NOISE);
+
+	zassert_true(reading >= lo && reading <= hi,
+		     "%uus period, phase %uus, %d ms: %d, expected %d..%d",
+		     w->period_us, w->phase_us, (int)t_ms, reading, lo, hi);
+}
+
+/* Replay PHASE_CYCLES of a steady waveform from a fresh channel */
+static void phase_replay(struct water_replay *r, const struct ntc_wave *w)
+{
+	water_replay_init(r, ADC_FILTER_EMA);
+
+	for (int i = 0; i < PHASE_CYCLES; i++) {
+		phase_check_sample(r, w, 1000 + (int64_t)i * PHASE_INTERVAL_MS);
+	}
+}
+
+/* Once learnt, every cycle but the periodic relearn is a short capture, at
+ * any start offset into a 50Hz or 60Hz pulse
+ */
+ZTEST(sense_replay, test_phase_lock_start_offsets)
+{
+	static const uint32_t periods_us[] = { PHASE_PERIOD_50HZ_US, PHASE_PERIOD_60HZ_US };
+	struct water_replay r;
+
+	trace_seed(30);
+
+	for (int p = 0; p < ARRAY_SIZE(periods_us); p++) {
+		for (uint32_t phase = 0; phase < periods_us[p]; phase += 1000) {
+			struct ntc_wave w = phase_wave(periods_us[p], phase);
+
+			phase_replay(&r, &w);
+
+			zassert_equal(r.phase.period_us, periods_us[p],
+				      "%uus period, phase %uus: locked to %uus",
+				      periods_us[p], phase, r.phase.period_us);
+			zassert_equal(r.lock_losses, 0, "%uus period, phase %uus: %u losses",
+				      periods_us[p], phase, r.lock_losses);
+			zassert_equal(r.full_bursts, 1 + (PHASE_CYCLES - 1) / PHASE_RELEARN_CYCLES,
+				      "%uus period, phase %uus: %u full bursts",
+				      periods_us[p], phase, r.full_bursts);
+		}
+	}
+}
+
+/* Mains drift: followed without losing lock; a pulse off nominal by up to
+ * PHASE_PERIOD_TOL_US still locks but falls back to full bursts as the
+ * prediction slips, and one outside both mains bands never locks. The
+ * reading holds throughout.
+ */
+ZTEST(sense_replay, test_phase_lock_drift)
+{
+	static const uint32_t periods_us[] = { PHASE_PERIOD_50HZ_US, PHASE_PERIOD_60HZ_US };
+	static const uint32_t unlockable_us[] = {
+		PHASE_PERIOD_60HZ_US - 2 * PHASE_PERIOD_TOL_US,
+		PHASE_PERIOD_50HZ_US + 2 * PHASE_PERIOD_TOL_US,
+	};
+	struct water_replay r;
+
+	trace_seed(31);
+
+	for (int p = 0; p < ARRAY_SIZE(periods_us); p++) {
+		uint32_t drift_us = periods_us[p] * PHASE_MAINS_DRIFT_PPM / 1000000;
+
+		for (int sign = -1; sign <= 1; sign += 2) {
+			struct ntc_wave w;
+
+			/* Mains drift: the PLL folds it into the period */
+			w = phase_wave(periods_us[p] + sign * (int32_t)drift_us, 7000);
+			phase_replay(&r, &w);
+			zassert_equal(r.lock_losses, 0, "%uus period: %u losses",
+				      w.period_us, r.lock_losses);
+			zassert_within(r.phase.period_us, w.period_us, drift_us / 4,
+				       "%uus period tracked as %uus", w.period_us, r.phase.period_us);
+
+			/* Edge of the snap tolerance: learnt as nominal */
+			w = phase_wave(periods_us[p] + sign * PHASE_PERIOD_TOL_US, 7000);
+			phase_replay(&r, &w);
+			zassert_true(r.locked_captures > 0, "%uus period never locked", w.period_us);
+			zassert_equal(r.full_bursts, PHASE_CYCLES - r.locked_captures + r.lock_losses,
+				      "%uus period: %u full, %u locked, %u lost", w.period_us,
+				      r.full_bursts, r.locked_captures, r.lock_losses);
+		}
+	}
+
+	for (int p = 0; p < ARRAY_SIZE(unlockable_us); p++) {
+		struct ntc_wave w = phase_wave(unlockable_us[p], 7000);
+
+		phase_replay(&r, &w);
+		zassert_equal(r.locked_captures, 0, "%uus period locked", w.period_us);
+		zassert_equal(r.full_bursts, PHASE_CYCLES);
+	}
+}
+
+/* A phase jump, and a switch from 50Hz to 60Hz, each cost one full burst
+ * in the same cycle; the reading of that cycle still holds and the next
+ * cycles are locked again
+ */
+ZTEST(sense_replay, test_phase_lock_loss)
+{
+	struct ntc_wave w = phase_wave(PHASE_PERIOD_50HZ_US, 3000);
+	struct water_replay r;
+	int64_t t_ms = 1000;
+
+	trace_seed(32);
+	water_replay_init(&r, ADC_FILTER_EMA);
+
+	for (int i = 0; i < 10; i++, t_ms += PHASE_INTERVAL_MS) {
+		phase_check_sample(&r, &w, t_ms);
+	}
+	zassert_true(r.phase.locked);
+	zassert_equal(r.lock_losses, 0);
+
+	/* Half a period out: the capture lands on the pulse */
+	w.phase_us += PHASE_PERIOD_50HZ_US / 2;
+	phase_check_sample(&r, &w, t_ms);
+	t_ms += PHASE_INTERVAL_MS;
+	zassert_equal(r.lock_losses, 1, "phase jump: %u losses", r.lock_losses);
+	zassert_true(r.phase.locked, "not relearnt in the same cycle");
+
+	uint32_t full = r.full_bursts;
+
+	for (int i = 0; i < 10; i++, t_ms += PHASE_INTERVAL_MS) {
+		phase_check_sample(&r, &w, t_ms);
+	}
+	zassert_equal(r.lock_losses, 1);
+	zassert_equal(r.full_bursts, full, "relocked after the jump");
+
+	/* Different mains period */
+	w = phase_wave(PHASE_PERIOD_60HZ_US, 3000);
+	for (int i = 0; i < 10; i++, t_ms += PHASE_INTERVAL_MS) {
+		phase_check_sample(&r, &w, t_ms);
+	}
+	zassert_equal(r.lock_losses, 2, "60Hz switch: %u losses", r.lock_losses);
+	zassert_equal(r.phase.period_us, PHASE_PERIOD_60HZ_US);
+	zassert_equal(r.full_bursts, full + 1);
+
+	/* Long gap (sampling stalled): the coasted prediction is not trusted */
+	t_ms += PHASE_MAX_COAST_US / 1000 + PHASE_INTERVAL_MS;
+	full = r.full_bursts;
+	phase_check_sample(&r, &w, t_ms);
+	zassert_equal(r.full_bursts, full + 1, "coasted prediction used");
+	zassert_equal(r.lock_losses, 2);
+}
+
+ZTEST(sense_replay, test_filter_first_sample_and_reset)
+{
+	static const uint8_t kinds[] = {
+		ADC_FILTER_EMA, ADC_FILTER_MEDIAN_EMA, ADC_FILTER_ALPHA_BETA,
+	};
+
+	for (int k = 0; k < ARRAY_SIZE(kinds); k++) {
+		struct adc_filter f = { .kind = kinds[k] };
+
+		zassert_equal(adc_filter_value(&f), -1, "kind %d: value before a sample", k);
+		zassert_equal(adc_filter_update(&f, 2000, 1000), 2000, "kind %d", k);
+
+		for (int i = 1; i < 120; i++) {
+			adc_filter_update(&f, 3000, 1000 + i * 500);
+		}
+		zassert_within(adc_filter_value(&f), 3000, 1, "kind %d: settles on a step", k);
+
+		/* A reset starts again at the next sample, with no lag */
+		adc_filter_reset(&f);
+		zassert_equal(adc_filter_update(&f, 1000, 30000), 1000, "kind %d: after reset", k);
+	}
+}
+
+/* A dial at its 0 V end stop reads slightly negative codes */
+ZTEST(sense_replay, test_filter_negative_code)
+{
+	static const uint8_t kinds[] = {
+		ADC_FILTER_EMA, ADC_FILTER_MEDIAN_EMA, ADC_FILTER_ALPHA_BETA,
+	};
+
+	for (int k = 0; k < ARRAY_SIZE(kinds); k++) {
+		struct adc_filter f = { .kind = kinds[k] };
+
+		zassert_equal(adc_filter_update(&f, -3, 1000), 0, "kind %d: first sample", k);
+		zassert_equal(adc_filter_value(&f), 0, "kind %d", k);
+
+		for (int i = 1; i < 20; i++) {
+			zassert_equal(adc_filter_update(&f, -(i % 4), 1000 + i * 500), 0,
+				      "kind %d: sample %d", k, i);
+		}
+	}
+}
+
+ZTEST(sense_replay, test_median_filter_drops_spike)
+{
+	struct adc_filter f = { .kind = ADC_FILTER_MEDIAN_EMA };
+
+	for (int i = 0; i < 10; i++) {
+		adc_filter_update(&f, 2000, i * 500);
+	}
+	zassert_equal(adc_filter_update(&f, 4000, 5000), 2000, "single spike passed");
+	zassert_equal(adc_filter_update(&f, 2000, 5500), 2000);
+}
+
+/*
+ * Heat from 20°C at 0.3°C/s on the firmware's sampling schedule, lift the
+ * kettle off at HEAT_LIFT_MS and set it back down at HEAT_RETURN_MS. The
+ * state GPIO drops with the lift, which starts a cycle at once as the edge
+ * does in update_kettle_state().
+ */
+#define HEAT_START_TEMP         2000
+#define HEAT_RATE               30      /* 0.01°C/s */
+#define HEAT_LIFT_MS            120000
+#define HEAT_RETURN_MS          130000
+#define HEAT_END_MS             200000
+#define HEAT_RETURN_TEMP        5500    /* cooled a little while lifted */
+
+ZTEST(sense_replay, test_heating_trace_with_lift_off)
+{
+	struct water_replay r;
+	kettle_state_t state = KETTLE_STATE_ON;
+	int64_t t_ms = 1000;
+	int64_t detected_lift_ms = -1;
+	int64_t detected_return_ms = -1;
+	uint32_t interval_ms = 0;
+
+	trace_seed(120);
+	water_replay_init(&r, ADC_FILTER_EMA);
+
+	while (t_ms < HEAT_END_MS) {
+		bool on_base = t_ms < HEAT_LIFT_MS || t_ms >= HEAT_RETURN_MS;
+		int16_t truth = t_ms < HEAT_LIFT_MS ?
+				HEAT_START_TEMP + (int32_t)(t_ms * HEAT_RATE / 1000) :
+				HEAT_RETURN_TEMP;
+		struct ntc_wave w = {
+			.level = on_base ? trace_code_for_temp(truth) : TRACE_OFF_BASE_LEVEL,
+			.amplitude = on_base ? TRACE_PULSE_AMPLITUDE : 0,
+			.period_us = on_base ? TRACE_PULSE_PERIOD_US : 0,
+			.high_us = TRACE_PULSE_HIGH_US,
+			.noise = TRACE_NOISE,
+		};
+		int16_t reading = water_replay_sample(&r, &w, t_ms);
+
+		if (on_base) {
+			zassert_not_equal(reading, TEMP_INVALID_ZB, "%d ms: on base", (int)t_ms);
+		} else {
+			zassert_equal(reading, TEMP_INVALID_ZB, "%d ms: lifted", (int)t_ms);
+		}
+
+		if (t_ms < HEAT_LIFT_MS && t_ms > 10000) {
+			/* EMA lag on the ramp, about three samples */
+			zassert_within(reading, truth, 100, "%d ms: %d vs %d",
+				       (int)t_ms, reading, truth);
+		}
+		if (!on_base && detected_lift_ms < 0) {
+			detected_lift_ms = t_ms;
+		}
+		if (t_ms >= HEAT_RETURN_MS && detected_return_ms < 0) {
+			detected_return_ms = t_ms;
+			/* Filter was reset off base: the first reading is not dragged */
+			zassert_within(reading, truth, 50, "first reading back on base %d", reading);
+		}
+
+		interval_ms = adc_sample_interval_ms(false, state, r.reported, r.water.slope);
+		if (!on_base) {
+			zassert_equal(interval_ms, ADC_INTERVAL_LIFTED_MS, "lifted interval");
+		}
+
+		int64_t next_ms = t_ms + interval_ms;
+
+		if (t_ms < HEAT_LIFT_MS && next_ms >= HEAT_LIFT_MS) {
+			/* Element stops with the lift: the edge samples at once */
+			state = kettle_state_next(state, false);
+			zassert_equal(state, KETTLE_STATE_OFF);
+			next_ms = HEAT_LIFT_MS;
+		}
+		t_ms = next_ms;
+	}
+
+	zassert_equal(detected_lift_ms, HEAT_LIFT_MS, "lift-off seen at %d ms",
+		      (int)detected_lift_ms);
+	zassert_true(detected_return_ms - HEAT_RETURN_MS <= ADC_INTERVAL_LIFTED_MS,
+		     "set back seen %d ms late", (int)(detected_return_ms - HEAT_RETURN_MS));
+
+	/* Off and steady on the base: the slow cycle */
+	zassert_equal(interval_ms, ADC_INTERVAL_IDLE_MS, "interval %u", interval_ms);
+}
+
+ZTEST(sense_replay, test_sample_interval_policy)
+{
+	zassert_equal(adc_sample_interval_ms(true, KETTLE_STATE_ON, 5000, 30),
+		      ADC_INTERVAL_DIAL_MS);
+	zassert_equal(adc_sample_interval_ms(true, KETTLE_STATE_OFF, TEMP_INVALID_ZB, 0),
+		      ADC_INTERVAL_DIAL_MS);
+	zassert_equal(adc_sample_interval_ms(false, KETTLE_STATE_ON, 5000, 30),
+		      ADC_INTERVAL_HEATING_MS);
+	zassert_equal(adc_sample_interval_ms(false, KETTLE_STATE_TURNING_ON, 5000, 0),
+		      ADC_INTERVAL_HEATING_MS);
+	zassert_equal(adc_sample_interval_ms(false, KETTLE_STATE_TURNING_OFF, 5000, 0),
+		      ADC_INTERVAL_HEATING_MS);
+	zassert_equal(adc_sample_interval_ms(false, KETTLE_STATE_OFF, TEMP_INVALID_ZB, 0),
+		      ADC_INTERVAL_LIFTED_MS);
+	zassert_equal(adc_sample_interval_ms(false, KETTLE_STATE_OFF, 8000, -ADC_SLOPE_STEADY),
+		      ADC_SAMPLE_INTERVAL_MS);
+	zassert_equal(adc_sample_interval_ms(false, KETTLE_STATE_OFF, 8000, ADC_SLOPE_STEADY),
+		      ADC_SAMPLE_INTERVAL_MS);
+	zassert_equal(adc_sample_interval_ms(false, KETTLE_STATE_OFF, 8000, ADC_SLOPE_STEADY - 1),
+		      ADC_INTERVAL_IDLE_MS);
+}
+
+ZTEST(sense_replay, test_conversion_range)
+{
+	/* Dial end stops and out of range codes clamp onto the setpoint range */
+	zassert_equal(adc_to_target_temp(&trace_tables, 0), TEMP_MAX_ZB);
+	zassert_equal(adc_to_target_temp(&trace_tables, -5), TEMP_MAX_ZB);
+	zassert_equal(adc_to_target_temp(&trace_tables, ADC_MAX_VALUE), TEMP_MIN_ZB);
+	zassert_equal(adc_to_target_temp(&trace_tables, ADC_MAX_VALUE + 100), TEMP_MIN_ZB);
+
+	/* Below the off-base code the water reads invalid */
+	zassert_equal(adc_to_current_temp(&trace_tables, -1), TEMP_INVALID_ZB);
+	zassert_equal(adc_to_current_temp(&trace_tables, KETTLE_OFF_BASE_CODE - 1),
+		      TEMP_INVALID_ZB);
+	zassert_not_equal(adc_to_current_temp(&trace_tables, KETTLE_OFF_BASE_CODE),
+			  TEMP_INVALID_ZB);
+
+	for (int16_t code = KETTLE_OFF_BASE_CODE + 1; code <= ADC_MAX_VALUE; code++) {
+		zassert_true(adc_to_current_temp(&trace_tables, code) >=
+			     adc_to_current_temp(&trace_tables, code - 1),
+			     "water table not monotonic at %d", code);
+		zassert_true(adc_to_target_temp(&trace_tables, code) <=
+			     adc_to_target_temp(&trace_tables, code - 1),
+			     "dial table not monotonic at %d", code);
+	}
+}
+
+ZTEST_SUITE(sense_replay, NULL, NULL, NULL, NULL, NULL);
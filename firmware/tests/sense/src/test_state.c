@@ -0,0 +1,290 @@
+/*
+ * Copyright (c) 2025
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Kettle state machine: scripted GPIO and command timelines
+ *
+ * Each timeline is a list of steps at absolute times. A step may change
+ * the heating GPIO, issue an on/off command, or neither, and names the
+ * state expected after it. The transition timeout is replayed as
+ * main.c arms it: k_work_schedule() on the kettle's transition_timeout_work,
+ * which keeps a pending deadline, and a cancel when the element follows.
+ * Button sequences are played step by step as the pulse timer plays them.
+ */
+
+#include <errno.h>
+
+#include <zephyr/ztest.h>
+
+#include "kettle_sense.h"
+
+enum step_cmd {
+	CMD_NONE,
+	CMD_ON,
+	CMD_OFF,
+};
+
+#define GPIO_SAME               -1
+
+struct step {
+	uint32_t t_ms;
+	int8_t gpio;                /* new GPIO level, or GPIO_SAME */
+	uint8_t cmd;                /* enum step_cmd */
+	kettle_state_t expect;
+};
+
+struct state_sim {
+	kettle_state_t state;
+	bool gpio;
+	bool timeout_armed;
+	uint32_t deadline_ms;
+};
+
+static void sim_step(struct state_sim *sim, const struct step *s)
+{
+	if (sim->timeout_armed && s->t_ms >= sim->deadline_ms) {
+		sim->timeout_armed = false;
+		sim->state = kettle_state_timeout(sim->state, sim->gpio);
+	}
+
+	if (s->gpio != GPIO_SAME) {
+		kettle_state_t prev = sim->state;
+
+		sim->gpio = s->gpio;
+		sim->state = kettle_state_next(prev, sim->gpio);
+		if (sim->state != prev &&
+		    (prev == KETTLE_STATE_TURNING_ON || prev == KETTLE_STATE_TURNING_OFF)) {
+			sim->timeout_armed = false;
+		}
+	}
+
+	if (s->cmd != CMD_NONE) {
+		kettle_state_t next = kettle_state_command(sim->state, s->cmd == CMD_ON);
+
+		if (next != sim->state) {
+			sim->state = next;
+			if (!sim->timeout_armed) {
+				sim->timeout_armed = true;
+				sim->deadline_ms = s->t_ms + KETTLE_TRANSITION_TIMEOUT_MS;
+			}
+		}
+	}
+}
+
+static void run_timeline(const char *name, const struct step *steps, size_t count)
+{
+	struct state_sim sim = { .state = KETTLE_STATE_OFF };
+
+	for (size_t i = 0; i < count; i++) {
+		sim_step(&sim, &steps[i]);
+		zassert_equal(sim.state, steps[i].expect, "%s, step %u at %u ms: %s, expected %s",
+			      name, (unsigned int)i, steps[i].t_ms, kettle_state_name(sim.state),
+			      kettle_state_name(steps[i].expect));
+	}
+}
+
+#define RUN_TIMELINE(steps) run_timeline(#steps, steps, ARRAY_SIZE(steps))
+
+ZTEST(sense_state, test_transition_table)
+{
+	static const kettle_state_t next[][2] = {
+		/* GPIO low, GPIO high */
+		[KETTLE_STATE_OFF] = { KETTLE_STATE_OFF, KETTLE_STATE_ON },
+		[KETTLE_STATE_TURNING_ON] = { KETTLE_STATE_TURNING_ON, KETTLE_STATE_ON },
+		[KETTLE_STATE_ON] = { KETTLE_STATE_OFF, KETTLE_STATE_ON },
+		[KETTLE_STATE_TURNING_OFF] = { KETTLE_STATE_OFF, KETTLE_STATE_TURNING_OFF },
+	};
+	static const kettle_state_t timeout[][2] = {
+		[KETTLE_STATE_OFF] = { KETTLE_STATE_OFF, KETTLE_STATE_OFF },
+		[KETTLE_STATE_TURNING_ON] = { KETTLE_STATE_OFF, KETTLE_STATE_OFF },
+		[KETTLE_STATE_ON] = { KETTLE_STATE_ON, KETTLE_STATE_ON },
+		[KETTLE_STATE_TURNING_OFF] = { KETTLE_STATE_OFF, KETTLE_STATE_ON },
+	};
+	static const kettle_state_t command[][2] = {
+		/* off, on */
+		[KETTLE_STATE_OFF] = { KETTLE_STATE_OFF, KETTLE_STATE_TURNING_ON },
+		[KETTLE_STATE_TURNING_ON] = { KETTLE_STATE_TURNING_OFF, KETTLE_STATE_TURNING_ON },
+		[KETTLE_STATE_ON] = { KETTLE_STATE_TURNING_OFF, KETTLE_STATE_ON },
+		[KETTLE_STATE_TURNING_OFF] = { KETTLE_STATE_TURNING_OFF, KETTLE_STATE_TURNING_ON },
+	};
+
+	for (int s = 0; s < ARRAY_SIZE(next); s++) {
+		for (int in = 0; in < 2; in++) {
+			zassert_equal(kettle_state_next(s, in), next[s][in],
+				      "%s, GPIO %d", kettle_state_name(s), in);
+			zassert_equal(kettle_state_timeout(s, in), timeout[s][in],
+				      "%s timeout, GPIO %d", kettle_state_name(s), in);
+			zassert_equal(kettle_state_command(s, in), command[s][in],
+				      "%s, command %s", kettle_state_name(s), in ? "on" : "off");
+		}
+	}
+}
+
+ZTEST(sense_state, test_manual_button)
+{
+	static const struct step manual[] = {
+		{     0, GPIO_SAME, CMD_NONE, KETTLE_STATE_OFF },
+		{  1000, 1,         CMD_NONE, KETTLE_STATE_ON },
+		{  1050, 1,         CMD_NONE, KETTLE_STATE_ON },     /* poll, no edge */
+		{ 90000, 0,         CMD_NONE, KETTLE_STATE_OFF },    /* reached temperature */
+	};
+
+	RUN_TIMELINE(manual);
+}
+
+ZTEST(sense_state, test_command_accepted)
+{
+	static const struct step accepted_on[] = {
+		{     0, GPIO_SAME, CMD_ON,   KETTLE_STATE_TURNING_ON },
+		{   200, GPIO_SAME, CMD_NONE, KETTLE_STATE_TURNING_ON }, /* button released */
+		{   350, 1,         CMD_NONE, KETTLE_STATE_ON },
+		{  5000, GPIO_SAME, CMD_NONE, KETTLE_STATE_ON },         /* timeout was cancelled */
+		{ 30000, GPIO_SAME, CMD_OFF,  KETTLE_STATE_TURNING_OFF },
+		{ 30300, 0,         CMD_NONE, KETTLE_STATE_OFF },
+		{ 35000, GPIO_SAME, CMD_NONE, KETTLE_STATE_OFF },
+	};
+
+	RUN_TIMELINE(accepted_on);
+}
+
+ZTEST(sense_state, test_command_declined)
+{
+	/* No water: the element never starts */
+	static const struct step declined[] = {
+		{    0, GPIO_SAME, CMD_ON,   KETTLE_STATE_TURNING_ON },
+		{ 4999, GPIO_SAME, CMD_NONE, KETTLE_STATE_TURNING_ON },
+		{ 5000, GPIO_SAME, CMD_NONE, KETTLE_STATE_OFF },
+	};
+	/* Turn-off not acted on: settles on the element, still heating */
+	static const struct step still_heating[] = {
+		{    0, 1,         CMD_NONE, KETTLE_STATE_ON },
+		{ 1000, GPIO_SAME, CMD_OFF,  KETTLE_STATE_TURNING_OFF },
+		{ 6000, GPIO_SAME, CMD_NONE, KETTLE_STATE_ON },
+	};
+
+	RUN_TIMELINE(declined);
+	RUN_TIMELINE(still_heating);
+}
+
+ZTEST(sense_state, test_repeated_commands)
+{
+	/* A repeated command neither presses again nor extends the timeout */
+	static const struct step repeated[] = {
+		{    0, GPIO_SAME, CMD_ON,   KETTLE_STATE_TURNING_ON },
+		{ 1000, GPIO_SAME, CMD_ON,   KETTLE_STATE_TURNING_ON },
+		{ 5000, GPIO_SAME, CMD_NONE, KETTLE_STATE_OFF },
+		{ 6000, GPIO_SAME, CMD_OFF,  KETTLE_STATE_OFF },
+	};
+	/* Off while turning on presses again; the armed timeout is kept */
+	static const struct step reversed[] = {
+		{    0, GPIO_SAME, CMD_ON,   KETTLE_STATE_TURNING_ON },
+		{ 1000, GPIO_SAME, CMD_OFF,  KETTLE_STATE_TURNING_OFF },
+		{ 4999, GPIO_SAME, CMD_NONE, KETTLE_STATE_TURNING_OFF },
+		{ 5000, GPIO_SAME, CMD_NONE, KETTLE_STATE_OFF },
+	};
+
+	RUN_TIMELINE(repeated);
+	RUN_TIMELINE(reversed);
+}
+
+ZTEST(sense_state, test_lift_off)
+{
+	/* Lifted while heating, then an on command while still off the base */
+	static const struct step lifted[] = {
+		{     0, 1,         CMD_NONE, KETTLE_STATE_ON },
+		{ 30000, 0,         CMD_NONE, KETTLE_STATE_OFF },
+		{ 31000, GPIO_SAME, CMD_ON,   KETTLE_STATE_TURNING_ON },
+		{ 36000, GPIO_SAME, CMD_NONE, KETTLE_STATE_OFF },
+		/* Set back and switched on by hand */
+		{ 40000, 1,         CMD_NONE, KETTLE_STATE_ON },
+	};
+
+	RUN_TIMELINE(lifted);
+}
+
+/* Play a sequence as kettle_pulse_timer_handler() does; edge_ms[] gets the
+ * time of every line change, ending with the release
+ */
+static size_t play_button_seq(struct button_seq *seq, uint32_t *edge_ms, bool *level,
+			      size_t max)
+{
+	uint32_t t_ms = 0;
+	uint32_t hold_ms;
+	bool pressed;
+	size_t edges = 0;
+
+	while (button_seq_step(seq, &pressed, &hold_ms)) {
+		zassert_true(edges < max, "too many edges");
+		edge_ms[edges] = t_ms;
+		level[edges++] = pressed;
+		t_ms += hold_ms;
+	}
+	zassert_true(edges < max, "too many edges");
+	edge_ms[edges] = t_ms;
+	level[edges++] = false;
+	return edges;
+}
+
+ZTEST(sense_state, test_button_sequence)
+{
+	static const uint16_t single[] = { KETTLE_BUTTON_PULSE_MS };
+	static const uint16_t double_press[] = {
+		KETTLE_BUTTON_PULSE_MS, KETTLE_BUTTON_GAP_MS, KETTLE_BUTTON_PULSE_MS,
+	};
+	static const uint32_t single_ms[] = { 0, 200 };
+	static const uint32_t double_ms[] = { 0, 200, 400, 600 };
+	struct button_seq seq;
+	uint32_t edge_ms[KETTLE_BUTTON_SEQ_MAX + 1];
+	bool level[KETTLE_BUTTON_SEQ_MAX + 1];
+	size_t edges;
+
+	zassert_ok(button_seq_load(&seq, single, ARRAY_SIZE(single)));
+	edges = play_button_seq(&seq, edge_ms, level, ARRAY_SIZE(edge_ms));
+	zassert_equal(edges, ARRAY_SIZE(single_ms));
+	for (size_t i = 0; i < edges; i++) {
+		zassert_equal(edge_ms[i], single_ms[i], "single, edge %u", (unsigned int)i);
+		zassert_equal(level[i], !(i & 1), "single, edge %u level", (unsigned int)i);
+	}
+
+	zassert_ok(button_seq_load(&seq, double_press, ARRAY_SIZE(double_press)));
+	edges = play_button_seq(&seq, edge_ms, level, ARRAY_SIZE(edge_ms));
+	zassert_equal(edges, ARRAY_SIZE(double_ms));
+	for (size_t i = 0; i < edges; i++) {
+		zassert_equal(edge_ms[i], double_ms[i], "double, edge %u", (unsigned int)i);
+		zassert_equal(level[i], !(i & 1), "double, edge %u level", (unsigned int)i);
+	}
+
+	/* An ended sequence stays released */
+	bool pressed = true;
+	uint32_t hold_ms = 1;
+
+	zassert_false(button_seq_step(&seq, &pressed, &hold_ms));
+	zassert_false(pressed);
+}
+
+ZTEST(sense_state, test_button_sequence_malformed)
+{
+	static const uint16_t ends_on_gap[] = { 200, 200 };
+	static const uint16_t zero_step[] = { 200, 0, 200 };
+	static const uint16_t too_long[KETTLE_BUTTON_SEQ_MAX + 2] = {
+		200, 200, 200, 200, 200, 200, 200, 200, 200,
+	};
+	static const uint16_t single[] = { KETTLE_BUTTON_PULSE_MS };
+	struct button_seq seq;
+	bool pressed;
+	uint32_t hold_ms;
+
+	zassert_ok(button_seq_load(&seq, single, ARRAY_SIZE(single)));
+	zassert_equal(button_seq_load(&seq, single, 0), -EINVAL);
+	zassert_equal(button_seq_load(&seq, ends_on_gap, ARRAY_SIZE(ends_on_gap)), -EINVAL);
+	zassert_equal(button_seq_load(&seq, zero_step, ARRAY_SIZE(zero_step)), -EINVAL);
+	zassert_equal(button_seq_load(&seq, too_long, ARRAY_SIZE(too_long)), -EINVAL);
+
+	/* A refused sequence leaves the loaded one intact */
+	zassert_true(button_seq_step(&seq, &pressed, &hold_ms));
+	zassert_true(pressed);
+	zassert_equal(hold_ms, KETTLE_BUTTON_PULSE_MS);
+}
+
+ZTEST_SUITE(sense_state, NULL, NULL, NULL, NULL, NULL);
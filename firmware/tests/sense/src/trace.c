@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2025
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/sys/util.h>
+
+#include "trace.h"
+#include "kettle_temp_lut.h"
+
+const struct kettle_temp_tables trace_tables = {
+	.target = kettle_target_temp_lut,
+	.current = kettle_current_temp_lut,
+};
+
+static uint32_t trace_state = 1;
+
+void trace_seed(uint32_t seed)
+{
+	trace_state = seed ? seed : 1;
+}
+
+uint32_t trace_rand(void)
+{
+	trace_state ^= trace_state << 13;
+	trace_state ^= trace_state >> 17;
+	trace_state ^= trace_state << 5;
+	return trace_state;
+}
+
+int16_t trace_noise(uint8_t range)
+{
+	if (range == 0) {
+		return 0;
+	}
+
+	return (int16_t)(trace_rand() % (2 * range + 1)) - range;
+}
+
+void trace_burst(const struct ntc_wave *w, uint32_t start_us, int16_t *samples, uint8_t count)
+{
+	for (uint8_t i = 0; i < count; i++) {
+		uint32_t t_us = start_us + i * BURST_SAMPLE_INTERVAL_US;
+		int32_t v = w->level + trace_noise(w->noise);
+
+		if (w->period_us != 0 &&
+		    (t_us + w->period_us - w->phase_us % w->period_us) % w->period_us < w->high_us) {
+			v += w->amplitude;
+		}
+		samples[i] = CLAMP(v, 0, ADC_MAX_VALUE);
+	}
+}
+
+int16_t trace_code_for_temp(int16_t temp)
+{
+	for (int16_t code = KETTLE_OFF_BASE_CODE; code <= ADC_MAX_VALUE; code++) {
+		if (kettle_current_temp_lut[code] >= temp) {
+			return code;
+		}
+	}
+	return ADC_MAX_VALUE;
+}
+
+void water_replay_init(struct water_replay *r, enum adc_filter_kind kind)
+{
+	*r = (struct water_replay){
+		.water.off_base_code = KETTLE_OFF_BASE_CODE,
+		.water.filter.kind = kind,
+		.reported = TEMP_INVALID_ZB,
+	};
+}
+
+int16_t water_replay_sample(struct water_replay *r, const struct ntc_wave *w, int64_t now_ms)
+{
+	int16_t samples[BURST_SAMPLE_COUNT];
+	uint32_t start_us = (uint32_t)(now_ms * 1000);
+	int16_t adc = -1;
+	int16_t code;
+	int16_t temp;
+
+	/* adc_sample_work_handler(): a lock that coasted too long is dropped */
+	if (r->phase.locked && burst_phase_schedule(&r->phase, start_us) < 0) {
+		r->phase.locked = false;
+	}
+
+	/* adc_cycle_next(): wait for the predicted low window */
+	if (r->phase.locked) {
+		start_us += burst_phase_schedule(&r->phase, start_us);
+		trace_burst(w, start_us, samples, PHASE_LOCKED_SAMPLE_COUNT);
+		r->locked_captures++;
+
+		if (burst_phase_track(&r->phase, samples, start_us, BURST_SAMPLE_INTERVAL_US,
+				      &adc) != 0) {
+			/* burst_done_work_handler(): lock lost, full burst right after */
+			r->lock_losses++;
+			start_us += PHASE_LOCKED_SAMPLE_COUNT * BURST_SAMPLE_INTERVAL_US;
+			adc = -1;
+		}
+	}
+
+	if (adc < 0) {
+		struct burst_stats stats;
+
+		trace_burst(w, start_us, samples, BURST_SAMPLE_COUNT);
+		burst_select(samples, BURST_SAMPLE_COUNT, BURST_PERCENTILE_INDEX, &stats);
+		burst_phase_learn(&r->phase, samples, &stats, start_us, BURST_SAMPLE_INTERVAL_US);
+		r->full_bursts++;
+		adc = stats.low;
+	}
+
+	switch (water_channel_update(&r->water, &trace_tables, adc, now_ms, &code, &temp)) {
+	case WATER_OFF_BASE:
+		r->reported = TEMP_INVALID_ZB;
+		break;
+	case WATER_VALID:
+		r->reported = temp;
+		break;
+	case WATER_INVALID:
+		/* No new reading: the last one stands, as in apply_temperatures() */
+		break;
+	}
+	return r->reported;
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2025
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Synthetic ADC traces for the sensing tests
+ *
+ * The water NTC line of the 5KEK1522 base carries the analog level with a
+ * ~50Hz pulse on top; a burst of BURST_SAMPLE_COUNT conversions every
+ * BURST_SAMPLE_INTERVAL_US spans two periods of it. Traces are generated
+ * from the same tables the firmware converts with, so a reading can be
+ * checked against the temperature it was made from.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H 1
+
+#include <stdint.h>
+
+#include "kettle_sense.h"
+
+/* Built-in tables, generated from calibration/5kek1522.json */
+extern const struct kettle_temp_tables trace_tables;
+
+/* Pulsed NTC waveform */
+struct ntc_wave {
+	int16_t level;              /* true analog level, ADC code */
+	int16_t amplitude;          /* pulse height above the level, codes */
+	uint32_t period_us;         /* pulse period (20000 at 50Hz) */
+	uint32_t high_us;           /* part of each period spent high */
+	uint32_t phase_us;          /* pulse start relative to the trace origin */
+	uint8_t noise;              /* uniform noise, +/- codes */
+};
+
+/* Default pulse: 50Hz, high 60% of the period, +/-3 codes of noise */
+#define TRACE_PULSE_PERIOD_US   20000
+#define TRACE_PULSE_HIGH_US     12000
+#define TRACE_PULSE_AMPLITUDE   600
+#define TRACE_NOISE             3
+
+/* Off base: the NTC junction floats near ground, no pulse */
+#define TRACE_OFF_BASE_LEVEL    40
+
+/** Restart the noise generator, so every test replays the same trace */
+void trace_seed(uint32_t seed);
+
+/** Next pseudo-random number (xorshift32) */
+uint32_t trace_rand(void);
+
+/** Uniform pseudo-random value in [-range, range] */
+int16_t trace_noise(uint8_t range);
+
+/**
+ * Capture a burst of the waveform.
+ *
+ * @param w Waveform
+ * @param start_us Time of the first conversion, relative to the trace origin
+ * @param samples Output conversions
+ * @param count Number of conversions, BURST_SAMPLE_INTERVAL_US apart
+ */
+void trace_burst(const struct ntc_wave *w, uint32_t start_us, int16_t *samples, uint8_t count);
+
+/** Lowest water NTC code that reads at least @p temp (0.01°C) */
+int16_t trace_code_for_temp(int16_t temp);
+
+/* Water channel as the sampling cycle in main.c drives it, sample by sample:
+ * a short capture in the predicted low window while the phase is locked,
+ * a full burst otherwise or when the lock is lost
+ */
+struct water_replay {
+	struct burst_phase phase;
+	struct water_channel water;
+	int16_t reported;           /* last reading, TEMP_INVALID_ZB off base */
+	uint32_t full_bursts;
+	uint32_t locked_captures;
+	uint32_t lock_losses;       /* locked captures that fell back to a full burst */
+};
+
+/** Start a replay with an empty filter of the given kind */
+void water_replay_init(struct water_replay *r, enum adc_filter_kind kind);
+
+/**
+ * Take one firmware sampling cycle of the waveform: a locked capture
+ * through burst_phase_schedule() and burst_phase_track(), or a full burst
+ * through burst_select() and burst_phase_learn(), then
+ * water_channel_update().
+ *
+ * @param r Replay state
+ * @param w Waveform at this instant
+ * @param now_ms Sample time (> 0)
+ * @return Reading, TEMP_INVALID_ZB off base
+ */
+int16_t water_replay_sample(struct water_replay *r, const struct ntc_wave *w, int64_t now_ms);
+
+#endif /* TRACE_H */
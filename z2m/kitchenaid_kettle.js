@@ -3,6 +3,7 @@
  *
  * Installation:
  * 1. Copy this file to your Zigbee2MQTT data folder: data/external_converters/kitchenaid_kettle.js
+ *    (build/firmware/z2m/kitchenaid_kettle.js if CONFIG_KETTLE_MANUF_CODE was changed)
  * 2. Add to configuration.yaml:
  *    external_converters:
  *      - kitchenaid_kettle.js
@@ -13,15 +14,346 @@
  * - current_temperature (numeric): Current water temperature (°C, read-only)
  * - target_temperature (numeric): Target temperature from dial (50-100°C, read-only)
  * - system_mode (enum): Heating mode (off/heat, read-only)
+ * - time_to_setpoint (numeric): Estimated seconds until the water reaches the target (read-only)
+ * - water_ready (enum): Water reached the setpoint or boiling, reported immediately (read-only)
+ * - heating_state (enum): off/starting/heating/stopping; starting/stopping are reported as soon as
+ *   an On/Off command is sent to the kettle, state follows once the kettle confirms (read-only)
+ * - calibration (enum): Field calibration actions (start, capture_*, finish, cancel, reset)
+ * - calibration_state (enum): Calibration session state (read-only)
+ * - calibration_points (text): Calibration points in use (read-only)
+ * - ambient_reference / boil_reference (numeric): Reference temperatures for the captures
+ * - history (enum): Read the on-device temperature/state history (~16 minutes at 1 Hz);
+ *   published as history_samples [{time, temperature, heating, ready}]
+ * - stream_interval (numeric): Seconds between telemetry stream frames while heating, 0 = off;
+ *   each frame is published as stream_samples [{time, temperature}]
+ * - diagnostics (enum): Read or reset the on-device timing histograms; read publishes
+ *   diagnostics {metric: {samples, max_us, p50_us, p95_us, buckets}, counter: value}
+ *
+ * A device with several kettles (one endpoint per kitchenaid,kettle devicetree node) exposes
+ * every entity except diagnostics once per kettle, suffixed with its endpoint name: _l1 for
+ * the lowest kettle endpoint, _l2 for the next, and so on. A single kettle keeps the plain keys.
+ *
+ * Reports that repeat the last value are not republished. `get` requests are answered
+ * from values received within read_cache_max_age seconds (device option, default 60);
+ * otherwise the key is read together with every stale key of its cluster.
  */
 
 const fz = require('zigbee-herdsman-converters/converters/fromZigbee');
 const tz = require('zigbee-herdsman-converters/converters/toZigbee');
 const exposes = require('zigbee-herdsman-converters/lib/exposes');
 const reporting = require('zigbee-herdsman-converters/lib/reporting');
+const m = require('zigbee-herdsman-converters/lib/modernExtend');
+const {Zcl} = require('zigbee-herdsman');
 const e = exposes.presets;
 const ea = exposes.access;
 
+// Manufacturer-specific attributes (see firmware/include/zb_kettle.h). The
+// firmware build writes a copy of this file with CONFIG_KETTLE_MANUF_CODE
+// filled in to build/firmware/z2m/kitchenaid_kettle.js; install that one.
+const KETTLE_MANUF_CODE = 0x1234;
+const ATTR_TIME_TO_SETPOINT = 0x4000; // hvacThermostat, uint16 seconds, 0xFFFF = unknown
+
+// Manufacturer-specific Kettle cluster (field calibration)
+const CLUSTER_KETTLE = 'manuSpecificKettle';
+const CALIBRATION_POINTS = ['ambient', 'boil', 'dial_max', 'dial_min'];
+const CALIBRATION_ACTIONS = [
+    'start', ...CALIBRATION_POINTS.map((p) => `capture_${p}`), 'finish', 'cancel', 'reset',
+];
+const REFERENCE_DEFAULT = -0x8000; // capture with the stored reference attribute
+const WATER_READY = ['no', 'setpoint', 'boiling'];
+const HEATING_STATE = ['off', 'starting', 'heating', 'stopping'];
+
+const kettleCluster = m.deviceAddCustomCluster(CLUSTER_KETTLE, {
+    ID: 0xFC00,
+    manufacturerCode: KETTLE_MANUF_CODE,
+    attributes: {
+        calibrationState: {ID: 0x0000, type: Zcl.DataType.ENUM8},
+        calibrationPoints: {ID: 0x0001, type: Zcl.DataType.BITMAP8},
+        ambientReference: {ID: 0x0002, type: Zcl.DataType.INT16},
+        boilReference: {ID: 0x0003, type: Zcl.DataType.INT16},
+        waterReady: {ID: 0x0004, type: Zcl.DataType.ENUM8},
+        streamInterval: {ID: 0x0005, type: Zcl.DataType.UINT16},
+        heatingState: {ID: 0x0006, type: Zcl.DataType.ENUM8},
+    },
+    commands: {
+        calibrationStart: {ID: 0x00, parameters: []},
+        calibrationCapture: {ID: 0x01, parameters: [
+            {name: 'point', type: Zcl.DataType.UINT8},
+            {name: 'reference', type: Zcl.DataType.INT16},
+        ]},
+        calibrationFinish: {ID: 0x02, parameters: []},
+        calibrationCancel: {ID: 0x03, parameters: []},
+        calibrationReset: {ID: 0x04, parameters: []},
+        historyRead: {ID: 0x05, response: 0x00, parameters: [
+            {name: 'position', type: Zcl.DataType.UINT32},
+        ]},
+    },
+    commandsResponse: {
+        historyData: {ID: 0x00, parameters: [
+            {name: 'start', type: Zcl.DataType.UINT32},
+            {name: 'tail', type: Zcl.DataType.UINT32},
+            {name: 'head', type: Zcl.DataType.UINT32},
+            {name: 'base', type: Zcl.DataType.INT16},
+            {name: 'newestAge', type: Zcl.DataType.UINT16},
+            {name: 'data', type: Zcl.DataType.OCTET_STR},
+        ]},
+        streamData: {ID: 0x01, parameters: [
+            {name: 'count', type: Zcl.DataType.UINT8},
+            {name: 'newestAge', type: Zcl.DataType.UINT16},
+            {name: 'data', type: Zcl.DataType.OCTET_STR},
+        ]},
+    },
+});
+
+// Manufacturer-specific Diagnostics cluster (timing histograms)
+const CLUSTER_DIAGNOSTICS = 'manuSpecificKettleDiagnostics';
+const DIAG_METRICS = {
+    burst: 'diagBurst',
+    update_temperatures: 'diagUpdateTemperatures',
+    workqueue_latency: 'diagWorkqueueLatency',
+    edge_to_report: 'diagEdgeToReport',
+    buffer_acquire: 'diagBufferAcquire',
+    aps_round_trip: 'diagApsRoundTrip',
+};
+// Buffer pool and routing load counters
+const DIAG_COUNTERS = {
+    alloc_failures: 'diagAllocFailures',
+    retried: 'diagRetried',
+    deferred: 'diagDeferred',
+    dropped: 'diagDropped',
+    aps_failures: 'diagApsFailures',
+    pool_low: 'diagPoolLow',
+    pool_oom: 'diagPoolOom',
+    in_flight_max: 'diagInFlightMax',
+    ota_progress: 'diagOtaProgress',
+    ota_offset: 'diagOtaOffset',
+    ota_throughput: 'diagOtaThroughput',
+    ota_block_period: 'diagOtaBlockPeriod',
+};
+const DIAG_HIST_MIN_SHIFT = 4;
+
+const diagnosticsCluster = m.deviceAddCustomCluster(CLUSTER_DIAGNOSTICS, {
+    ID: 0xFC01,
+    manufacturerCode: KETTLE_MANUF_CODE,
+    attributes: {
+        diagBurst: {ID: 0x0000, type: Zcl.DataType.OCTET_STR},
+        diagUpdateTemperatures: {ID: 0x0001, type: Zcl.DataType.OCTET_STR},
+        diagWorkqueueLatency: {ID: 0x0002, type: Zcl.DataType.OCTET_STR},
+        diagEdgeToReport: {ID: 0x0003, type: Zcl.DataType.OCTET_STR},
+        diagBufferAcquire: {ID: 0x0004, type: Zcl.DataType.OCTET_STR},
+        diagApsRoundTrip: {ID: 0x0005, type: Zcl.DataType.OCTET_STR},
+        diagAllocFailures: {ID: 0x0010, type: Zcl.DataType.UINT32},
+        diagRetried: {ID: 0x0011, type: Zcl.DataType.UINT32},
+        diagDeferred: {ID: 0x0012, type: Zcl.DataType.UINT32},
+        diagDropped: {ID: 0x0013, type: Zcl.DataType.UINT32},
+        diagApsFailures: {ID: 0x0014, type: Zcl.DataType.UINT32},
+        diagPoolLow: {ID: 0x0015, type: Zcl.DataType.UINT32},
+        diagPoolOom: {ID: 0x0016, type: Zcl.DataType.UINT32},
+        diagInFlightMax: {ID: 0x0017, type: Zcl.DataType.UINT8},
+        diagOtaProgress: {ID: 0x0020, type: Zcl.DataType.UINT8},
+        diagOtaOffset: {ID: 0x0021, type: Zcl.DataType.UINT32},
+        diagOtaThroughput: {ID: 0x0022, type: Zcl.DataType.UINT16},
+        diagOtaBlockPeriod: {ID: 0x0023, type: Zcl.DataType.UINT16},
+    },
+    commands: {
+        reset: {ID: 0x00, parameters: []},
+    },
+    commandsResponse: {},
+});
+
+// Decode a histogram attribute: U32 max us, then U16 log2 bucket counts
+const decodeHistogram = (bytes) => {
+    const buf = Buffer.from(bytes);
+    if (buf.length < 4) return null;
+    const buckets = [];
+    for (let i = 4; i + 1 < buf.length; i += 2) buckets.push(buf.readUInt16LE(i));
+    const samples = buckets.reduce((a, b) => a + b, 0);
+    // Upper bound of the bucket holding the given fraction of samples
+    const percentile = (p) => {
+        let seen = 0;
+        for (let b = 0; b < buckets.length; b++) {
+            seen += buckets[b];
+            if (samples && seen >= p * samples) return 2 ** (b + DIAG_HIST_MIN_SHIFT);
+        }
+        return null;
+    };
+    return {samples, max_us: buf.readUInt32LE(0), p50_us: percentile(0.5), p95_us: percentile(0.95), buckets};
+};
+
+// ZCL invalid temperature (0x8000); herdsman decodes int16 attributes as signed
+const isValidTemp = (temp) => temp !== -0x8000 && temp !== 0x8000;
+
+// History records (see History in firmware/src/main.c)
+const HISTORY_KEYFRAME = 0x80;
+const HISTORY_MAX_CHUNKS = 64;
+
+// Decode history bytes into samples, oldest first, with times relative to the newest
+const decodeHistory = (bytes, base) => {
+    const samples = [];
+    let temp = isValidTemp(base) ? base : null;
+    let offset = 0;
+    for (let i = 0; i + 1 < bytes.length;) {
+        const meta = bytes[i + 1];
+        if (bytes[i] === HISTORY_KEYFRAME) {
+            if (i + 3 >= bytes.length) break;
+            const abs = bytes.readInt16LE(i + 2);
+            temp = isValidTemp(abs) ? abs : null;
+            i += 4;
+        } else {
+            if (temp !== null) temp += (bytes[i] << 24) >> 24;
+            i += 2;
+        }
+        offset += meta & 0x3F;
+        samples.push({
+            offset,
+            temperature: temp === null ? null : temp / 100,
+            heating: (meta & 0x40) !== 0,
+            ready: (meta & 0x80) !== 0,
+        });
+    }
+    return samples.map((s) => ({...s, offset: offset - s.offset}));
+};
+
+// Telemetry stream (see Telemetry Stream in firmware/src/main.c)
+const STREAM_TICK_MS = 10;
+
+const readVarint = (bytes, pos) => {
+    let value = 0;
+    let shift = 0;
+    while (pos.i < bytes.length) {
+        const b = bytes[pos.i++];
+        value += (b & 0x7F) * 2 ** shift;
+        if (!(b & 0x80)) return value;
+        shift += 7;
+    }
+    return null;
+};
+
+// Decode a stream frame into samples, oldest first, with times relative to the first
+const decodeStream = (bytes, count) => {
+    const samples = [];
+    const pos = {i: 0};
+    let temp = 0;
+    let ms = 0;
+    while (samples.length < count) {
+        const zigzag = readVarint(bytes, pos);
+        const ticks = readVarint(bytes, pos);
+        if (zigzag === null || ticks === null) break;
+        temp += zigzag % 2 ? -(zigzag + 1) / 2 : zigzag / 2;
+        ms += ticks * STREAM_TICK_MS;
+        samples.push({ms, temperature: temp / 100});
+    }
+    return samples;
+};
+
+// Kettle endpoints of a device, lowest first: every endpoint serving On/Off,
+// which leaves out the OTA endpoint
+const kettleEndpoints = (device) => device.endpoints
+    .filter((ep) => ep.supportsInputCluster('genOnOff'))
+    .sort((a, b) => a.ID - b.ID);
+
+// Endpoint names l1, l2, ... of a device with several kettles; none with one
+// kettle, so its keys stay unsuffixed
+const kettleEndpointMap = (device) => {
+    const endpoints = kettleEndpoints(device);
+    if (endpoints.length < 2) return {};
+    return Object.fromEntries(endpoints.map((ep, i) => [`l${i + 1}`, ep.ID]));
+};
+
+// Published name of a key for the kettle on the given endpoint
+const endpointKey = (device, endpointID, key) => {
+    const map = kettleEndpointMap(device);
+    const name = Object.keys(map).find((n) => map[n] === endpointID);
+    return name ? `${key}_${name}` : key;
+};
+
+// State cache: last value and arrival time of each key, per device and
+// kettle endpoint. Reports that repeat the cached value are not republished
+// (the firmware sends the water temperature on both hvacThermostat and
+// msTemperatureMeasurement unless it aliases localTemperature), and `get`
+// requests are answered from it while fresh.
+const READ_CACHE_MAX_AGE_S = 60;
+const stateCache = new Map();
+
+const endpointCache = (device, endpointID) => {
+    const id = `${device.ieeeAddr}/${endpointID}`;
+    let cache = stateCache.get(id);
+    if (!cache) {
+        cache = {};
+        stateCache.set(id, cache);
+    }
+    return cache;
+};
+
+// Cache a converted payload; returns the keys to publish, suffixed with the
+// kettle's endpoint name, or undefined for none. Read responses are always
+// published in full: somebody asked for them.
+const publishChanged = (msg, meta, result) => {
+    if (!result || !meta || !meta.device) return result;
+    const cache = endpointCache(meta.device, msg.endpoint.ID);
+    const now = Date.now();
+    const changed = {};
+    for (const [key, value] of Object.entries(result)) {
+        if (msg.type === 'readResponse' || !cache[key] || cache[key].value !== value) {
+            changed[endpointKey(meta.device, msg.endpoint.ID, key)] = value;
+        }
+        cache[key] = {value, time: now};
+    }
+    return Object.keys(changed).length ? changed : undefined;
+};
+
+// Attribute behind each key that can be read; keys on the same cluster and
+// manufacturer code are read together
+const READS = {
+    state: {cluster: 'genOnOff', attr: 'onOff'},
+    target_temperature: {cluster: 'hvacThermostat', attr: 'occupiedHeatingSetpoint'},
+    system_mode: {cluster: 'hvacThermostat', attr: 'systemMode'},
+    time_to_setpoint: {cluster: 'hvacThermostat', attr: ATTR_TIME_TO_SETPOINT, manufacturerCode: KETTLE_MANUF_CODE},
+    current_temperature: {cluster: 'msTemperatureMeasurement', attr: 'measuredValue'},
+    calibration_state: {cluster: CLUSTER_KETTLE, attr: 'calibrationState'},
+    calibration_points: {cluster: CLUSTER_KETTLE, attr: 'calibrationPoints'},
+    ambient_reference: {cluster: CLUSTER_KETTLE, attr: 'ambientReference'},
+    boil_reference: {cluster: CLUSTER_KETTLE, attr: 'boilReference'},
+    water_ready: {cluster: CLUSTER_KETTLE, attr: 'waterReady'},
+    stream_interval: {cluster: CLUSTER_KETTLE, attr: 'streamInterval'},
+    heating_state: {cluster: CLUSTER_KETTLE, attr: 'heatingState'},
+};
+
+const isFresh = (entry, maxAgeMs) => entry !== undefined && Date.now() - entry.time < maxAgeMs;
+
+// Answer a `get` from the cache, or read the key together with every other
+// stale key of its cluster in one frame
+const readCached = async (entity, key, meta) => {
+    const spec = READS[key];
+    const opts = spec.manufacturerCode ? {manufacturerCode: spec.manufacturerCode} : {};
+    if (!meta.device) {
+        await entity.read(spec.cluster, [spec.attr], opts);
+        return;
+    }
+
+    const cache = endpointCache(meta.device, entity.ID);
+    const option = meta.options && meta.options.read_cache_max_age;
+    const maxAgeMs = (option === undefined ? READ_CACHE_MAX_AGE_S : option) * 1000;
+    if (typeof meta.publish === 'function' && isFresh(cache[key], maxAgeMs)) {
+        meta.publish({[endpointKey(meta.device, entity.ID, key)]: cache[key].value});
+        return;
+    }
+
+    const attrs = Object.entries(READS)
+        .filter(([k, s]) => s.cluster === spec.cluster && s.manufacturerCode === spec.manufacturerCode &&
+            (k === key || !isFresh(cache[k], maxAgeMs)))
+        .map(([k, s]) => s.attr);
+    const data = await entity.read(spec.cluster, [...new Set(attrs)], opts);
+
+    // Cache the response now, so the next key of a multi-key get finds it
+    // even if the readResponse message has not been converted yet
+    const converter = Object.values(fzLocal).find((c) => c.cluster === spec.cluster &&
+        c.type.includes('readResponse'));
+    if (data && converter) {
+        converter.convert(null, {type: 'readResponse', data, endpoint: entity}, () => {}, meta.options, meta);
+    }
+};
+
 // Custom fromZigbee converters
 const fzLocal = {
     kettle_on_off: {
@@ -29,7 +361,7 @@ const fzLocal = {
         type: ['attributeReport', 'readResponse'],
         convert: (model, msg, publish, options, meta) => {
             if (msg.data.hasOwnProperty('onOff')) {
-                return {state: msg.data['onOff'] ? 'ON' : 'OFF'};
+                return publishChanged(msg, meta, {state: msg.data['onOff'] ? 'ON' : 'OFF'});
             }
         },
     },
@@ -40,12 +372,11 @@ const fzLocal = {
         convert: (model, msg, publish, options, meta) => {
             const result = {};
 
-            // Local temperature (current water temperature)
-            if (msg.data.hasOwnProperty('localTemp')) {
-                const temp = msg.data['localTemp'];
-                if (temp !== 0x8000) { // 0x8000 = invalid/unknown
-                    result.current_temperature = temp / 100;
-                }
+            // Local temperature carries the same sample as measuredValue; the
+            // cache drops whichever of the two frames arrives second
+            if (msg.data.hasOwnProperty('localTemperature')) {
+                const temp = msg.data['localTemperature'];
+                result.current_temperature = isValidTemp(temp) ? temp / 100 : null;
             }
 
             // Occupied heating setpoint (target temperature)
@@ -59,7 +390,13 @@ const fzLocal = {
                 result.system_mode = mode === 4 ? 'heat' : 'off';
             }
 
-            return result;
+            // Time to setpoint (manufacturer-specific, estimated on the device)
+            if (msg.data.hasOwnProperty(ATTR_TIME_TO_SETPOINT)) {
+                const seconds = msg.data[ATTR_TIME_TO_SETPOINT];
+                result.time_to_setpoint = seconds === 0xFFFF ? null : seconds;
+            }
+
+            return publishChanged(msg, meta, result);
         },
     },
 
@@ -69,10 +406,77 @@ const fzLocal = {
         convert: (model, msg, publish, options, meta) => {
             if (msg.data.hasOwnProperty('measuredValue')) {
                 const temp = msg.data['measuredValue'];
-                if (temp !== 0x8000) {
-                    return {current_temperature: temp / 100};
+                return publishChanged(msg, meta, {current_temperature: isValidTemp(temp) ? temp / 100 : null});
+            }
+        },
+    },
+
+    kettle_cluster: {
+        cluster: CLUSTER_KETTLE,
+        type: ['attributeReport', 'readResponse'],
+        convert: (model, msg, publish, options, meta) => {
+            const result = {};
+            if (msg.data.hasOwnProperty('calibrationState')) {
+                result.calibration_state = msg.data['calibrationState'] === 1 ? 'active' : 'idle';
+            }
+            if (msg.data.hasOwnProperty('calibrationPoints')) {
+                const points = CALIBRATION_POINTS.filter((p, i) => msg.data['calibrationPoints'] & (1 << i));
+                result.calibration_points = points.length ? points.join(',') : 'none';
+            }
+            if (msg.data.hasOwnProperty('ambientReference')) {
+                result.ambient_reference = msg.data['ambientReference'] / 100;
+            }
+            if (msg.data.hasOwnProperty('boilReference')) {
+                result.boil_reference = msg.data['boilReference'] / 100;
+            }
+            if (msg.data.hasOwnProperty('waterReady')) {
+                result.water_ready = WATER_READY[msg.data['waterReady']] || 'no';
+            }
+            if (msg.data.hasOwnProperty('streamInterval')) {
+                result.stream_interval = msg.data['streamInterval'];
+            }
+            if (msg.data.hasOwnProperty('heatingState')) {
+                result.heating_state = HEATING_STATE[msg.data['heatingState']] || 'off';
+            }
+            return publishChanged(msg, meta, result);
+        },
+    },
+
+    kettle_stream: {
+        cluster: CLUSTER_KETTLE,
+        type: ['commandStreamData'],
+        convert: (model, msg, publish, options, meta) => {
+            const samples = decodeStream(Buffer.from(msg.data.data), msg.data.count);
+            if (samples.length === 0) return;
+            const newest = Date.now() - msg.data.newestAge;
+            const last = samples[samples.length - 1].ms;
+            const key = meta && meta.device ? endpointKey(meta.device, msg.endpoint.ID, 'stream_samples') :
+                'stream_samples';
+            return {
+                [key]: samples.map((s) => ({
+                    time: new Date(newest - (last - s.ms)).toISOString(),
+                    temperature: s.temperature,
+                })),
+            };
+        },
+    },
+
+    kettle_diagnostics: {
+        cluster: CLUSTER_DIAGNOSTICS,
+        type: ['attributeReport', 'readResponse'],
+        convert: (model, msg, publish, options, meta) => {
+            const diagnostics = {...(meta.state && meta.state.diagnostics)};
+            for (const [metric, attr] of Object.entries(DIAG_METRICS)) {
+                if (msg.data.hasOwnProperty(attr)) {
+                    diagnostics[metric] = decodeHistogram(msg.data[attr]);
                 }
             }
+            for (const [counter, attr] of Object.entries(DIAG_COUNTERS)) {
+                if (msg.data.hasOwnProperty(attr)) {
+                    diagnostics[counter] = msg.data[attr];
+                }
+            }
+            return {diagnostics};
         },
     },
 };
@@ -88,12 +492,183 @@ const tzLocal = {
             return {};
         },
         convertGet: async (entity, key, meta) => {
-            await entity.read('genOnOff', ['onOff']);
+            await readCached(entity, key, meta);
+        },
+    },
+
+    kettle_calibration: {
+        key: ['calibration'],
+        convertSet: async (entity, key, value, meta) => {
+            if (value.startsWith('capture_')) {
+                await entity.command(CLUSTER_KETTLE, 'calibrationCapture', {
+                    point: CALIBRATION_POINTS.indexOf(value.slice('capture_'.length)),
+                    reference: REFERENCE_DEFAULT,
+                });
+            } else {
+                const command = `calibration${value.charAt(0).toUpperCase()}${value.slice(1)}`;
+                await entity.command(CLUSTER_KETTLE, command, {});
+            }
+            await entity.read(CLUSTER_KETTLE, ['calibrationState', 'calibrationPoints']);
+            return {};
+        },
+    },
+
+    kettle_calibration_reference: {
+        key: ['ambient_reference', 'boil_reference'],
+        convertSet: async (entity, key, value, meta) => {
+            const attr = key === 'ambient_reference' ? 'ambientReference' : 'boilReference';
+            await entity.write(CLUSTER_KETTLE, {[attr]: Math.round(value * 100)});
+            return {state: {[key]: value}};
+        },
+        convertGet: async (entity, key, meta) => {
+            await readCached(entity, key, meta);
+        },
+    },
+
+    kettle_stream_interval: {
+        key: ['stream_interval'],
+        convertSet: async (entity, key, value, meta) => {
+            await entity.write(CLUSTER_KETTLE, {streamInterval: Math.round(value)});
+            return {state: {stream_interval: value}};
+        },
+        convertGet: async (entity, key, meta) => {
+            await readCached(entity, key, meta);
+        },
+    },
+
+    kettle_readings: {
+        key: ['current_temperature', 'target_temperature', 'system_mode', 'time_to_setpoint',
+            'water_ready', 'heating_state', 'calibration_state', 'calibration_points'],
+        convertGet: async (entity, key, meta) => {
+            await readCached(entity, key, meta);
         },
     },
 
+    kettle_diagnostics: {
+        key: ['diagnostics'],
+        convertSet: async (entity, key, value, meta) => {
+            if (value === 'reset') {
+                await entity.command(CLUSTER_DIAGNOSTICS, 'reset', {});
+            }
+            // One attribute per read: each histogram fills most of a frame
+            for (const attr of Object.values(DIAG_METRICS)) {
+                await entity.read(CLUSTER_DIAGNOSTICS, [attr]);
+            }
+            await entity.read(CLUSTER_DIAGNOSTICS, Object.values(DIAG_COUNTERS));
+            return {};
+        },
+    },
+
+    kettle_history: {
+        key: ['history'],
+        convertSet: async (entity, key, value, meta) => {
+            let chunks = [];
+            let first = null;
+            let last = null;
+            let position = 0;
+            for (let n = 0; n < HISTORY_MAX_CHUNKS; n++) {
+                const rsp = await entity.command(CLUSTER_KETTLE, 'historyRead', {position});
+                if (first !== null && rsp.start !== position) {
+                    // Oldest records evicted while reading; start over from the new tail
+                    chunks = [];
+                    first = null;
+                }
+                if (first === null) first = rsp;
+                last = rsp;
+                const data = Buffer.from(rsp.data);
+                chunks.push(data);
+                position = rsp.start + data.length;
+                if (data.length === 0 || position === rsp.head) break;
+            }
+            if (first === null) return {};
+
+            // Newest record was newestAge seconds ago; offsets count back from it
+            const newest = Date.now() - last.newestAge * 1000;
+            const samples = decodeHistory(Buffer.concat(chunks), first.base).map((s) => ({
+                time: new Date(newest - s.offset * 1000).toISOString(),
+                temperature: s.temperature,
+                heating: s.heating,
+                ready: s.ready,
+            }));
+            return {state: {history_samples: samples}};
+        },
+    },
 };
 
+// Entities of one kettle; a new set per call, as withEndpoint() changes them
+const kettleExposes = () => [
+    // Kettle on/off state (controllable - sends command, reports actual state)
+    e.binary('state', ea.ALL, 'ON', 'OFF')
+        .withDescription('Kettle heating state'),
+
+    // Current water temperature
+    e.numeric('current_temperature', ea.STATE_GET)
+        .withUnit('°C')
+        .withValueMin(0)
+        .withValueMax(100)
+        .withDescription('Current water temperature'),
+
+    // Target temperature setpoint (read-only, set by physical dial)
+    e.numeric('target_temperature', ea.STATE_GET)
+        .withUnit('°C')
+        .withValueMin(50)
+        .withValueMax(100)
+        .withDescription('Target temperature from dial'),
+
+    // System mode (reflects kettle state)
+    e.enum('system_mode', ea.STATE_GET, ['off', 'heat'])
+        .withDescription('Heating system mode'),
+
+    // Time to setpoint (estimated by the device while heating)
+    e.numeric('time_to_setpoint', ea.STATE_GET)
+        .withUnit('s')
+        .withValueMin(0)
+        .withDescription('Estimated time until the water reaches the target temperature'),
+
+    // Water ready (plateau/setpoint detection on the device)
+    e.enum('water_ready', ea.STATE_GET, WATER_READY)
+        .withDescription('Water reached the target temperature or is boiling'),
+
+    // Heating state including the pending transition after an On/Off command
+    e.enum('heating_state', ea.STATE_GET, HEATING_STATE)
+        .withDescription('Kettle heating state; starting/stopping while waiting for the kettle to follow a command'),
+
+    // Field calibration (start, capture reference points, finish)
+    e.enum('calibration', ea.SET, CALIBRATION_ACTIONS)
+        .withDescription('Calibration action: capture ambient and boil with the water at the reference temperatures, dial points with the dial at its end stops'),
+    e.enum('calibration_state', ea.STATE_GET, ['idle', 'active'])
+        .withDescription('Calibration session state'),
+    e.text('calibration_points', ea.STATE_GET)
+        .withDescription('Calibration points in use'),
+    e.numeric('ambient_reference', ea.ALL)
+        .withUnit('°C')
+        .withValueMin(0)
+        .withValueMax(100)
+        .withValueStep(0.1)
+        .withDescription('Reference temperature for the ambient capture'),
+    e.numeric('boil_reference', ea.ALL)
+        .withUnit('°C')
+        .withValueMin(0)
+        .withValueMax(100)
+        .withValueStep(0.1)
+        .withDescription('Reference temperature for the boil capture (lower at altitude)'),
+
+    // On-device history readout (published as history_samples)
+    e.enum('history', ea.SET, ['read'])
+        .withDescription('Read the temperature and state history recorded by the kettle'),
+
+    // Telemetry stream (published as stream_samples while heating)
+    e.numeric('stream_interval', ea.ALL)
+        .withUnit('s')
+        .withValueMin(0)
+        .withValueMax(60)
+        .withDescription('Send every filtered temperature sample in batches this often while heating (0 = off)'),
+];
+
+// Timing diagnostics (published as diagnostics), device-wide
+const diagnosticsExpose = () => e.enum('diagnostics', ea.SET, ['read', 'reset'])
+    .withDescription('Read (or reset and read) the on-device timing histograms');
+
 const definition = {
     zigbeeModel: ['5KEK1522-ZB'],
     model: '5KEK1522-ZB',
@@ -104,64 +679,80 @@ const definition = {
         fzLocal.kettle_on_off,
         fzLocal.kettle_thermostat,
         fzLocal.kettle_temperature_measurement,
+        fzLocal.kettle_cluster,
+        fzLocal.kettle_stream,
+        fzLocal.kettle_diagnostics,
         fz.identify,
     ],
     toZigbee: [
         tzLocal.kettle_on_off,
+        tzLocal.kettle_calibration,
+        tzLocal.kettle_calibration_reference,
+        tzLocal.kettle_history,
+        tzLocal.kettle_stream_interval,
+        tzLocal.kettle_readings,
+        tzLocal.kettle_diagnostics,
         tz.identify,
     ],
-    exposes: [
-        // Kettle on/off state (controllable - sends command, reports actual state)
-        e.binary('state', ea.ALL, 'ON', 'OFF')
-            .withDescription('Kettle heating state'),
-
-        // Current water temperature
-        e.numeric('current_temperature', ea.STATE)
-            .withUnit('°C')
+    exposes: (device, options) => {
+        // One set per kettle endpoint, or a plain set for a single kettle
+        const names = device ? Object.keys(kettleEndpointMap(device)) : [];
+        const kettles = names.length ?
+            names.flatMap((name) => kettleExposes().map((expose) => expose.withEndpoint(name))) :
+            kettleExposes();
+        return [...kettles, diagnosticsExpose()];
+    },
+    options: [
+        e.numeric('read_cache_max_age', ea.SET)
+            .withUnit('s')
             .withValueMin(0)
-            .withValueMax(100)
-            .withDescription('Current water temperature'),
-
-        // Target temperature setpoint (read-only, set by physical dial)
-        e.numeric('target_temperature', ea.STATE)
-            .withUnit('°C')
-            .withValueMin(50)
-            .withValueMax(100)
-            .withDescription('Target temperature from dial'),
-
-        // System mode (reflects kettle state)
-        e.enum('system_mode', ea.STATE, ['off', 'heat'])
-            .withDescription('Heating system mode'),
+            .withDescription(`Answer get requests from values received within this many seconds instead of ` +
+                `reading the kettle (default ${READ_CACHE_MAX_AGE_S}, 0 = always read)`),
     ],
+    extend: [kettleCluster, diagnosticsCluster],
+    endpoint: kettleEndpointMap,
     configure: async (device, coordinatorEndpoint, logger) => {
-        const endpoint = device.getEndpoint(1);
-
-        // Bind clusters for reporting
-        await reporting.bind(endpoint, coordinatorEndpoint, [
-            'genOnOff',
-            'hvacThermostat',
-            'msTemperatureMeasurement',
-        ]);
-
-        // Configure reporting for on/off state
-        await reporting.onOff(endpoint);
-
-        // Note: Thermostat and temperature reporting is handled internally by the
-        // firmware via zb_zcl_mark_attr_for_reporting() - configureReporting would
-        // fail with UNREPORTABLE_ATTRIBUTE since the attributes don't have the
-        // reportable flag set in the ZCL layer.
-
-        // Read initial values
-        await endpoint.read('genOnOff', ['onOff']);
-        await endpoint.read('hvacThermostat', [
-            'localTemp',
-            'occupiedHeatingSetpoint',
-            'systemMode',
-        ]);
-        await endpoint.read('msTemperatureMeasurement', ['measuredValue']);
+        for (const endpoint of kettleEndpoints(device)) {
+            // Bind clusters for reporting (the firmware reports through its binding
+            // table, so other bound devices and groups get the same frames)
+            await reporting.bind(endpoint, coordinatorEndpoint, [
+                'genOnOff',
+                'hvacThermostat',
+                'msTemperatureMeasurement',
+                CLUSTER_KETTLE,
+            ]);
+
+            // Configure reporting for on/off state
+            await reporting.onOff(endpoint);
+
+            // Note: Thermostat and temperature reporting is handled internally by the
+            // firmware via zb_zcl_mark_attr_for_reporting() - configureReporting would
+            // fail with UNREPORTABLE_ATTRIBUTE since the attributes don't have the
+            // reportable flag set in the ZCL layer.
+
+            // Read initial values
+            await endpoint.read('genOnOff', ['onOff']);
+            await endpoint.read('hvacThermostat', [
+                'occupiedHeatingSetpoint',
+                'systemMode',
+            ]);
+            await endpoint.read('msTemperatureMeasurement', ['measuredValue']);
+            await endpoint.read('hvacThermostat', [ATTR_TIME_TO_SETPOINT],
+                {manufacturerCode: KETTLE_MANUF_CODE});
+            await endpoint.read(CLUSTER_KETTLE, [
+                'calibrationState',
+                'calibrationPoints',
+                'ambientReference',
+                'boilReference',
+                'waterReady',
+                'heatingState',
+            ]);
+        }
     },
     meta: {
-        multiEndpoint: false,
+        // Per-kettle keys on a device with several kettle endpoints (see kettleEndpointMap)
+        multiEndpoint: true,
+        multiEndpointSkip: ['diagnostics'],
     },
 };
 